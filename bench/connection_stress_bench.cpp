@@ -0,0 +1,173 @@
+#include "bc/soup/server/acceptor.h"
+#include "bc/soup/server/handler.h"
+#include "bc/soup/server/server.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc;
+
+namespace {
+
+class Acceptor final : public soup::server::Acceptor_handler {
+public:
+  void listen_setup_failure(asio::error_code ec, std::string_view) override {
+    error = ec;
+  }
+
+  void listen_setup_success(const asio::ip::tcp::endpoint& ep) override {
+    endpoint = ep;
+  }
+
+  void accept_failure(asio::error_code ec) override { error = ec; }
+
+  void accept_success(const asio::ip::tcp::endpoint&,
+                      const asio::ip::tcp::endpoint&) override {
+    ++accepted;
+  }
+
+  void login_request(const soup::Login_request_packet&) override {}
+
+  void login_failure(soup::Login_reject_reason) override {}
+
+  void debug(std::string_view) override {}
+
+  void transport_error(asio::error_code, std::string_view) override {}
+
+  void protocol_violation(soup::Packet_error) override {}
+
+  void disconnect(soup::Disconnect_reason) override { ++disconnected; }
+
+  std::optional<asio::ip::tcp::endpoint> endpoint;
+  asio::error_code error;
+  std::size_t accepted = 0;
+  std::size_t disconnected = 0;
+};
+
+template <typename Predicate>
+void run_until(asio::io_context& io_context, Predicate&& done) {
+  while (!done())
+    io_context.run_one();
+}
+
+// Each connection holds a descriptor on both ends within this process.
+bool raise_descriptor_limit(std::size_t connections) {
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) == -1)
+    return false;
+  constexpr rlim_t spare = 64;
+  const rlim_t needed = (2 * connections) + spare;
+  if (limit.rlim_cur >= needed)
+    return true;
+  if (limit.rlim_max < needed)
+    return false;
+  limit.rlim_cur = needed;
+  return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+// Opens the given number of connections to a loopback server, waits for the
+// server to accept all of them, then closes them all at once and waits for
+// the server to tear every session down. When disconnect_only is set only
+// the mass disconnect is timed.
+void connect_disconnect(benchmark::State& state, bool disconnect_only) {
+  const auto connections = static_cast<std::size_t>(state.range(0));
+  if (!raise_descriptor_limit(connections)) {
+    state.SkipWithError("descriptor limit too low");
+    return;
+  }
+
+  asio::io_context io_context(1);
+  soup::server::Server server(io_context.get_executor());
+  Acceptor handler;
+  const asio::ip::tcp::endpoint listen_endpoint(
+      asio::ip::address_v4::loopback(), 0);
+  if (!server.add_acceptor(listen_endpoint, handler)) {
+    state.SkipWithError("add_acceptor failed");
+    return;
+  }
+  if (server.start()) {
+    state.SkipWithError("start failed");
+    return;
+  }
+  run_until(io_context, [&] { return handler.endpoint || handler.error; });
+  if (!handler.endpoint) {
+    state.SkipWithError("listen setup failed");
+    return;
+  }
+
+  std::vector<asio::ip::tcp::socket> sockets;
+  sockets.reserve(connections);
+  for (auto _ : state) {
+    if (disconnect_only)
+      state.PauseTiming();
+    handler.accepted = 0;
+    handler.disconnected = 0;
+    std::size_t connected = 0;
+    std::size_t failed = 0;
+    for (std::size_t i = 0; i < connections; ++i) {
+      auto& socket = sockets.emplace_back(io_context);
+      socket.async_connect(*handler.endpoint,
+                           [&connected, &failed](asio::error_code ec) {
+                             if (ec)
+                               ++failed;
+                             else
+                               ++connected;
+                           });
+    }
+    run_until(io_context, [&] {
+      return failed != 0 || handler.error ||
+             (connected == connections && handler.accepted == connections);
+    });
+    if (failed != 0 || handler.error) {
+      state.SkipWithError("connect failed");
+      break;
+    }
+    if (disconnect_only)
+      state.ResumeTiming();
+
+    for (auto& socket : sockets) {
+      asio::error_code ec;
+      socket.close(ec);
+    }
+    run_until(io_context,
+              [&] { return handler.disconnected == connections; });
+    sockets.clear();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<benchmark::IterationCount>(connections));
+
+  server.stop();
+  io_context.poll();
+}
+
+void BM_connect_disconnect(benchmark::State& state) {
+  connect_disconnect(state, false);
+}
+
+void BM_mass_disconnect(benchmark::State& state) {
+  connect_disconnect(state, true);
+}
+
+} // namespace
+
+// NOLINTBEGIN(*-avoid-magic-numbers): Benchmark arguments
+BENCHMARK(BM_connect_disconnect)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Arg(5000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_mass_disconnect)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Arg(5000)
+    ->Unit(benchmark::kMillisecond);
+// NOLINTEND(*-avoid-magic-numbers)
@@ -0,0 +1,249 @@
+#include "bc/soup/file_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc::soup;
+
+namespace {
+
+const std::string filename =
+    (std::filesystem::temp_directory_path() / "bc_soup_bench_store").string();
+
+bool populate(std::size_t count, std::size_t size, bool checksums = false) {
+  std::filesystem::remove(filename);
+  File_store store(filename);
+  store.set_checksums(checksums);
+  if (store.open())
+    return false;
+  const std::vector<std::byte> message(size);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (store.add(message.data(), message.size()))
+      return false;
+  }
+  return !store.close();
+}
+
+// The argument is the message size in bytes.
+void BM_File_store_add(benchmark::State& state) {
+  std::filesystem::remove(filename);
+  File_store store(filename);
+  if (store.open()) {
+    state.SkipWithError("open failed");
+    return;
+  }
+  const auto size = static_cast<std::size_t>(state.range(0));
+  const std::vector<std::byte> message(size);
+  for (auto _ : state) {
+    if (store.add(message.data(), message.size())) {
+      state.SkipWithError("add failed");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  (void)store.close();
+  std::filesystem::remove(filename);
+}
+
+// The arguments are the message size in bytes and whether the store uses
+// direct I/O. Each add() is timed under sustained load, for the percentiles
+// of its latency, where writeback stalls show.
+void BM_File_store_add_latency(benchmark::State& state) {
+  std::filesystem::remove(filename);
+  File_store store(filename);
+  store.set_direct_io(state.range(1) != 0);
+  if (store.open()) {
+    state.SkipWithError("open failed");
+    return;
+  }
+  const auto size = static_cast<std::size_t>(state.range(0));
+  const std::vector<std::byte> message(size);
+  std::vector<std::chrono::nanoseconds> latencies;
+  latencies.reserve(static_cast<std::size_t>(state.max_iterations));
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto ec = store.add(message.data(), message.size());
+    latencies.push_back(std::chrono::steady_clock::now() - start);
+    if (ec) {
+      state.SkipWithError("add failed");
+      break;
+    }
+  }
+  std::ranges::sort(latencies);
+  auto percentile = [&latencies](double p) {
+    const auto i = static_cast<std::size_t>(
+        p * static_cast<double>(latencies.size() - 1));
+    return static_cast<double>(latencies[i].count());
+  };
+  if (!latencies.empty()) {
+    // NOLINTBEGIN(*-avoid-magic-numbers): Percentiles
+    state.counters["p50_ns"] = percentile(0.5);
+    state.counters["p99_ns"] = percentile(0.99);
+    state.counters["p99.9_ns"] = percentile(0.999);
+    state.counters["max_ns"] = percentile(1.0);
+    // NOLINTEND(*-avoid-magic-numbers)
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  (void)store.close();
+  std::filesystem::remove(filename);
+}
+
+// The arguments are the number of messages per get and the message size in
+// bytes, read from the middle of a store of fixed length.
+void BM_File_store_get(benchmark::State& state) {
+  constexpr std::size_t store_size = 10'000;
+  const auto count = static_cast<std::size_t>(state.range(0));
+  if (!populate(store_size, static_cast<std::size_t>(state.range(1)))) {
+    state.SkipWithError("populate failed");
+    return;
+  }
+  File_store store(filename);
+  if (store.open()) {
+    state.SkipWithError("open failed");
+    return;
+  }
+  const auto first = (store_size - count) / 2 + 1;
+  std::vector<Message> messages;
+  messages.reserve(count);
+  for (auto _ : state) {
+    messages.clear();
+    if (store.get(first, first + count - 1, messages)) {
+      state.SkipWithError("get failed");
+      break;
+    }
+    benchmark::DoNotOptimize(messages.data());
+  }
+  const auto items = state.iterations() * state.range(0);
+  state.SetItemsProcessed(items);
+  state.SetBytesProcessed(items * state.range(1));
+  (void)store.close();
+  std::filesystem::remove(filename);
+}
+
+// The arguments are the number of messages per get and whether the tail
+// cache holds them: a client logging in that many messages behind. The
+// messages are 64 bytes, added after opening, which the cache requires.
+void BM_File_store_get_tail(benchmark::State& state) {
+  constexpr std::size_t store_size = 10'000;
+  constexpr std::size_t message_size = 64;
+  const auto count = static_cast<std::size_t>(state.range(0));
+  std::filesystem::remove(filename);
+  File_store store(filename);
+  if (state.range(1) != 0)
+    store.set_cache_limits(store_size, store_size * message_size);
+  if (store.open()) {
+    state.SkipWithError("open failed");
+    return;
+  }
+  const std::vector<std::byte> message(message_size);
+  for (std::size_t i = 0; i < store_size; ++i) {
+    if (store.add(message.data(), message.size())) {
+      state.SkipWithError("add failed");
+      return;
+    }
+  }
+  const auto first = store_size - count + 1;
+  std::vector<Frame> frames;
+  frames.reserve(count);
+  for (auto _ : state) {
+    frames.clear();
+    if (store.get(first, store_size, frames)) {
+      state.SkipWithError("get failed");
+      break;
+    }
+    benchmark::DoNotOptimize(frames.data());
+  }
+  const auto items = state.iterations() * state.range(0);
+  state.SetItemsProcessed(items);
+  state.SetBytesProcessed(items * static_cast<std::int64_t>(message_size));
+  (void)store.close();
+  std::filesystem::remove(filename);
+}
+
+// The argument is the byte budget per batch of a cursor replaying a whole
+// store of 64-byte messages, which bounds the memory the replay holds.
+void BM_File_store_cursor(benchmark::State& state) {
+  constexpr std::size_t store_size = 10'000;
+  constexpr std::size_t message_size = 64;
+  if (!populate(store_size, message_size)) {
+    state.SkipWithError("populate failed");
+    return;
+  }
+  File_store store(filename);
+  if (store.open()) {
+    state.SkipWithError("open failed");
+    return;
+  }
+  const auto max_bytes = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    auto cursor = store.cursor(1);
+    while (cursor.next_sequence_number() <= store_size) {
+      if (cursor.read(store_size, max_bytes)) {
+        state.SkipWithError("read failed");
+        break;
+      }
+      benchmark::DoNotOptimize(cursor.messages().data());
+    }
+  }
+  const auto items = state.iterations() * static_cast<std::int64_t>(store_size);
+  state.SetItemsProcessed(items);
+  state.SetBytesProcessed(items * static_cast<std::int64_t>(message_size));
+  (void)store.close();
+  std::filesystem::remove(filename);
+}
+
+// The arguments are the number of messages already in the store, all of
+// which are scanned to build the offsets index on open, and whether their
+// checksums are checked too.
+void BM_File_store_open(benchmark::State& state) {
+  constexpr std::size_t message_size = 64;
+  const bool checksums = state.range(1) != 0;
+  if (!populate(static_cast<std::size_t>(state.range(0)), message_size,
+                checksums)) {
+    state.SkipWithError("populate failed");
+    return;
+  }
+  for (auto _ : state) {
+    File_store store(filename);
+    store.set_checksums(checksums);
+    if (store.open()) {
+      state.SkipWithError("open failed");
+      break;
+    }
+    benchmark::DoNotOptimize(store.next_sequence_number());
+    (void)store.close();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(std::filesystem::file_size(filename)) *
+      state.iterations());
+  std::filesystem::remove(filename);
+}
+
+} // namespace
+
+// NOLINTBEGIN(*-avoid-magic-numbers): Benchmark arguments
+BENCHMARK(BM_File_store_add)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(BM_File_store_add_latency)
+    ->ArgsProduct({{128}, {0, 1}})
+    ->Iterations(1'000'000);
+BENCHMARK(BM_File_store_get)
+    ->ArgsProduct({{1, 16, 256, 4096}, {8, 64, 512, 4096}});
+BENCHMARK(BM_File_store_get_tail)->ArgsProduct({{1, 64, 4096}, {0, 1}});
+BENCHMARK(BM_File_store_cursor)
+    ->RangeMultiplier(16)
+    ->Range(4096, 1 << 20)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_File_store_open)
+    ->ArgsProduct({{10, 1000, 100'000, 1'000'000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+// NOLINTEND(*-avoid-magic-numbers)
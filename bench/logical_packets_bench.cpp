@@ -0,0 +1,78 @@
+#include "bc/soup/logical_packets.h"
+
+#include <array>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc::soup;
+
+namespace {
+
+template <typename Packet>
+void write_read(benchmark::State& state, const Packet& packet) {
+  std::array<char, Packet::payload_size> b = {};
+  for (auto _ : state) {
+    write(packet, b.data());
+    benchmark::DoNotOptimize(b);
+    Packet p;
+    read(p, b.data());
+    benchmark::DoNotOptimize(p);
+  }
+}
+
+template <typename Packet>
+void write_only(benchmark::State& state, const Packet& packet) {
+  std::array<char, Packet::payload_size> b = {};
+  for (auto _ : state) {
+    write(packet, b.data());
+    benchmark::DoNotOptimize(b);
+  }
+}
+
+template <typename Packet>
+void read_only(benchmark::State& state, const Packet& packet) {
+  std::array<char, Packet::payload_size> b = {};
+  write(packet, b.data());
+  for (auto _ : state) {
+    Packet p;
+    benchmark::DoNotOptimize(b);
+    read(p, b.data());
+    benchmark::DoNotOptimize(p);
+  }
+}
+
+// NOLINTBEGIN(*-avoid-magic-numbers): Benchmark values
+const Login_accepted_packet login_accepted("abcdefghij", 1234567890);
+const Login_rejected_packet
+    login_rejected(Login_rejected_reason::not_authorized);
+const Login_request_packet login_request("abcdef", "abcdefghij", "abcdefghij",
+                                         1234567890);
+// NOLINTEND(*-avoid-magic-numbers)
+
+void BM_Login_accepted_packet_write(benchmark::State& state) {
+  write_only(state, login_accepted);
+}
+
+void BM_Login_accepted_packet_read(benchmark::State& state) {
+  read_only(state, login_accepted);
+}
+
+void BM_Login_rejected_packet_write_read(benchmark::State& state) {
+  write_read(state, login_rejected);
+}
+
+void BM_Login_request_packet_write(benchmark::State& state) {
+  write_only(state, login_request);
+}
+
+void BM_Login_request_packet_read(benchmark::State& state) {
+  read_only(state, login_request);
+}
+
+} // namespace
+
+BENCHMARK(BM_Login_accepted_packet_write);
+BENCHMARK(BM_Login_accepted_packet_read);
+BENCHMARK(BM_Login_rejected_packet_write_read);
+BENCHMARK(BM_Login_request_packet_write);
+BENCHMARK(BM_Login_request_packet_read);
@@ -0,0 +1,447 @@
+#include "bc_soup_config.h"
+#include "latency_recorder.h"
+#include "loopback.h"
+#include "option_convert.h"
+#include "option_error.h"
+
+#include "bc/soup/client/spin_runner.h"
+#include "bc/soup/endpoint.h"
+#include "bc/soup/metrics.h"
+
+#include <asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Metrics_snapshot = bc::soup::Metrics_registry::Snapshot;
+
+enum class Mode {
+  both,
+  server,
+  client
+};
+
+struct Config {
+  Mode mode = Mode::both;
+  std::string address = "127.0.0.1";
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Default value
+  unsigned short port = 5051;
+  bool port_set = false;
+  std::size_t sessions = 1;
+  Loopback_options options;
+};
+
+double to_seconds(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+double to_microseconds(std::chrono::nanoseconds d) {
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+void report_receive(std::string_view side, std::vector<Receive_stats*> stats) {
+  Receive_stats total;
+  bool first = true;
+  for (auto* s : stats) {
+    if (s->received == 0)
+      continue;
+    total.received += s->received;
+    total.bytes += s->bytes;
+    total.latency.merge(s->latency);
+    if (first) {
+      total.first_receive = s->first_receive;
+      total.last_receive = s->last_receive;
+    } else {
+      total.first_receive = std::min(total.first_receive, s->first_receive);
+      total.last_receive = std::max(total.last_receive, s->last_receive);
+    }
+    first = false;
+  }
+  const auto seconds = to_seconds(total.last_receive - total.first_receive);
+  const auto rate = seconds > 0 ? static_cast<double>(total.received) / seconds
+                                : 0.0;
+  const auto throughput =
+      seconds > 0 ? static_cast<double>(total.bytes) / seconds / 1e6 : 0.0;
+  const auto latency = total.latency.summarize();
+  std::println("{} received: messages = {}, bytes = {}, seconds = {:.3f}",
+               side, total.received, total.bytes, seconds);
+  std::println("{} throughput: msgs/s = {:.0f}, MB/s = {:.2f}", side, rate,
+               throughput);
+  std::println("{} latency (us): min = {:.2f}, p50 = {:.2f}, p99 = {:.2f}, "
+               "p99.9 = {:.2f}, max = {:.2f}",
+               side, to_microseconds(latency.min), to_microseconds(latency.p50),
+               to_microseconds(latency.p99), to_microseconds(latency.p999),
+               to_microseconds(latency.max));
+}
+
+void report_send(std::string_view side, std::vector<Pump*> pumps) {
+  std::size_t sent = 0;
+  std::chrono::steady_clock::time_point first_send;
+  std::chrono::steady_clock::time_point last_send;
+  bool first = true;
+  for (auto* p : pumps) {
+    if (p->sent() == 0)
+      continue;
+    sent += p->sent();
+    first_send =
+        first ? p->first_send() : std::min(first_send, p->first_send());
+    last_send = first ? p->last_send() : std::max(last_send, p->last_send());
+    first = false;
+  }
+  const auto seconds = to_seconds(last_send - first_send);
+  const auto rate = seconds > 0 ? static_cast<double>(sent) / seconds : 0.0;
+  std::println("{} sent: messages = {}, seconds = {:.3f}, msgs/s = {:.0f}",
+               side, sent, seconds, rate);
+}
+
+void report_metrics(std::string_view side,
+                    const std::vector<Metrics_snapshot>& snapshots) {
+  bc::soup::Connection_metrics::Snapshot total;
+  for (const auto& snapshot : snapshots)
+    total.merge(snapshot.total);
+  const auto& latency = total.write_latency;
+  std::println("{} writes: packets = {}, queue high-water mark = {}, "
+               "max receive gap (us) = {:.2f}",
+               side, total.sent().packets, total.write_queue_high_water_mark,
+               to_microseconds(total.max_receive_gap));
+  // NOLINTBEGIN(*-avoid-magic-numbers): Percentiles
+  std::println("{} write latency (us): p50 = {:.2f}, p99 = {:.2f}, "
+               "p99.9 = {:.2f}, max = {:.2f}",
+               side, to_microseconds(latency.percentile(0.50)),
+               to_microseconds(latency.percentile(0.99)),
+               to_microseconds(latency.percentile(0.999)),
+               to_microseconds(latency.percentile(1.0)));
+  // NOLINTEND(*-avoid-magic-numbers)
+}
+
+std::vector<Metrics_snapshot>
+metrics(std::vector<std::unique_ptr<Loopback_client>>& clients) {
+  std::vector<Metrics_snapshot> snapshots;
+  for (auto& client : clients)
+    snapshots.push_back(client->metrics());
+  return snapshots;
+}
+
+void wait_for(std::atomic<std::size_t>& remaining) {
+  while (remaining.load() != 0)
+    std::this_thread::sleep_for(1ms);
+}
+
+asio::ip::tcp::endpoint make_endpoint(const Config& config,
+                                      unsigned short port) {
+  return {asio::ip::make_address(config.address), port};
+}
+
+std::vector<Receive_stats*> receivers(Loopback_server& server) {
+  std::vector<Receive_stats*> stats;
+  for (std::size_t i = 0; i < server.size(); ++i)
+    stats.push_back(&server.port(i).stats());
+  return stats;
+}
+
+std::vector<Receive_stats*>
+receivers(std::vector<std::unique_ptr<Loopback_client>>& clients) {
+  std::vector<Receive_stats*> stats;
+  for (auto& client : clients)
+    stats.push_back(&client->stats());
+  return stats;
+}
+
+std::vector<Pump*> senders(Loopback_server& server) {
+  std::vector<Pump*> pumps;
+  for (std::size_t i = 0; i < server.size(); ++i)
+    pumps.push_back(&server.port(i).pump());
+  return pumps;
+}
+
+std::vector<Pump*>
+senders(std::vector<std::unique_ptr<Loopback_client>>& clients) {
+  std::vector<Pump*> pumps;
+  for (auto& client : clients)
+    pumps.push_back(&client->pump());
+  return pumps;
+}
+
+std::vector<std::unique_ptr<Loopback_client>>
+make_clients(asio::io_context& io_context, const bc::soup::Endpoint& endpoint,
+             const Config& config, std::atomic<std::size_t>& remaining) {
+  std::vector<std::unique_ptr<Loopback_client>> clients;
+  for (std::size_t i = 0; i < config.sessions; ++i) {
+    auto& client = clients.emplace_back(std::make_unique<Loopback_client>(
+        io_context.get_executor(), endpoint, i, config.options));
+    client->set_done_handler([&remaining] { --remaining; });
+    if (const auto ec = client->start())
+      throw std::system_error(ec, "start");
+  }
+  return clients;
+}
+
+void report(const Config& config, Loopback_server* server,
+            std::vector<std::unique_ptr<Loopback_client>>* clients) {
+  const bool sequenced = config.options.traffic == Traffic::sequenced;
+  if (server) {
+    if (sequenced)
+      report_send("server", senders(*server));
+    else
+      report_receive("server", receivers(*server));
+    report_metrics("server", {server->metrics()});
+  }
+  if (clients) {
+    if (sequenced)
+      report_receive("client", receivers(*clients));
+    else
+      report_send("client", senders(*clients));
+    report_metrics("client", metrics(*clients));
+  }
+}
+
+void run_both(const Config& config) {
+  asio::io_context server_io(1);
+  asio::io_context client_io(1);
+  std::atomic<std::size_t> remaining = 2 * config.sessions;
+
+  const auto port = config.port_set ? config.port : 0;
+  Loopback_server server(server_io.get_executor(), make_endpoint(config, port),
+                         config.sessions, config.options);
+  for (std::size_t i = 0; i < server.size(); ++i)
+    server.port(i).set_done_handler([&remaining] { --remaining; });
+  if (const auto ec = server.start())
+    throw std::system_error(ec, "start");
+  while (!server.endpoint() && !server.error())
+    server_io.run_one();
+  if (!server.endpoint()) {
+    std::println("server: {}", *server.error());
+    return;
+  }
+
+  auto clients =
+      make_clients(client_io, *server.endpoint(), config, remaining);
+
+  bc::soup::client::Spin_runner runner(client_io);
+  for (auto& client : clients)
+    runner.add(client->client());
+
+  auto server_guard = asio::make_work_guard(server_io);
+  auto client_guard = asio::make_work_guard(client_io);
+  std::thread server_thread([&server_io] { server_io.run(); });
+  std::thread client_thread([&client_io, &runner, &config] {
+    if (config.options.polled_reads)
+      runner.run();
+    else
+      client_io.run();
+  });
+
+  wait_for(remaining);
+
+  runner.stop();
+  asio::post(server_io, [&server] { server.stop(); });
+  server_guard.reset();
+  client_guard.reset();
+  server_thread.join();
+  client_thread.join();
+
+  report(config, &server, &clients);
+}
+
+void run_server(const Config& config) {
+  asio::io_context io_context(1);
+  std::atomic<std::size_t> remaining = config.sessions;
+
+  Loopback_server server(io_context.get_executor(),
+                         make_endpoint(config, config.port), config.sessions,
+                         config.options);
+  for (std::size_t i = 0; i < server.size(); ++i)
+    server.port(i).set_done_handler([&remaining] { --remaining; });
+  if (const auto ec = server.start())
+    throw std::system_error(ec, "start");
+  while (!server.endpoint() && !server.error())
+    io_context.run_one();
+  if (!server.endpoint()) {
+    std::println("server: {}", *server.error());
+    return;
+  }
+  const auto endpoint = bc::soup::to_tcp(*server.endpoint());
+  std::println("listening: endpoint = {}:{}", endpoint.address().to_string(),
+               endpoint.port());
+
+  while (remaining.load() != 0)
+    io_context.run_one();
+  server.stop();
+  io_context.poll();
+
+  report(config, &server, nullptr);
+}
+
+void run_client(const Config& config) {
+  asio::io_context io_context(1);
+  std::atomic<std::size_t> remaining = config.sessions;
+
+  auto clients = make_clients(io_context, make_endpoint(config, config.port),
+                              config, remaining);
+  if (config.options.polled_reads) {
+    bc::soup::client::Spin_runner runner(io_context);
+    for (auto& client : clients)
+      runner.add(client->client());
+    while (remaining.load() != 0)
+      runner.poll_once();
+  } else {
+    while (remaining.load() != 0)
+      io_context.run_one();
+  }
+  io_context.restart();
+  io_context.poll();
+
+  report(config, nullptr, &clients);
+}
+
+void display_usage() {
+  std::print("usage: bc_soup_loopback [options]\n"
+             "options:\n"
+             "  -b  client receives sequenced data in batches\n"
+             "  -c  messages per session [1000000]\n"
+             "  -e  endpoint [127.0.0.1:0 with -m both, else 127.0.0.1:5051]\n"
+             "  -h  help\n"
+             "  -m  mode: both, server or client [both]\n"
+             "  -n  sessions [1]\n"
+             "  -p  client busy-polls its sockets on its thread\n"
+             "  -r  messages per second per session, 0 unpaced [0]\n"
+             "  -s  message size in bytes, at least 8 [64]\n"
+             "  -t  traffic: sequenced or unsequenced [sequenced]\n"
+             "  -v  version\n"
+             "  -w  write packets limit [100]\n");
+}
+
+void display_version() {
+  std::println("version {}.{}", bc_soup_VERSION_MAJOR, bc_soup_VERSION_MINOR);
+}
+
+std::size_t to_size(std::string_view arg, int opt) {
+  const long i = to_long(arg, opt);
+  if (i < 0)
+    throw Invalid_argument(opt, "negative");
+  return static_cast<std::size_t>(i);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Config config;
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Default value
+  config.options.message_count = 1'000'000;
+
+  try {
+    int opt = 0;
+    while ((opt = getopt(argc, argv, ":bc:e:hm:n:pr:s:t:vw:")) != -1) {
+      switch (opt) {
+      case 'b':
+        config.options.batched = true;
+        break;
+      case 'c':
+        config.options.message_count = to_size(optarg, opt);
+        break;
+      case 'e': {
+        const auto endpoint = to_endpoint(optarg, opt);
+        if (!endpoint.address.empty())
+          config.address = endpoint.address;
+        if (endpoint.port > 0xffff)
+          throw Invalid_argument(opt, "out of range");
+        config.port = static_cast<unsigned short>(endpoint.port);
+        config.port_set = true;
+        break;
+      }
+      case 'h':
+        display_usage();
+        return EXIT_SUCCESS;
+      case 'm': {
+        const std::string_view mode = optarg;
+        if (mode == "both")
+          config.mode = Mode::both;
+        else if (mode == "server")
+          config.mode = Mode::server;
+        else if (mode == "client")
+          config.mode = Mode::client;
+        else
+          throw Invalid_argument(opt);
+        break;
+      }
+      case 'n':
+        config.sessions = to_size(optarg, opt);
+        break;
+      case 'p':
+        config.options.polled_reads = true;
+        break;
+      case 'r':
+        config.options.rate = to_size(optarg, opt);
+        break;
+      case 's':
+        config.options.message_size = to_size(optarg, opt);
+        if (config.options.message_size < timestamp_size ||
+            config.options.message_size > 0xffff - 1)
+          throw Invalid_argument(opt, "out of range");
+        break;
+      case 't': {
+        const std::string_view traffic = optarg;
+        if (traffic == "sequenced")
+          config.options.traffic = Traffic::sequenced;
+        else if (traffic == "unsequenced")
+          config.options.traffic = Traffic::unsequenced;
+        else
+          throw Invalid_argument(opt);
+        break;
+      }
+      case 'v':
+        display_version();
+        return EXIT_SUCCESS;
+      case 'w':
+        config.options.write_packets_limit = to_size(optarg, opt);
+        break;
+      case ':':
+        throw Missing_argument(optopt);
+      case '?':
+      default:
+        throw Illegal_option(optopt);
+      }
+    }
+    if (config.sessions == 0 || config.options.message_count == 0)
+      throw Invalid_argument(config.sessions == 0 ? 'n' : 'c', "zero");
+  } catch (const Option_error& e) {
+    std::println("{}", e.what());
+    return EXIT_FAILURE;
+  }
+
+  try {
+    switch (config.mode) {
+    case Mode::both:
+      run_both(config);
+      break;
+    case Mode::server:
+      run_server(config);
+      break;
+    case Mode::client:
+      run_client(config);
+      break;
+    }
+  } catch (const std::system_error& e) {
+    std::println("system error: {}:{} {}", e.code().category().name(),
+                 e.code().value(), e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+#include "latency_recorder.h"
+#include "loopback.h"
+
+#include "bc/soup/endpoint.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+template <typename Predicate>
+void run_until(asio::io_context& io_context, Predicate&& done) {
+  while (!done())
+    io_context.run_one();
+}
+
+// The server leaves the socket file in place, so it is removed before and
+// after each run.
+class Unix_socket_file {
+public:
+  Unix_socket_file()
+      : path_("/tmp/bc_soup_loopback_bench." + std::to_string(getpid())) {
+    std::remove(path_.c_str());
+  }
+  ~Unix_socket_file() { std::remove(path_.c_str()); }
+
+  Unix_socket_file(const Unix_socket_file&) = delete;
+  Unix_socket_file& operator=(const Unix_socket_file&) = delete;
+
+  Unix_socket_file(Unix_socket_file&&) = delete;
+  Unix_socket_file& operator=(Unix_socket_file&&) = delete;
+
+  asio::local::stream_protocol::endpoint endpoint() const { return {path_}; }
+
+private:
+  std::string path_;
+};
+
+// Server and client share one io_context so each iteration measures the full
+// send, frame, receive and dispatch path for a batch of messages on a single
+// core.
+void loopback(benchmark::State& state, const bc::soup::Endpoint& endpoint,
+              Traffic traffic, bool batched = false) {
+  constexpr std::size_t batch = 1000;
+
+  Loopback_options options;
+  options.traffic = traffic;
+  options.batched = batched;
+  options.message_size = static_cast<std::size_t>(state.range(0));
+
+  asio::io_context io_context(1);
+  Loopback_server server(io_context.get_executor(), endpoint, 1, options);
+  if (server.start()) {
+    state.SkipWithError("server start failed");
+    return;
+  }
+  run_until(io_context, [&] { return server.endpoint() || server.error(); });
+  if (!server.endpoint()) {
+    state.SkipWithError("listen setup failed");
+    return;
+  }
+
+  Loopback_client client(io_context.get_executor(), *server.endpoint(), 0,
+                         options);
+  if (client.start()) {
+    state.SkipWithError("client start failed");
+    return;
+  }
+  run_until(io_context, [&] { return client.logged_in() || client.error(); });
+  if (!client.logged_in()) {
+    state.SkipWithError("login failed");
+    return;
+  }
+
+  const bool sequenced = traffic == Traffic::sequenced;
+  auto& pump = sequenced ? server.port(0).pump() : client.pump();
+  auto& stats = sequenced ? client.stats() : server.port(0).stats();
+  for (auto _ : state) {
+    const auto target = stats.received + batch;
+    pump.add(batch);
+    run_until(io_context,
+              [&] { return stats.received >= target || client.error(); });
+    if (client.error()) {
+      state.SkipWithError("transport failed");
+      break;
+    }
+  }
+
+  const auto messages =
+      state.iterations() * static_cast<benchmark::IterationCount>(batch);
+  state.SetItemsProcessed(messages);
+  state.SetBytesProcessed(messages * state.range(0));
+  const auto latency = stats.latency.summarize();
+  state.counters["p50_ns"] = static_cast<double>(latency.p50.count());
+  state.counters["p99_ns"] = static_cast<double>(latency.p99.count());
+  state.counters["p999_ns"] = static_cast<double>(latency.p999.count());
+  state.counters["max_ns"] = static_cast<double>(latency.max.count());
+
+  client.stop();
+  server.stop();
+  io_context.poll();
+}
+
+const asio::ip::tcp::endpoint tcp_endpoint(asio::ip::address_v4::loopback(),
+                                           0);
+
+void BM_loopback_sequenced(benchmark::State& state) {
+  loopback(state, tcp_endpoint, Traffic::sequenced);
+}
+
+void BM_loopback_sequenced_batched(benchmark::State& state) {
+  loopback(state, tcp_endpoint, Traffic::sequenced, true);
+}
+
+void BM_loopback_unsequenced(benchmark::State& state) {
+  loopback(state, tcp_endpoint, Traffic::unsequenced);
+}
+
+void BM_loopback_sequenced_unix(benchmark::State& state) {
+  const Unix_socket_file file;
+  loopback(state, file.endpoint(), Traffic::sequenced);
+}
+
+void BM_loopback_unsequenced_unix(benchmark::State& state) {
+  const Unix_socket_file file;
+  loopback(state, file.endpoint(), Traffic::unsequenced);
+}
+
+} // namespace
+
+// NOLINTBEGIN(*-avoid-magic-numbers): Benchmark arguments
+BENCHMARK(BM_loopback_sequenced)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_loopback_sequenced_batched)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_loopback_unsequenced)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_loopback_sequenced_unix)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_loopback_unsequenced_unix)->RangeMultiplier(8)->Range(8, 32768);
+// NOLINTEND(*-avoid-magic-numbers)
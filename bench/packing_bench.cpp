@@ -0,0 +1,121 @@
+#include "bc/soup/packing.h"
+
+#include "bc/soup/constants.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc::soup;
+
+namespace {
+
+template <typename Integral>
+void BM_pack_integral(benchmark::State& state) {
+  std::array<unsigned char, sizeof(Integral)> b = {};
+  Integral i = 0;
+  for (auto _ : state) {
+    pack(i, b.data());
+    benchmark::DoNotOptimize(b);
+    ++i;
+  }
+}
+
+template <typename Integral>
+void BM_unpack_integral(benchmark::State& state) {
+  std::array<unsigned char, sizeof(Integral)> b = {};
+  pack(static_cast<Integral>(0x12), b.data());
+  for (auto _ : state) {
+    Integral i = 0;
+    benchmark::DoNotOptimize(b);
+    unpack(i, b.data());
+    benchmark::DoNotOptimize(i);
+  }
+}
+
+void BM_pack_username(benchmark::State& state) {
+  std::array<char, username_length> b = {};
+  const std::string username(static_cast<std::size_t>(state.range(0)), 'a');
+  for (auto _ : state) {
+    pack_username(username, b.data());
+    benchmark::DoNotOptimize(b);
+  }
+}
+
+void BM_unpack_username(benchmark::State& state) {
+  std::array<char, username_length> b = {};
+  const std::string username(static_cast<std::size_t>(state.range(0)), 'a');
+  pack_username(username, b.data());
+  std::string s;
+  for (auto _ : state) {
+    s.clear();
+    unpack_username(s, b.data());
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+void BM_pack_session(benchmark::State& state) {
+  std::array<char, session_length> b = {};
+  const std::string session(static_cast<std::size_t>(state.range(0)), 'a');
+  for (auto _ : state) {
+    pack_session(session, b.data());
+    benchmark::DoNotOptimize(b);
+  }
+}
+
+void BM_unpack_session(benchmark::State& state) {
+  std::array<char, session_length> b = {};
+  const std::string session(static_cast<std::size_t>(state.range(0)), 'a');
+  pack_session(session, b.data());
+  std::string s;
+  for (auto _ : state) {
+    s.clear();
+    unpack_session(s, b.data());
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+// The argument is the sequence number; the number of digits drives the cost
+// of the numeric encoding.
+void BM_pack_sequence_number(benchmark::State& state) {
+  std::array<char, sequence_number_length> b = {};
+  const auto n = static_cast<std::uint64_t>(state.range(0));
+  for (auto _ : state) {
+    pack_sequence_number(n, b.data());
+    benchmark::DoNotOptimize(b);
+  }
+}
+
+void BM_unpack_sequence_number(benchmark::State& state) {
+  std::array<char, sequence_number_length> b = {};
+  pack_sequence_number(static_cast<std::uint64_t>(state.range(0)), b.data());
+  for (auto _ : state) {
+    std::uint64_t n = 0;
+    benchmark::DoNotOptimize(b);
+    unpack_sequence_number(n, b.data());
+    benchmark::DoNotOptimize(n);
+  }
+}
+
+} // namespace
+
+BENCHMARK(BM_pack_integral<std::uint16_t>);
+BENCHMARK(BM_pack_integral<std::uint32_t>);
+BENCHMARK(BM_unpack_integral<std::uint16_t>);
+BENCHMARK(BM_unpack_integral<std::uint32_t>);
+// NOLINTBEGIN(*-avoid-magic-numbers): Benchmark arguments
+BENCHMARK(BM_pack_username)->Arg(1)->Arg(username_length);
+BENCHMARK(BM_unpack_username)->Arg(1)->Arg(username_length);
+BENCHMARK(BM_pack_session)->Arg(1)->Arg(session_length);
+BENCHMARK(BM_unpack_session)->Arg(1)->Arg(session_length);
+BENCHMARK(BM_pack_sequence_number)
+    ->Arg(1)
+    ->Arg(1'000'000)
+    ->Arg(1'000'000'000'000);
+BENCHMARK(BM_unpack_sequence_number)
+    ->Arg(1)
+    ->Arg(1'000'000)
+    ->Arg(1'000'000'000'000);
+// NOLINTEND(*-avoid-magic-numbers)
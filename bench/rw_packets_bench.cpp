@@ -0,0 +1,68 @@
+#include "bc/soup/rw_packets.h"
+
+#include "bc/soup/constants.h"
+#include "bc/soup/packing.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc::soup;
+
+namespace {
+
+// The argument is the payload size in bytes.
+
+void BM_Read_packet_resize_payload(benchmark::State& state) {
+  const auto payload_size = static_cast<std::uint16_t>(state.range(0));
+  Read_packet packet;
+  pack(static_cast<std::uint16_t>(packet_type_length + payload_size),
+       packet.header_data());
+  for (auto _ : state) {
+    const auto result = packet.resize_payload();
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(packet.payload_data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Write_packet_construct(benchmark::State& state) {
+  const auto payload_size = static_cast<std::uint16_t>(state.range(0));
+  const std::vector<std::byte> payload(payload_size);
+  for (auto _ : state) {
+    const Write_packet packet('S', payload.data(), payload_size);
+    benchmark::DoNotOptimize(packet.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Write_packet_clone(benchmark::State& state) {
+  const auto payload_size = static_cast<std::uint16_t>(state.range(0));
+  const std::vector<std::byte> payload(payload_size);
+  const Write_packet packet('S', payload.data(), payload_size);
+  for (auto _ : state) {
+    const auto clone = packet.clone();
+    benchmark::DoNotOptimize(clone.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Write_packet_resize_payload(benchmark::State& state) {
+  const auto payload_size = static_cast<std::uint16_t>(state.range(0));
+  Write_packet packet('S', payload_size);
+  for (auto _ : state) {
+    const auto result = packet.resize_payload(payload_size);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+} // namespace
+
+// NOLINTBEGIN(*-avoid-magic-numbers): Benchmark arguments
+BENCHMARK(BM_Read_packet_resize_payload)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_Write_packet_construct)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_Write_packet_clone)->RangeMultiplier(8)->Range(8, 32768);
+BENCHMARK(BM_Write_packet_resize_payload)->Arg(8)->Arg(32768);
+// NOLINTEND(*-avoid-magic-numbers)
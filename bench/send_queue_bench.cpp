@@ -0,0 +1,112 @@
+#include "bc/soup/send_queue.h"
+
+#include "bc/soup/server/message.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc::soup;
+
+namespace {
+
+using Message = server::Message;
+
+// Consumes messages on the io thread, standing in for server::Port.
+struct Sink {
+  std::atomic<std::size_t> received{0};
+
+  // NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Consumed
+  Write_error send_message(Message&& message) {
+    benchmark::DoNotOptimize(message.payload_data());
+    received.store(received.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    return Write_error::none;
+  }
+};
+
+class Io_thread {
+public:
+  Io_thread() : guard_(asio::make_work_guard(io_context_)) {
+    thread_ = std::thread([this] { io_context_.run(); });
+  }
+
+  ~Io_thread() {
+    guard_.reset();
+    thread_.join();
+  }
+
+  Io_thread(const Io_thread&) = delete;
+  Io_thread& operator=(const Io_thread&) = delete;
+
+  Io_thread(Io_thread&&) = delete;
+  Io_thread& operator=(Io_thread&&) = delete;
+
+  asio::io_context& io_context() { return io_context_; }
+
+private:
+  asio::io_context io_context_{1};
+  asio::executor_work_guard<asio::io_context::executor_type> guard_;
+  std::thread thread_;
+};
+
+void wait_for(const Sink& sink, std::size_t count) {
+  while (sink.received.load(std::memory_order_acquire) < count)
+    std::this_thread::yield();
+}
+
+// The argument is the payload size in bytes. Time is measured on the producer
+// thread, including waiting for the io thread to catch up at the end.
+
+void BM_post_per_message(benchmark::State& state) {
+  const auto size = static_cast<std::uint16_t>(state.range(0));
+  const std::vector<std::byte> payload(size);
+  Sink sink;
+  std::size_t sent = 0;
+  {
+    Io_thread io;
+    for (auto _ : state) {
+      Message message(payload.data(), size);
+      asio::post(io.io_context(), [&sink, m = std::move(message)]() mutable {
+        (void)sink.send_message(std::move(m));
+      });
+      ++sent;
+    }
+    wait_for(sink, sent);
+  }
+  state.SetItemsProcessed(static_cast<benchmark::IterationCount>(sent));
+}
+
+void BM_send_queue_push(benchmark::State& state) {
+  const auto size = static_cast<std::uint16_t>(state.range(0));
+  const std::vector<std::byte> payload(size);
+  Sink sink;
+  std::size_t sent = 0;
+  {
+    Io_thread io;
+    // NOLINTNEXTLINE(*-avoid-magic-numbers): Benchmark value
+    Send_queue<Sink, Message> queue(io.io_context().get_executor(), sink, 4096);
+    for (auto _ : state) {
+      while (queue.push(payload.data(), size) == Write_error::buffer_full)
+        std::this_thread::yield();
+      ++sent;
+    }
+    wait_for(sink, sent);
+  }
+  state.SetItemsProcessed(static_cast<benchmark::IterationCount>(sent));
+}
+
+} // namespace
+
+// NOLINTBEGIN(*-avoid-magic-numbers): Benchmark arguments
+BENCHMARK(BM_post_per_message)->Arg(64)->Arg(1024);
+BENCHMARK(BM_send_queue_push)->Arg(64)->Arg(1024);
+// NOLINTEND(*-avoid-magic-numbers)
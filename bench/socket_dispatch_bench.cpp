@@ -0,0 +1,117 @@
+#include "bc/soup/socket.h"
+
+#include "bc/soup/constants.h"
+#include "bc/soup/packing.h"
+#include "bc/soup/rw_packets.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc::soup;
+
+namespace {
+
+// NOLINTNEXTLINE(*-avoid-magic-numbers): Benchmark value
+constexpr std::size_t packets_per_batch = 64;
+
+// Final, like the Tcp_connections, so a Basic_socket instantiated on it calls
+// it directly while Socket goes through the Socket_handler vtable.
+class Counting_handler final : public Socket_handler {
+public:
+  void connect_failure(asio::error_code) override {}
+  void connect_success() override {}
+
+  void read_failure(asio::error_code ec) override { error = ec; }
+  void read_failure(Packet_error) override {
+    error = asio::error::invalid_argument;
+  }
+
+  void read_success(const Packet_view& packet) override {
+    ++packets;
+    bytes += packet.payload_size();
+  }
+
+  void read_batch_complete() override { ++batches; }
+  void read_aborted() override {}
+  void read_end_of_file() override {}
+
+  void write_failure(asio::error_code) override {}
+  void write_success(const Write_packet&) override {}
+  void write_buffer_empty() override {}
+
+  void closed() override {}
+
+  asio::error_code error;
+  std::size_t packets = 0;
+  std::size_t batches = 0;
+  std::size_t bytes = 0;
+};
+
+// A batch of sequenced data packets, framed as they are on the wire.
+std::vector<std::byte> make_batch(std::uint16_t payload_size) {
+  const auto size = packet_header_length + payload_size;
+  std::vector<std::byte> batch(packets_per_batch * size);
+  for (std::size_t i = 0; i < packets_per_batch; ++i) {
+    auto* data = &batch[i * size];
+    pack(static_cast<std::uint16_t>(packet_type_length + payload_size), data);
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Packet type location
+    data[packet_size_length] = static_cast<std::byte>('S');
+  }
+  return batch;
+}
+
+// The argument is the payload size in bytes. Each iteration writes a batch
+// from the peer and polls the socket until every packet has been delivered,
+// so the difference between the two benchmarks is the per-callback dispatch.
+template <typename Socket_type>
+void BM_socket_dispatch(benchmark::State& state) {
+  const auto payload_size = static_cast<std::uint16_t>(state.range(0));
+  const auto batch = make_batch(payload_size);
+
+  asio::io_context io_context(1);
+  asio::ip::tcp::acceptor acceptor(
+      io_context, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  asio::ip::tcp::socket peer(io_context);
+  peer.connect(acceptor.local_endpoint());
+
+  Counting_handler handler;
+  Socket_type socket(acceptor.accept(), handler);
+  if (const auto ec = socket.set_polled_reads()) {
+    state.SkipWithError(ec.message().c_str());
+    return;
+  }
+  socket.async_read();
+
+  for (auto _ : state) {
+    asio::write(peer, asio::buffer(batch));
+    const auto expected = handler.packets + packets_per_batch;
+    while (handler.packets < expected && !handler.error)
+      socket.poll();
+  }
+  if (handler.error)
+    state.SkipWithError(handler.error.message().c_str());
+
+  benchmark::DoNotOptimize(handler.bytes);
+  state.SetItemsProcessed(state.iterations() * packets_per_batch);
+  state.SetBytesProcessed(state.iterations() * std::int64_t(batch.size()));
+  state.counters["batches"] = static_cast<double>(handler.batches);
+}
+
+void BM_socket_dispatch_virtual(benchmark::State& state) {
+  BM_socket_dispatch<Socket>(state);
+}
+
+void BM_socket_dispatch_static(benchmark::State& state) {
+  BM_socket_dispatch<Basic_socket<Counting_handler>>(state);
+}
+
+} // namespace
+
+BENCHMARK(BM_socket_dispatch_virtual)->Arg(8)->Arg(64)->Arg(512);
+BENCHMARK(BM_socket_dispatch_static)->Arg(8)->Arg(64)->Arg(512);
@@ -0,0 +1,53 @@
+#include "latency_recorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void write_timestamp(void* data) {
+  const std::int64_t now =
+      std::chrono::steady_clock::now().time_since_epoch().count();
+  std::memcpy(data, &now, sizeof(now));
+}
+
+std::chrono::steady_clock::time_point read_timestamp(const void* data) {
+  std::int64_t then = 0;
+  std::memcpy(&then, data, sizeof(then));
+  return std::chrono::steady_clock::time_point(
+      std::chrono::steady_clock::duration(then));
+}
+
+void Latency_recorder::reserve(std::size_t count) {
+  samples_.reserve(count);
+}
+
+void Latency_recorder::clear() {
+  samples_.clear();
+}
+
+void Latency_recorder::merge(const Latency_recorder& other) {
+  samples_.insert(samples_.end(), other.samples_.begin(), other.samples_.end());
+}
+
+Latency_recorder::Summary Latency_recorder::summarize() {
+  Summary summary;
+  summary.count = samples_.size();
+  if (samples_.empty())
+    return summary;
+
+  std::ranges::sort(samples_);
+  auto percentile = [this](double p) {
+    const auto rank = static_cast<std::size_t>(
+        std::ceil(p * static_cast<double>(samples_.size())));
+    const auto index = std::clamp<std::size_t>(rank, 1, samples_.size()) - 1;
+    return std::chrono::nanoseconds(samples_[index]);
+  };
+  summary.min = std::chrono::nanoseconds(samples_.front());
+  // NOLINTBEGIN(*-avoid-magic-numbers): Percentiles
+  summary.p50 = percentile(0.50);
+  summary.p99 = percentile(0.99);
+  summary.p999 = percentile(0.999);
+  // NOLINTEND(*-avoid-magic-numbers)
+  summary.max = std::chrono::nanoseconds(samples_.back());
+  return summary;
+}
@@ -0,0 +1,45 @@
+#ifndef BENCH_UTILITY_LATENCY_RECORDER_H
+#define BENCH_UTILITY_LATENCY_RECORDER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Timestamps carried in the first bytes of a benchmark payload. The steady
+// clock is shared by all processes on a host, so the latency of a message can
+// be measured end to end across processes.
+constexpr std::size_t timestamp_size = sizeof(std::int64_t);
+
+void write_timestamp(void*);
+std::chrono::steady_clock::time_point read_timestamp(const void*);
+
+class Latency_recorder {
+public:
+  struct Summary {
+    std::size_t count = 0;
+    std::chrono::nanoseconds min{};
+    std::chrono::nanoseconds p50{};
+    std::chrono::nanoseconds p99{};
+    std::chrono::nanoseconds p999{};
+    std::chrono::nanoseconds max{};
+  };
+
+  void reserve(std::size_t);
+  void clear();
+
+  void record(std::chrono::nanoseconds latency) {
+    samples_.push_back(latency.count());
+  }
+
+  void merge(const Latency_recorder&);
+
+  std::size_t count() const { return samples_.size(); }
+
+  Summary summarize();
+
+private:
+  std::vector<std::int64_t> samples_;
+};
+
+#endif
@@ -0,0 +1,357 @@
+#include "loopback.h"
+
+#include "bc/soup/client/connection.h"
+#include "bc/soup/server/acceptor.h"
+#include "bc/soup/server/port.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace bc;
+
+namespace {
+
+constexpr std::string_view password = "pass";
+constexpr std::string_view session = "bench";
+constexpr std::chrono::microseconds pacing_interval(100);
+
+std::string describe(asio::error_code ec, std::string_view operation) {
+  return std::string(operation) + ": " + ec.message();
+}
+
+} // namespace
+
+std::string session_username(std::size_t i) {
+  return "u" + std::to_string(i + 1);
+}
+
+Pump::Pump(asio::any_io_executor io_executor, const Loopback_options& options,
+           Send send)
+    : send_(std::move(send)),
+      timer_(io_executor),
+      payload_(std::max(options.message_size, timestamp_size)),
+      rate_(options.rate) {}
+
+void Pump::set_drained_handler(std::function<void()> handler) {
+  drained_handler_ = std::move(handler);
+}
+
+void Pump::add(std::size_t count) {
+  if (count == 0)
+    return;
+  if (pending_ == 0 && rate_ != 0) {
+    pace_start_ = std::chrono::steady_clock::now();
+    paced_sent_ = 0;
+  }
+  pending_ += count;
+  send();
+}
+
+void Pump::resume() {
+  blocked_ = false;
+  send();
+}
+
+void Pump::stop() {
+  stopped_ = true;
+  timer_.cancel();
+}
+
+void Pump::send() {
+  if (stopped_ || blocked_)
+    return;
+  auto count = (rate_ == 0) ? pending_ : std::min(pending_, budget());
+  while (count > 0) {
+    write_timestamp(payload_.data());
+    const auto error = send_(payload_.data(), payload_.size());
+    if (error == soup::Write_error::buffer_full) {
+      blocked_ = true;
+      return;
+    }
+    if (error != soup::Write_error::none) {
+      stopped_ = true;
+      return;
+    }
+    last_send_ = read_timestamp(payload_.data());
+    if (sent_ == 0)
+      first_send_ = last_send_;
+    ++sent_;
+    ++paced_sent_;
+    --pending_;
+    --count;
+  }
+  if (pending_ == 0) {
+    if (drained_handler_)
+      drained_handler_();
+    return;
+  }
+  schedule();
+}
+
+std::size_t Pump::budget() {
+  using namespace std::chrono;
+  const auto elapsed = steady_clock::now() - pace_start_;
+  const auto due = static_cast<std::size_t>(
+      duration_cast<nanoseconds>(elapsed).count() *
+      static_cast<double>(rate_) / nanoseconds(seconds(1)).count());
+  return (due > paced_sent_) ? due - paced_sent_ : 0;
+}
+
+void Pump::schedule() {
+  if (timer_pending_)
+    return;
+  timer_pending_ = true;
+  timer_.expires_after(pacing_interval);
+  timer_.async_wait([this](asio::error_code ec) {
+    timer_pending_ = false;
+    if (!ec)
+      send();
+  });
+}
+
+void Receive_stats::record(const void* data, std::size_t size) {
+  const auto now = std::chrono::steady_clock::now();
+  if (received == 0)
+    first_receive = now;
+  last_receive = now;
+  ++received;
+  bytes += size;
+  if (size >= timestamp_size)
+    latency.record(now - read_timestamp(data));
+}
+
+Loopback_port::Loopback_port(asio::any_io_executor io_executor,
+                             soup::server::Port& port,
+                             const Loopback_options& options)
+    : executor_(io_executor),
+      port_(&port),
+      options_(options),
+      pump_(io_executor, options, [this](const void* data, std::size_t size) {
+        return port_->send_message(data, size);
+      }) {
+  port_->set_handler(*this);
+  if (options_.traffic == Traffic::unsequenced)
+    stats_.latency.reserve(options_.message_count);
+}
+
+void Loopback_port::set_done_handler(std::function<void()> handler) {
+  done_handler_ = std::move(handler);
+}
+
+void Loopback_port::login_success(const soup::Login_accepted_packet&) {
+  logged_out_ = false;
+  // Login accepted is queued after this callback returns; start sending once
+  // it is on its way.
+  if (options_.traffic == Traffic::sequenced)
+    asio::post(executor_, [this] { pump_.add(options_.message_count); });
+}
+
+void Loopback_port::unsequenced_data(const void* data, std::size_t size) {
+  stats_.record(data, size);
+}
+
+void Loopback_port::logout_request() {
+  logged_out_ = true;
+}
+
+void Loopback_port::write_buffer_empty() {
+  pump_.resume();
+}
+
+void Loopback_port::debug(std::string_view) {}
+
+void Loopback_port::transport_error(asio::error_code, std::string_view) {}
+
+void Loopback_port::protocol_violation(soup::Packet_error) {}
+
+void Loopback_port::disconnect(soup::Disconnect_reason) {
+  if (logged_out_ && done_handler_)
+    done_handler_();
+}
+
+Loopback_server::Loopback_server(asio::any_io_executor io_executor,
+                                 const soup::Endpoint& endpoint,
+                                 std::size_t sessions,
+                                 const Loopback_options& options)
+    : server_(io_executor), listen_endpoint_(endpoint) {
+  if (const auto ec = server_.set_session(session))
+    throw std::system_error(ec, "set_session");
+  const auto result = server_.add_acceptor(endpoint, *this);
+  if (!result)
+    throw std::system_error(result.error(), "add_acceptor");
+  auto* acceptor = *result;
+  acceptor->set_write_packets_limit(options.write_packets_limit);
+  for (std::size_t i = 0; i < sessions; ++i) {
+    const auto port = acceptor->add_port(session_username(i), password);
+    if (!port)
+      throw std::system_error(port.error(), "add_port");
+    ports_.push_back(
+        std::make_unique<Loopback_port>(io_executor, **port, options));
+  }
+}
+
+std::error_code Loopback_server::start() {
+  return server_.start();
+}
+
+void Loopback_server::stop() {
+  server_.stop();
+}
+
+void Loopback_server::listen_setup_failure(asio::error_code ec,
+                                           std::string_view operation) {
+  error_ = describe(ec, operation);
+}
+
+void Loopback_server::listen_setup_success(
+    const asio::ip::tcp::endpoint& endpoint) {
+  if (soup::is_tcp(listen_endpoint_))
+    endpoint_ = endpoint;
+  else
+    endpoint_ = listen_endpoint_;
+}
+
+void Loopback_server::accept_failure(asio::error_code ec) {
+  error_ = describe(ec, "accept");
+}
+
+void Loopback_server::accept_success(const asio::ip::tcp::endpoint&,
+                                     const asio::ip::tcp::endpoint&) {}
+
+void Loopback_server::login_request(const soup::Login_request_packet&) {}
+
+void Loopback_server::login_failure(soup::Login_reject_reason reason) {
+  error_ = std::string("login failure: ") + to_string(reason);
+}
+
+void Loopback_server::debug(std::string_view) {}
+
+void Loopback_server::transport_error(asio::error_code, std::string_view) {}
+
+void Loopback_server::protocol_violation(soup::Packet_error) {}
+
+void Loopback_server::disconnect(soup::Disconnect_reason) {}
+
+Loopback_client::Loopback_client(asio::any_io_executor io_executor,
+                                 const soup::Endpoint& endpoint,
+                                 std::size_t i,
+                                 const Loopback_options& options)
+    : client_(io_executor, *this),
+      options_(options),
+      pump_(io_executor, options, [this](const void* data, std::size_t size) {
+        return client_.send_message(data, size);
+      }) {
+  client_.set_write_packets_limit(options_.write_packets_limit);
+  client_.set_polled_reads(options_.polled_reads);
+  if (options_.batched)
+    client_.set_batch_handler(*this);
+  const auto result = client_.add_connection(endpoint, *this);
+  if (!result)
+    throw std::system_error(result.error(), "add_connection");
+  connection_ = *result;
+  if (const auto ec = connection_->set_username(session_username(i)))
+    throw std::system_error(ec, "set_username");
+  if (const auto ec = connection_->set_password(password))
+    throw std::system_error(ec, "set_password");
+  if (const auto ec = connection_->set_session(session))
+    throw std::system_error(ec, "set_session");
+  if (options_.traffic == Traffic::sequenced)
+    stats_.latency.reserve(options_.message_count);
+  pump_.set_drained_handler([this] {
+    if (options_.traffic == Traffic::unsequenced && options_.message_count != 0)
+      logout();
+  });
+}
+
+void Loopback_client::set_done_handler(std::function<void()> handler) {
+  done_handler_ = std::move(handler);
+}
+
+std::error_code Loopback_client::start() {
+  return client_.start();
+}
+
+void Loopback_client::stop() {
+  client_.stop();
+}
+
+void Loopback_client::sequenced_data(std::uint64_t, const void* data,
+                                     std::size_t size) {
+  stats_.record(data, size);
+  if (options_.traffic == Traffic::sequenced &&
+      stats_.received == options_.message_count)
+    logout();
+}
+
+void Loopback_client::end_of_session() {}
+
+void Loopback_client::sequenced_data(
+    std::span<const bc::soup::client::Sequenced_data> batch) {
+  for (const auto& entry : batch)
+    stats_.record(entry.data, entry.size);
+  if (options_.traffic == Traffic::sequenced && options_.message_count != 0 &&
+      stats_.received >= options_.message_count)
+    logout();
+}
+
+void Loopback_client::connecting(const asio::ip::tcp::endpoint&) {}
+
+void Loopback_client::connect_failure(asio::error_code ec,
+                                      std::string_view operation) {
+  error_ = describe(ec, operation);
+}
+
+void Loopback_client::connect_success(const asio::ip::tcp::endpoint&,
+                                      const asio::ip::tcp::endpoint&) {}
+
+void Loopback_client::logging_in(const soup::Login_request_packet&) {}
+
+void Loopback_client::login_failure(soup::Login_reject_reason reason) {
+  error_ = std::string("login failure: ") + to_string(reason);
+}
+
+void Loopback_client::login_success(const soup::Login_accepted_packet&) {
+  logged_in_ = true;
+  if (options_.traffic == Traffic::unsequenced)
+    pump_.add(options_.message_count);
+}
+
+void Loopback_client::write_buffer_empty() {
+  if (logout_pending_) {
+    logout_pending_ = false;
+    logout();
+  }
+  pump_.resume();
+}
+
+void Loopback_client::debug(std::string_view) {}
+
+void Loopback_client::transport_error(asio::error_code ec,
+                                      std::string_view operation) {
+  error_ = describe(ec, operation);
+}
+
+void Loopback_client::protocol_violation(soup::Packet_error error) {
+  error_ = std::string("protocol violation: ") + to_string(error);
+}
+
+void Loopback_client::disconnect(soup::Disconnect_reason) {
+  logged_in_ = false;
+  if (!logout_sent_)
+    return;
+  client_.stop();
+  if (done_handler_)
+    done_handler_();
+}
+
+void Loopback_client::reconnect_scheduled(std::chrono::milliseconds) {}
+
+void Loopback_client::logout() {
+  if (logout_sent_)
+    return;
+  const auto error = connection_->send_logout_request();
+  if (error == soup::Write_error::buffer_full)
+    logout_pending_ = true;
+  else
+    logout_sent_ = true;
+}
@@ -0,0 +1,240 @@
+#ifndef BENCH_UTILITY_LOOPBACK_H
+#define BENCH_UTILITY_LOOPBACK_H
+
+#include "latency_recorder.h"
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/client/handler.h"
+#include "bc/soup/endpoint.h"
+#include "bc/soup/metrics.h"
+#include "bc/soup/server/handler.h"
+#include "bc/soup/server/server.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+enum class Traffic {
+  sequenced,
+  unsequenced
+};
+
+struct Loopback_options {
+  Traffic traffic = Traffic::sequenced;
+  // NOLINTBEGIN(*-avoid-magic-numbers): Default values
+  std::size_t message_size = 64;
+  // Messages each session sends after login; 0 leaves sending to the caller.
+  std::size_t message_count = 0;
+  // Messages per second per session; 0 sends as fast as backpressure allows.
+  std::uint64_t rate = 0;
+  std::size_t write_packets_limit = 100;
+  // NOLINTEND(*-avoid-magic-numbers)
+  // Clients read only when polled, e.g. by a client::Spin_runner.
+  bool polled_reads = false;
+  // Clients receive sequenced data through a Sequenced_batch_handler.
+  bool batched = false;
+};
+
+std::string session_username(std::size_t);
+
+// Sends timestamped messages through a send function, pausing on a full write
+// buffer until resume() is called from a write_buffer_empty callback.
+class Pump {
+public:
+  using Send = std::function<bc::soup::Write_error(const void*, std::size_t)>;
+
+  Pump(asio::any_io_executor, const Loopback_options&, Send);
+
+  void set_drained_handler(std::function<void()>);
+
+  void add(std::size_t);
+  void resume();
+  void stop();
+
+  std::size_t sent() const { return sent_; }
+  std::size_t pending() const { return pending_; }
+
+  std::chrono::steady_clock::time_point first_send() const {
+    return first_send_;
+  }
+
+  std::chrono::steady_clock::time_point last_send() const {
+    return last_send_;
+  }
+
+private:
+  Send send_;
+  asio::steady_timer timer_;
+  std::vector<std::byte> payload_;
+  std::uint64_t rate_ = 0;
+  std::size_t pending_ = 0;
+  std::size_t sent_ = 0;
+  std::size_t paced_sent_ = 0;
+  bool blocked_ = false;
+  bool timer_pending_ = false;
+  bool stopped_ = false;
+  std::chrono::steady_clock::time_point pace_start_;
+  std::chrono::steady_clock::time_point first_send_;
+  std::chrono::steady_clock::time_point last_send_;
+  std::function<void()> drained_handler_;
+
+  void send();
+  std::size_t budget();
+  void schedule();
+};
+
+// Receive-side accounting shared by the server ports and the clients.
+struct Receive_stats {
+  std::size_t received = 0;
+  std::size_t bytes = 0;
+  Latency_recorder latency;
+  std::chrono::steady_clock::time_point first_receive;
+  std::chrono::steady_clock::time_point last_receive;
+
+  void record(const void*, std::size_t);
+};
+
+class Loopback_port final : public bc::soup::server::Port_handler {
+public:
+  Loopback_port(asio::any_io_executor, bc::soup::server::Port&,
+                const Loopback_options&);
+
+  void set_done_handler(std::function<void()>);
+
+  void login_success(const bc::soup::Login_accepted_packet&) override;
+  void unsequenced_data(const void*, std::size_t) override;
+  void logout_request() override;
+  void write_buffer_empty() override;
+  void debug(std::string_view) override;
+  void transport_error(asio::error_code, std::string_view) override;
+  void protocol_violation(bc::soup::Packet_error) override;
+  void disconnect(bc::soup::Disconnect_reason) override;
+
+  Pump& pump() { return pump_; }
+  Receive_stats& stats() { return stats_; }
+
+private:
+  asio::any_io_executor executor_;
+  bc::soup::server::Port* port_ = nullptr;
+  Loopback_options options_;
+  Pump pump_;
+  Receive_stats stats_;
+  bool logged_out_ = false;
+  std::function<void()> done_handler_;
+};
+
+class Loopback_server final : public bc::soup::server::Acceptor_handler {
+public:
+  Loopback_server(asio::any_io_executor, const bc::soup::Endpoint&,
+                  std::size_t, const Loopback_options&);
+
+  [[nodiscard]] std::error_code start();
+  void stop();
+
+  // Set once the acceptor is listening; the bound port is chosen by the
+  // system when the configured endpoint has port 0.
+  const std::optional<bc::soup::Endpoint>& endpoint() const {
+    return endpoint_;
+  }
+
+  const std::optional<std::string>& error() const { return error_; }
+
+  bc::soup::Metrics_registry::Snapshot metrics() const {
+    return server_.metrics();
+  }
+
+  std::size_t size() const { return ports_.size(); }
+  Loopback_port& port(std::size_t i) { return *ports_[i]; }
+
+  void listen_setup_failure(asio::error_code, std::string_view) override;
+  void listen_setup_success(const asio::ip::tcp::endpoint&) override;
+  void accept_failure(asio::error_code) override;
+  void accept_success(const asio::ip::tcp::endpoint&,
+                      const asio::ip::tcp::endpoint&) override;
+  void login_request(const bc::soup::Login_request_packet&) override;
+  void login_failure(bc::soup::Login_reject_reason) override;
+  void debug(std::string_view) override;
+  void transport_error(asio::error_code, std::string_view) override;
+  void protocol_violation(bc::soup::Packet_error) override;
+  void disconnect(bc::soup::Disconnect_reason) override;
+
+private:
+  bc::soup::server::Server server_;
+  std::vector<std::unique_ptr<Loopback_port>> ports_;
+  bc::soup::Endpoint listen_endpoint_;
+  std::optional<bc::soup::Endpoint> endpoint_;
+  std::optional<std::string> error_;
+};
+
+class Loopback_client final
+    : public bc::soup::client::Client_handler,
+      public bc::soup::client::Sequenced_batch_handler,
+      public bc::soup::client::Connection_handler {
+public:
+  Loopback_client(asio::any_io_executor, const bc::soup::Endpoint&,
+                  std::size_t, const Loopback_options&);
+
+  void set_done_handler(std::function<void()>);
+
+  [[nodiscard]] std::error_code start();
+  void stop();
+
+  void sequenced_data(std::uint64_t, const void*, std::size_t) override;
+  void end_of_session() override;
+
+  void
+  sequenced_data(std::span<const bc::soup::client::Sequenced_data>) override;
+
+  void connecting(const asio::ip::tcp::endpoint&) override;
+  void connect_failure(asio::error_code, std::string_view) override;
+  void connect_success(const asio::ip::tcp::endpoint&,
+                       const asio::ip::tcp::endpoint&) override;
+  void logging_in(const bc::soup::Login_request_packet&) override;
+  void login_failure(bc::soup::Login_reject_reason) override;
+  void login_success(const bc::soup::Login_accepted_packet&) override;
+  void write_buffer_empty() override;
+  void debug(std::string_view) override;
+  void transport_error(asio::error_code, std::string_view) override;
+  void protocol_violation(bc::soup::Packet_error) override;
+  void disconnect(bc::soup::Disconnect_reason) override;
+  void reconnect_scheduled(std::chrono::milliseconds) override;
+
+  bc::soup::Metrics_registry::Snapshot metrics() const {
+    return client_.metrics();
+  }
+
+  bc::soup::client::Client& client() { return client_; }
+
+  bool logged_in() const { return logged_in_; }
+  const std::optional<std::string>& error() const { return error_; }
+
+  Pump& pump() { return pump_; }
+  Receive_stats& stats() { return stats_; }
+
+private:
+  bc::soup::client::Client client_;
+  bc::soup::client::Connection* connection_ = nullptr;
+  Loopback_options options_;
+  Pump pump_;
+  Receive_stats stats_;
+  bool logged_in_ = false;
+  bool logout_pending_ = false;
+  bool logout_sent_ = false;
+  std::optional<std::string> error_;
+  std::function<void()> done_handler_;
+
+  void logout();
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "bc/soup/socket.h"
+
+#include "bc/soup/rw_packets.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+using namespace bc::soup;
+
+namespace {
+
+// NOLINTNEXTLINE(*-avoid-magic-numbers): Benchmark value
+constexpr std::size_t packets_per_batch = 16;
+
+// Near the largest payload a packet can carry, like a reference data snapshot
+constexpr auto payload_size = static_cast<std::uint16_t>(
+    std::numeric_limits<std::uint16_t>::max() - packet_type_length);
+
+class Sending_handler final : public Socket_handler {
+public:
+  void connect_failure(asio::error_code) override {}
+  void connect_success() override {}
+
+  void read_failure(asio::error_code) override {}
+  void read_failure(Packet_error) override {}
+  void read_success(const Packet_view&) override {}
+  void read_batch_complete() override {}
+  void read_aborted() override {}
+  void read_end_of_file() override {}
+
+  void write_failure(asio::error_code ec) override { error = ec; }
+  void write_success(const Write_packet&) override { ++packets; }
+  void write_buffer_empty() override {}
+
+  void closed() override {}
+
+  asio::error_code error;
+  std::size_t packets = 0;
+};
+
+// The argument is the zero-copy threshold, zero for copying sends. A thread
+// drains the peer while each iteration sends a batch of full-size packets.
+// Process CPU time covers both, so bytes per second is the inverse of CPU per
+// byte. Over loopback the kernel copies the data anyway when it is received,
+// so the saving shows only when sending through a NIC.
+void BM_socket_send(benchmark::State& state) {
+  const auto threshold = static_cast<std::size_t>(state.range(0));
+
+  asio::io_context io_context(1);
+  asio::ip::tcp::acceptor acceptor(
+      io_context, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  asio::io_context peer_io_context(1);
+  asio::ip::tcp::socket peer(peer_io_context);
+  peer.connect(acceptor.local_endpoint());
+
+  Sending_handler handler;
+  Socket socket(acceptor.accept(), handler);
+  socket.set_write_packets_limit(packets_per_batch);
+  if (threshold != 0) {
+    if (const auto ec = socket.set_zero_copy(threshold)) {
+      state.SkipWithError(ec.message().c_str());
+      return;
+    }
+  }
+
+  std::thread drain([&peer] {
+    // NOLINTNEXTLINE(*-avoid-magic-numbers): Receive buffer size
+    std::array<std::byte, 1 << 16> buffer;
+    asio::error_code ec;
+    while (!ec)
+      peer.read_some(asio::buffer(buffer), ec);
+  });
+
+  for (auto _ : state) {
+    const auto expected = handler.packets + packets_per_batch;
+    for (std::size_t i = 0; i < packets_per_batch; ++i)
+      (void)socket.async_write(Write_packet('S', payload_size));
+    // Runs out of work after each batch when sends are copied
+    io_context.restart();
+    while (handler.packets < expected && !handler.error)
+      io_context.run_one();
+  }
+  if (handler.error)
+    state.SkipWithError(handler.error.message().c_str());
+
+  socket.close();
+  io_context.run();
+  drain.join();
+
+  state.SetItemsProcessed(state.iterations() * packets_per_batch);
+  state.SetBytesProcessed(state.iterations() * packets_per_batch *
+                          (packet_header_length + payload_size));
+}
+
+} // namespace
+
+BENCHMARK(BM_socket_send)
+    ->Arg(0)
+    ->Arg(packet_header_length + payload_size)
+    ->MeasureProcessCPUTime();
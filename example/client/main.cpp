@@ -1,6 +1,7 @@
 #include "bc/soup/client/client.h"
 #include "bc/soup/client/connection.h"
 #include "bc/soup/client/handler.h"
+#include "bc/soup/client/journal.h"
 #include "bc/soup/expected.h"
 #include "bc/soup/logical_packets.h"
 #include "bc/soup/types.h"
@@ -95,8 +96,8 @@ public:
     std::println("disconnect: reason = {}", to_string(reason));
   }
 
-  void reconnect_scheduled(std::chrono::seconds delay) override {
-    std::println("reconnect scheduled: delay = {}s", delay.count());
+  void reconnect_scheduled(std::chrono::milliseconds delay) override {
+    std::println("reconnect scheduled: delay = {}ms", delay.count());
   }
 
   void send_message() {
@@ -119,7 +120,16 @@ public:
   }
 
   void initialize(std::string_view username, std::string_view password,
-                  std::string_view session) {
+                  std::string_view session, std::string_view journal,
+                  std::string_view shared_tail) {
+    if (!journal.empty()) {
+      journal_.set_filename(journal);
+      journal_.set_shared_tail(shared_tail);
+      if (const auto ec = journal_.open())
+        throw std::system_error(ec, "journal open");
+      client_.set_journal(journal_);
+    }
+
     const auto address = asio::ip::make_address("127.0.0.1");
     const unsigned short port = 5050;
     const asio::ip::tcp::endpoint ep(address, port);
@@ -150,18 +160,21 @@ public:
   void stop() { client_.stop(); }
 
 private:
+  // Outlives the client
+  soup::client::Journal journal_;
   soup::client::Client client_;
   std::optional<Connection> connection_;
 };
 
 void run(std::string_view username, std::string_view password,
-         std::string_view session) {
+         std::string_view session, std::string_view journal,
+         std::string_view shared_tail) {
   asio::io_context io_context;
   Io_context_runner io_runner(io_context);
   std::atomic<bool> keep_going = true;
   io_runner.set_signal_handler([&keep_going] { keep_going = false; });
   Client client(io_context);
-  client.initialize(username, password, session);
+  client.initialize(username, password, session, journal, shared_tail);
 
   io_runner.start();
   std::this_thread::sleep_for(1s);
@@ -186,8 +199,10 @@ void display_usage() {
   std::print("usage: bc_soup_client [options]\n"
              "options:\n"
              "  -h  help\n"
+             "  -j  journal file, replayed on start []\n"
              "  -p  password [pass]\n"
              "  -s  session [sess]\n"
+             "  -t  shared tail of the journal, for bc_soup_tail []\n"
              "  -u  username [user]\n"
              "  -v  version\n");
 }
@@ -200,20 +215,28 @@ int main(int argc, char** argv) {
   const char* username = "user";
   const char* password = "pass";
   const char* session = "sess";
+  const char* journal = "";
+  const char* shared_tail = "";
 
   try {
     int opt = 0;
-    while ((opt = getopt(argc, argv, ":hp:s:u:v")) != -1) {
+    while ((opt = getopt(argc, argv, ":hj:p:s:t:u:v")) != -1) {
       switch (opt) {
       case 'h':
         display_usage();
         return EXIT_SUCCESS;
+      case 'j':
+        journal = optarg;
+        break;
       case 'p':
         password = optarg;
         break;
       case 's':
         session = optarg;
         break;
+      case 't':
+        shared_tail = optarg;
+        break;
       case 'u':
         username = optarg;
         break;
@@ -233,7 +256,7 @@ int main(int argc, char** argv) {
   }
 
   try {
-    run(username, password, session);
+    run(username, password, session, journal, shared_tail);
   } catch (const std::system_error& e) {
     std::println("system error: {}:{} {}", e.code().category().name(),
                  e.code().value(), e.what());
@@ -0,0 +1,145 @@
+#include "bc/soup/shared_tail.h"
+#include "bc_soup_config.h"
+#include "option_convert.h"
+#include "option_error.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <print>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace bc;
+using namespace std::chrono_literals;
+
+namespace {
+
+// NOLINTNEXTLINE(*-avoid-non-const-global-variables): Set by the signal
+volatile std::sig_atomic_t keep_going = 1;
+
+void stop(int) {
+  keep_going = 0;
+}
+
+// Messages printed per read
+constexpr std::size_t batch_messages = 1024;
+
+} // namespace
+
+// Prints the messages of a journal as the bc_soup_client writing it adds
+// them, with how long after each was received where the journal has
+// timestamps.
+void run(std::string_view journal, std::string_view shared_tail,
+         std::size_t first, bool busy_poll) {
+  soup::Tail_reader reader(journal, shared_tail);
+  // Until the client has opened its journal
+  std::error_code ec;
+  while (keep_going && (ec = reader.open()) &&
+         ec == std::errc::no_such_file_or_directory)
+    std::this_thread::sleep_for(100ms);
+  if (ec)
+    throw std::system_error(ec, "open");
+  reader.seek(first);
+
+  while (keep_going) {
+    const auto first_read = reader.next_sequence_number();
+    if (const auto read_ec = reader.read(batch_messages))
+      throw std::system_error(read_ec, "read");
+    const auto messages = reader.messages();
+    const auto timestamps = reader.timestamps();
+    const auto now = std::chrono::system_clock::now();
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+      const std::string_view message(
+          reinterpret_cast<const char*>(messages[i].data()),
+          messages[i].size());
+      if (timestamps.empty()) {
+        std::println("sequenced data: sequence number = {}, data = {}",
+                     first_read + i, message);
+      } else {
+        std::println("sequenced data: sequence number = {}, data = {}, "
+                     "latency = {}us",
+                     first_read + i, message,
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                         now - timestamps[i])
+                         .count());
+      }
+    }
+    if (messages.empty() && !busy_poll)
+      std::this_thread::sleep_for(1ms);
+  }
+}
+
+void display_usage() {
+  std::print("usage: bc_soup_tail [options]\n"
+             "options:\n"
+             "  -b  busy poll rather than sleep when idle\n"
+             "  -f  first sequence number [1]\n"
+             "  -h  help\n"
+             "  -j  journal file [journal]\n"
+             "  -t  shared tail of the journal [journal.tail]\n"
+             "  -v  version\n");
+}
+
+void display_version() {
+  std::println("version {}.{}", bc_soup_VERSION_MAJOR, bc_soup_VERSION_MINOR);
+}
+
+int main(int argc, char** argv) {
+  const char* journal = "journal";
+  const char* shared_tail = "journal.tail";
+  long first = 1;
+  bool busy_poll = false;
+
+  try {
+    int opt = 0;
+    while ((opt = getopt(argc, argv, ":bf:hj:t:v")) != -1) {
+      switch (opt) {
+      case 'b':
+        busy_poll = true;
+        break;
+      case 'f':
+        first = to_long(optarg, opt);
+        if (first < 1)
+          throw Invalid_argument(opt, "out of range");
+        break;
+      case 'h':
+        display_usage();
+        return EXIT_SUCCESS;
+      case 'j':
+        journal = optarg;
+        break;
+      case 't':
+        shared_tail = optarg;
+        break;
+      case 'v':
+        display_version();
+        return EXIT_SUCCESS;
+      case ':':
+        throw Missing_argument(optopt);
+      case '?':
+      default:
+        throw Illegal_option(optopt);
+      }
+    }
+  } catch (const Option_error& e) {
+    std::println("{}", e.what());
+    return EXIT_FAILURE;
+  }
+
+  (void)std::signal(SIGINT, stop);
+  (void)std::signal(SIGTERM, stop);
+  try {
+    run(journal, shared_tail, static_cast<std::size_t>(first), busy_poll);
+  } catch (const std::system_error& e) {
+    std::println("system error: {}:{} {}", e.code().category().name(),
+                 e.code().value(), e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
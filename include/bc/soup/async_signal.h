@@ -0,0 +1,36 @@
+#ifndef INCLUDE_BC_SOUP_ASYNC_SIGNAL_H
+#define INCLUDE_BC_SOUP_ASYNC_SIGNAL_H
+
+#include <asio.hpp>
+
+namespace bc::soup {
+
+// Suspends coroutines on an io_context until notify() is called from the same
+// io_context. A notify() with no waiter is not remembered, so a waiter checks
+// its condition first and again after waking, as with a condition variable.
+// Waiters are resumed through the io_context, never from within notify().
+//
+// Destroy only after the io_context has stopped or been destroyed, as a
+// waiting coroutine would otherwise be resumed to find it gone.
+class Async_signal {
+public:
+  explicit Async_signal(asio::any_io_executor io_executor)
+      : timer_(io_executor, asio::steady_timer::time_point::max()) {}
+
+  // Not a coroutine itself, so waiting adds no frame of its own.
+  auto wait() {
+    return timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec_));
+  }
+
+  void notify() { timer_.cancel(); }
+
+private:
+  // Never expires, only cancelled
+  asio::steady_timer timer_;
+  // Always operation_aborted
+  asio::error_code ec_;
+};
+
+} // namespace bc::soup
+
+#endif
@@ -2,16 +2,22 @@
 #define INCLUDE_BC_SOUP_CLIENT_CLIENT_H
 
 #include "bc/soup/client/connection.h"
+#include "bc/soup/endpoint.h"
 #include "bc/soup/expected.h"
+#include "bc/soup/metrics.h"
+#include "bc/soup/reconnect_policy.h"
+#include "bc/soup/slab_list.h"
+#include "bc/soup/timeouts.h"
 #include "bc/soup/types.h"
 
 #include <asio.hpp>
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <list>
 #include <string_view>
 #include <system_error>
+#include <vector>
 
 namespace bc::soup {
 class Write_packet;
@@ -21,7 +27,22 @@ namespace bc::soup::client {
 
 class Client_handler;
 class Connection_handler;
+class Journal;
 class Message;
+class Sequenced_batch_handler;
+struct Sequenced_data;
+
+// Where unsequenced data goes when the client has more than one connection,
+// i.e. line, to the server.
+enum class Send_policy {
+  // Every line
+  all_lines,
+  // The line that delivered the most sequenced data first over the last
+  // arbitration window, or the primary until one has passed
+  fastest_line,
+  // The first line added
+  primary_line
+};
 
 class Client {
 public:
@@ -29,23 +50,59 @@ public:
   Client(asio::any_io_executor, Client_handler&);
 
   void set_handler(Client_handler&);
+  // Sequenced data then goes to the batch handler instead of the client
+  // handler.
+  void set_batch_handler(Sequenced_batch_handler&);
   void set_write_packets_limit(std::size_t);
+  // SO_BUSY_POLL on each connection's socket; zero leaves it unset.
+  void set_busy_poll(std::chrono::microseconds);
+  // Reads are performed by poll(), e.g. from a Spin_runner, rather than by
+  // the io_context. Set before start().
+  void set_polled_reads(bool);
+
+  // Under a policy choosing one line, data the line cannot take because it is
+  // not logged in goes to the first of the others that can, in the order
+  // added. A full write buffer is returned rather than failed over.
+  void set_send_policy(Send_policy);
+  // For connections added from then on, which may set their own.
+  [[nodiscard]] std::error_code set_timeouts(const Timeouts&);
+  // For connections added from then on, which may set their own.
+  [[nodiscard]] std::error_code set_reconnect_policy(const Reconnect_policy&);
 
   void set_next_sequence_number(std::uint64_t);
-
+  // Sequenced messages are journaled before they are delivered, and start()
+  // replays those from next_sequence_number() on to the handler before it
+  // connects, continuing from the end of the journal. The journal must be
+  // open, and a connection's session is taken from it if not set.
+  void set_journal(Journal&);
+
+  // A TCP endpoint, or a Unix-domain one for a server on the same host, in
+  // which case handlers are given default-constructed TCP endpoints.
   [[nodiscard]] expected<Connection*, std::error_code>
-  add_connection(const asio::ip::tcp::endpoint&);
+  add_connection(const Endpoint&);
 
   [[nodiscard]] expected<Connection*, std::error_code>
-  add_connection(const asio::ip::tcp::endpoint&, Connection_handler&);
+  add_connection(const Endpoint&, Connection_handler&);
 
   std::uint64_t next_sequence_number() const { return next_sequence_number_; }
   bool has_session_ended() const { return has_session_ended_; }
 
+  // May be called from any thread. Includes how each line fares against the
+  // others at delivering sequenced data.
+  Metrics_registry::Snapshot metrics() const {
+    return metrics_registry_.snapshot();
+  }
+
+  // Replays the journal, if any, from within the call.
   [[nodiscard]] std::error_code start();
   void stop();
 
+  // With polled reads, reads and dispatches whatever has arrived on each
+  // connection without blocking. Returns zero when there was nothing to do.
+  std::size_t poll();
+
   [[nodiscard]] Write_error send_message(const void*, std::size_t);
+  // The message is moved from only on success.
   [[nodiscard]] Write_error send_message(Message&&);
 
   void send_logout_request();
@@ -53,28 +110,69 @@ public:
 
 private:
   static constexpr std::size_t default_write_packets_limit = 100;
+  // Messages between choices of the fastest line
+  static constexpr std::uint64_t arbitration_window = 1024;
+  // Messages whose first delivery is remembered, to time the others
+  static constexpr std::size_t arrival_count = 4096;
+
+  struct Arrival {
+    std::uint64_t sequence_number = 0;
+    std::chrono::steady_clock::time_point time;
+    Connection* connection = nullptr;
+  };
 
   Client_handler* handler_ = nullptr;
+  Sequenced_batch_handler* batch_handler_ = nullptr;
+  std::vector<Sequenced_data> batch_;
+  Journal* journal_ = nullptr;
   asio::any_io_executor io_executor_;
   std::size_t write_packets_limit_ = default_write_packets_limit;
-  std::list<Connection> connections_;
+  std::chrono::microseconds busy_poll_ = std::chrono::microseconds::zero();
+  bool polled_reads_ = false;
+  Send_policy send_policy_ = Send_policy::all_lines;
+  Timeouts timeouts_ = Timeouts::client();
+  Reconnect_policy reconnect_policy_;
+  // Outlives the connections
+  Metrics_registry metrics_registry_;
+  Slab_list<Connection> connections_;
   std::uint64_t next_sequence_number_ = 1;
   bool has_session_ended_ = false;
   bool started_ = false;
+  // Indexed by sequence number; allocated with the second line
+  std::vector<Arrival> arrivals_;
+  std::uint64_t window_messages_ = 0;
+  Connection* fastest_ = nullptr;
 
   [[nodiscard]] expected<Connection*, std::error_code>
-  add_connection(const asio::ip::tcp::endpoint&, Connection_handler*);
+  add_connection(const Endpoint&, Connection_handler*);
+
+  [[nodiscard]] std::error_code replay_journal();
+
+  void on_win(Connection&, std::uint64_t);
+  void on_duplicate(Connection&, std::uint64_t);
+  void choose_fastest();
 
   [[nodiscard]] Write_error send_packet(Write_packet&&);
   [[nodiscard]] Write_error send_one(Write_packet&&);
   [[nodiscard]] Write_error send_two(Write_packet&&);
   [[nodiscard]] Write_error send_multiple(Write_packet&&);
+  [[nodiscard]] Write_error send_preferred(Connection&, Write_packet&&);
 
   // Called by Connection
   friend class Connection;
   std::size_t write_packets_limit() const { return write_packets_limit_; }
+  std::chrono::microseconds busy_poll() const { return busy_poll_; }
+  bool polled_reads() const { return polled_reads_; }
   bool started() const { return started_; }
-  void on_sequenced_data(std::uint64_t, const void*, std::size_t);
+  const Timeouts& timeouts() const { return timeouts_; }
+  const Reconnect_policy& reconnect_policy() const {
+    return reconnect_policy_;
+  }
+  Metrics_registry& metrics_registry() { return metrics_registry_; }
+  [[nodiscard]] std::error_code on_login_success(std::string_view);
+  [[nodiscard]] std::error_code on_sequenced_data(Connection&, std::uint64_t,
+                                                  const void*, std::size_t);
+  void on_read_batch_complete();
   void on_end_of_session();
 };
 
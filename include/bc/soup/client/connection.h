@@ -2,7 +2,12 @@
 #define INCLUDE_BC_SOUP_CLIENT_CONNECTION_H
 
 #include "bc/soup/client/tcp_connection.h"
+#include "bc/soup/endpoint.h"
+#include "bc/soup/metrics.h"
+#include "bc/soup/reconnect_policy.h"
 #include "bc/soup/reconnect_timer.h"
+#include "bc/soup/slab_list.h"
+#include "bc/soup/timeouts.h"
 #include "bc/soup/types.h"
 
 #include <asio.hpp>
@@ -14,6 +19,8 @@
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <utility>
+#include <vector>
 
 namespace bc::soup {
 struct Login_accepted_packet;
@@ -29,7 +36,7 @@ class Message;
 
 class Connection final : public Reconnect_timer::Handler {
 public:
-  Connection(asio::any_io_executor, const asio::ip::tcp::endpoint&, Client&,
+  Connection(asio::any_io_executor, const Endpoint&, Client&,
              Connection_handler*);
 
   void reconnect_timer_error(asio::error_code, std::string_view) override;
@@ -40,8 +47,20 @@ public:
   [[nodiscard]] std::error_code set_username(std::string_view);
   [[nodiscard]] std::error_code set_password(std::string_view);
   [[nodiscard]] std::error_code set_session(std::string_view);
+  // From the next connect on; the client's by default.
+  [[nodiscard]] std::error_code set_timeouts(const Timeouts&);
+  // The client's by default
+  [[nodiscard]] std::error_code set_reconnect_policy(const Reconnect_policy&);
 
-  const asio::ip::tcp::endpoint& endpoint() const { return endpoint_; }
+  // Another endpoint of the same line, e.g. the server's standby. Each
+  // connect races one connection per endpoint, and the first to log in is
+  // kept; the others are closed as superseded.
+  [[nodiscard]] std::error_code add_alternate_endpoint(const Endpoint&);
+
+  const Endpoint& endpoint() const { return endpoint_; }
+  const std::vector<Endpoint>& alternate_endpoints() const {
+    return alternate_endpoints_;
+  }
 
   std::string_view username() const { return username_; }
   std::string_view password() const { return password_; }
@@ -54,6 +73,7 @@ public:
   void close();
 
   [[nodiscard]] Write_error send_message(const void*, std::size_t);
+  // The message is moved from only on success.
   [[nodiscard]] Write_error send_message(Message&&);
 
   [[nodiscard]] Write_error send_logout_request();
@@ -63,32 +83,66 @@ private:
   Client* client_ = nullptr;
   Connection_handler* handler_ = nullptr;
   asio::any_io_executor io_executor_;
-  asio::ip::tcp::endpoint endpoint_;
+  Endpoint endpoint_;
+  std::vector<Endpoint> alternate_endpoints_;
   std::string username_;
   std::string password_;
   std::string session_;
+  Timeouts timeouts_;
   std::uint64_t next_sequence_number_ = 1;
   bool has_session_ended_ = false;
-  std::optional<Tcp_connection> connection_;
+  // Racing to log in, or the one that has
+  Slab_list<Tcp_connection> connections_;
+  Tcp_connection* line_ = nullptr;
+  // One of those raced has logged in, and is or was the line.
+  bool logged_in_ = false;
+  // Neither the line nor, before one logged in, any of those raced has
+  // closed for a reason not worth retrying.
+  bool retryable_ = true;
   Reconnect_timer reconnect_timer_;
-  std::chrono::seconds reconnect_next_delay_ = std::chrono::seconds::zero();
+  Reconnect_backoff reconnect_backoff_;
+  Arbitration_metrics arbitration_metrics_;
+  // Messages delivered first since the client last chose the fastest line
+  std::uint64_t recent_wins_ = 0;
 
+  void start_connections();
   void schedule_reconnect();
 
   [[nodiscard]] Write_error send_packet(Write_packet&&);
+  [[nodiscard]] Write_error send_to_line(Write_packet&&);
 
   // Called by Client
   friend class Client;
   bool is_handler_set() const;
+  std::size_t poll();
+
+  void on_win() {
+    arbitration_metrics_.on_win();
+    ++recent_wins_;
+  }
+
+  void on_lead(std::chrono::nanoseconds lead) {
+    arbitration_metrics_.on_lead(lead);
+  }
+
+  void on_duplicate(std::optional<std::chrono::nanoseconds> lag) {
+    arbitration_metrics_.on_duplicate(lag);
+  }
+
+  std::uint64_t take_recent_wins() { return std::exchange(recent_wins_, 0); }
 
   // Called by Tcp_connection
   friend class Tcp_connection;
+  std::chrono::microseconds busy_poll() const;
+  bool polled_reads() const;
+  const Timeouts& timeouts() const { return timeouts_; }
   Login_request_packet on_connect_success();
   [[nodiscard]] Disconnect_reason
-  on_login_success(const Login_accepted_packet&);
-  void on_sequenced_data(const void*, std::size_t);
+  on_login_success(Tcp_connection&, const Login_accepted_packet&);
+  [[nodiscard]] std::error_code on_sequenced_data(const void*, std::size_t);
+  void on_read_batch_complete();
   void on_end_of_session();
-  void on_closed(Disconnect_reason);
+  void on_closed(Tcp_connection&, Disconnect_reason);
 };
 
 } // namespace bc::soup::client
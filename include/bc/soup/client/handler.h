@@ -8,6 +8,7 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string_view>
 
 namespace bc::soup {
@@ -33,6 +34,31 @@ protected:
   Client_handler& operator=(Client_handler&&) = default;
 };
 
+struct Sequenced_data {
+  std::uint64_t sequence_number = 0;
+  const void* data = nullptr;
+  std::size_t size = 0;
+};
+
+// Optional alternative to Client_handler::sequenced_data: receives every new
+// message parsed from one read of a connection's socket in a single call.
+// The payloads point into the socket's receive buffer and are valid only
+// until the call returns.
+class Sequenced_batch_handler {
+public:
+  virtual void sequenced_data(std::span<const Sequenced_data>) = 0;
+
+protected:
+  Sequenced_batch_handler() = default;
+  ~Sequenced_batch_handler() = default;
+
+  Sequenced_batch_handler(const Sequenced_batch_handler&) = default;
+  Sequenced_batch_handler& operator=(const Sequenced_batch_handler&) = default;
+
+  Sequenced_batch_handler(Sequenced_batch_handler&&) = default;
+  Sequenced_batch_handler& operator=(Sequenced_batch_handler&&) = default;
+};
+
 class Connection_handler {
 public:
   virtual void connecting(const asio::ip::tcp::endpoint&) = 0;
@@ -52,7 +78,7 @@ public:
   virtual void protocol_violation(Packet_error) = 0;
 
   virtual void disconnect(Disconnect_reason) = 0;
-  virtual void reconnect_scheduled(std::chrono::seconds) = 0;
+  virtual void reconnect_scheduled(std::chrono::milliseconds) = 0;
 
 protected:
   Connection_handler() = default;
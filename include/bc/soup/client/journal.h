@@ -0,0 +1,63 @@
+#ifndef INCLUDE_BC_SOUP_CLIENT_JOURNAL_H
+#define INCLUDE_BC_SOUP_CLIENT_JOURNAL_H
+
+#include "bc/soup/file_store.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace bc::soup::client {
+
+class Client;
+
+// Sequenced messages received by a Client, kept in a File_store, together
+// with the session they belong to in a sidecar file, "<filename>.session".
+// The next sequence number to request is one past the last message, so the
+// journal is also the client's checkpoint.
+//
+// Each message is written to the file before it is delivered, so a message
+// a handler has seen survives a crash of the process. Surviving a crash of
+// the host needs sync(), e.g. after each read batch or on a timer.
+class Journal {
+public:
+  Journal() = default;
+  explicit Journal(std::string_view);
+
+  void set_filename(std::string_view);
+  // See File_store::set_shared_tail(), e.g. for a drop copy in another
+  // process to read what the client receives.
+  void set_shared_tail(std::string_view);
+
+  [[nodiscard]] std::error_code open();
+  [[nodiscard]] std::error_code close();
+
+  [[nodiscard]] std::error_code sync();
+
+  // Empty until the first login to a session
+  std::string_view session() const { return session_; }
+  std::uint64_t next_sequence_number() const;
+
+  // E.g. for a Replay_scheduler, once a server::Standby journaling into it
+  // has been promoted
+  File_store& store() { return store_; }
+
+private:
+  File_store store_;
+  std::string filename_;
+  std::string session_;
+
+  std::string session_filename() const;
+
+  // Called by Client
+  friend class Client;
+  [[nodiscard]] std::error_code set_session(std::string_view);
+  [[nodiscard]] std::error_code add(const void*, std::size_t);
+  File_store::Cursor cursor(std::uint64_t);
+};
+
+} // namespace bc::soup::client
+
+#endif
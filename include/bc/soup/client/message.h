@@ -47,6 +47,11 @@ public:
 private:
   static constexpr char packet_type_ = Unsequenced_data_packet::packet_type;
   Write_packet packet_;
+
+  // Called by Client and Connection
+  friend class Client;
+  friend class Connection;
+  Write_packet& packet() { return packet_; }
 };
 
 } // namespace bc::soup::client
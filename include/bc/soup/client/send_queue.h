@@ -0,0 +1,14 @@
+#ifndef INCLUDE_BC_SOUP_CLIENT_SEND_QUEUE_H
+#define INCLUDE_BC_SOUP_CLIENT_SEND_QUEUE_H
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/client/message.h"
+#include "bc/soup/send_queue.h"
+
+namespace bc::soup::client {
+
+using Send_queue = soup::Send_queue<Client, Message>;
+
+} // namespace bc::soup::client
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef INCLUDE_BC_SOUP_CLIENT_SESSION_H
+#define INCLUDE_BC_SOUP_CLIENT_SESSION_H
+
+#include "bc/soup/async_signal.h"
+#include "bc/soup/client/handler.h"
+#include "bc/soup/message_batch.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace bc::soup::client {
+
+class Client;
+
+// Coroutine interface to a Client's sequenced data. Becomes the client's
+// handler and batch handler, and copies each batch into buffers that are
+// reused from one batch to the next, so a coroutine can co_await
+// next_messages() in a loop, and other operations in between. While messages
+// are pending it returns without suspending, and once the buffers have grown
+// nothing is allocated beyond the coroutine frame, which asio recycles.
+//
+// Must be used from the client's io_context and destroyed only after it has
+// stopped or been destroyed.
+class Session final : public Client_handler, public Sequenced_batch_handler {
+public:
+  Session(asio::any_io_executor, Client&);
+
+  Session(const Session&) = delete;
+  Session& operator=(const Session&) = delete;
+
+  Session(Session&&) = delete;
+  Session& operator=(Session&&) = delete;
+
+  // Messages received since the previous call, waiting for at least one.
+  // They are valid until the next call. Empty once the session has ended or
+  // after cancel().
+  asio::awaitable<std::span<const Sequenced_data>> next_messages();
+
+  // Wakes a coroutine waiting in next_messages().
+  void cancel();
+
+  bool has_session_ended() const { return has_session_ended_; }
+
+  // Client_handler
+  void sequenced_data(std::uint64_t, const void*, std::size_t) override;
+  void end_of_session() override;
+
+  // Sequenced_batch_handler
+  void sequenced_data(std::span<const Sequenced_data>) override;
+
+private:
+  Message_batch<Sequenced_data> batch_;
+  Async_signal readable_;
+  bool has_session_ended_ = false;
+  bool cancelled_ = false;
+};
+
+} // namespace bc::soup::client
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef INCLUDE_BC_SOUP_CLIENT_SPIN_RUNNER_H
+#define INCLUDE_BC_SOUP_CLIENT_SPIN_RUNNER_H
+
+#include <asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace bc::soup::client {
+
+class Client;
+
+// Busy-polls Clients with polled reads on the calling thread, which is
+// expected to be pinned to its own core. Each iteration reads whatever has
+// arrived on the clients' sockets with a non-blocking recv. Timers, connects
+// and writes still complete through the io_context, which is polled without
+// blocking after any iteration that made progress and otherwise once per
+// io_poll_interval, so an idle spin makes no other syscalls in between.
+//
+// The io_context must not be run by any other thread.
+class Spin_runner {
+public:
+  explicit Spin_runner(asio::io_context&);
+  Spin_runner(asio::io_context&, Client&);
+
+  Spin_runner(const Spin_runner&) = delete;
+  Spin_runner& operator=(const Spin_runner&) = delete;
+
+  Spin_runner(Spin_runner&&) = delete;
+  Spin_runner& operator=(Spin_runner&&) = delete;
+
+  // The client must use the runner's io_context.
+  void add(Client&);
+  void set_io_poll_interval(std::chrono::nanoseconds);
+
+  // Returns the number of reads and io_context handlers that ran.
+  std::size_t poll_once();
+  // Spins until stop() is called.
+  void run();
+
+  // May be called from any thread.
+  void stop() { stopped_.store(true, std::memory_order_relaxed); }
+
+private:
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Default value
+  static constexpr std::chrono::microseconds default_io_poll_interval{50};
+
+  asio::io_context* io_context_ = nullptr;
+  std::vector<Client*> clients_;
+  std::chrono::nanoseconds io_poll_interval_ = default_io_poll_interval;
+  std::chrono::steady_clock::time_point next_io_poll_;
+  std::atomic<bool> stopped_{false};
+};
+
+} // namespace bc::soup::client
+
+#endif
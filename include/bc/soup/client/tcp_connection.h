@@ -2,8 +2,10 @@
 #define INCLUDE_BC_SOUP_CLIENT_TCP_CONNECTION_H
 
 #include "bc/soup/connection_state.h"
+#include "bc/soup/endpoint.h"
 #include "bc/soup/heartbeat_timer.h"
 #include "bc/soup/login_timer.h"
+#include "bc/soup/metrics.h"
 #include "bc/soup/socket.h"
 #include "bc/soup/types.h"
 
@@ -13,7 +15,7 @@
 #include <string_view>
 
 namespace bc::soup {
-class Read_packet;
+class Packet_view;
 class Write_packet;
 } // namespace bc::soup
 
@@ -22,12 +24,13 @@ namespace bc::soup::client {
 class Connection;
 class Connection_handler;
 
-class Tcp_connection final : public Socket::Handler,
+class Tcp_connection final : public Socket_handler,
                              public Login_timer::Handler,
                              public Heartbeat_timer::Handler {
 public:
+  // To the connection's endpoint or one of its alternates
   Tcp_connection(asio::any_io_executor, Connection&, Connection_handler&,
-                 std::size_t);
+                 const Endpoint&, std::size_t, Metrics_registry&);
   ~Tcp_connection() = default;
 
   Tcp_connection(const Tcp_connection&) = delete;
@@ -41,7 +44,8 @@ public:
 
   void read_failure(asio::error_code) override;
   void read_failure(Packet_error) override;
-  void read_success(const Read_packet&) override;
+  void read_success(const Packet_view&) override;
+  void read_batch_complete() override;
   void read_aborted() override;
   void read_end_of_file() override;
 
@@ -63,7 +67,8 @@ public:
 private:
   Connection* connection_ = nullptr;
   Connection_handler* handler_ = nullptr;
-  Socket socket_;
+  Connection_metrics metrics_;
+  Basic_socket<Tcp_connection> socket_;
   Connection_state state_;
   Login_timer login_timer_;
   Heartbeat_timer heartbeat_timer_;
@@ -71,7 +76,7 @@ private:
   bool login_timer_stopped_ = true;
   bool heartbeat_timer_stopped_ = true;
 
-  [[nodiscard]] Packet_error process_packet(const Read_packet&);
+  [[nodiscard]] Packet_error process_packet(const Packet_view&);
 
   void process_debug(const void*, std::size_t);
 
@@ -92,6 +97,9 @@ private:
   [[nodiscard]] Write_error send_packet(Write_packet&&);
   [[nodiscard]] Write_error send_debug_packet(std::string_view);
   void close();
+  // Another of the connections raced has logged in.
+  void supersede();
+  std::size_t poll();
 };
 
 } // namespace bc::soup::client
@@ -0,0 +1,16 @@
+#ifndef INCLUDE_BC_SOUP_CRC32C_H
+#define INCLUDE_BC_SOUP_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bc::soup {
+
+// CRC-32C (Castagnoli) of the bytes given, continuing from the CRC of those
+// before them, or from zero for the first. Uses the SSE4.2 crc32 instruction
+// where the CPU has it, and a table otherwise.
+std::uint32_t crc32c(std::uint32_t, const void*, std::size_t);
+
+} // namespace bc::soup
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef INCLUDE_BC_SOUP_ENDPOINT_H
+#define INCLUDE_BC_SOUP_ENDPOINT_H
+
+#include <asio.hpp>
+
+namespace bc::soup {
+
+// A TCP or Unix-domain stream endpoint, either of which converts to it.
+using Endpoint = asio::generic::stream_protocol::endpoint;
+
+bool is_tcp(const Endpoint&);
+
+// Unspecified, i.e. default-constructed, for a Unix-domain endpoint.
+asio::ip::tcp::endpoint to_tcp(const Endpoint&);
+
+} // namespace bc::soup
+
+#endif
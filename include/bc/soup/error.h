@@ -15,7 +15,10 @@ enum class Error {
   invalid_session,
   endpoint_in_use,
   username_in_use,
-  handler_not_set
+  handler_not_set,
+  journal_mismatch,
+  invalid_timeouts,
+  invalid_reconnect_policy
 };
 
 const std::error_category& soup_category() noexcept;
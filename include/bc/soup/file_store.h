@@ -1,10 +1,15 @@
 #ifndef INCLUDE_BC_SOUP_FILE_STORE_H
 #define INCLUDE_BC_SOUP_FILE_STORE_H
 
+#include "bc/soup/expected.h"
 #include "bc/soup/rw_packets.h"
+#include "bc/soup/tail_cache.h"
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <span>
 #include <string>
 #include <string_view>
@@ -87,8 +92,41 @@ private:
   Buffer message_;
 };
 
+struct Shared_tail;
+
 class File_store {
 public:
+  // Reads the store forward in batches through one buffer it reuses, so a
+  // replay of any length holds no more than a batch in memory. Messages
+  // added meanwhile are read in their turn: a cursor at the end of the store
+  // reads nothing until there are more. Valid as long as its store is
+  // neither moved nor destroyed.
+  class Cursor {
+  public:
+    std::size_t next_sequence_number() const { return next_; }
+    void seek(std::size_t sequence_number) { next_ = sequence_number; }
+
+    // Reads the messages from the next sequence number on, up to the number
+    // of messages and the number of bytes of the file given, but at least
+    // one message if there is any and the number of messages allows.
+    [[nodiscard]] std::error_code read(std::size_t, std::size_t);
+
+    // Those read last, valid until the next read
+    std::span<const std::span<const std::byte>> messages() const {
+      return messages_;
+    }
+
+  private:
+    File_store* store_ = nullptr;
+    std::size_t next_ = 1;
+    Buffer buffer_;
+    std::vector<std::span<const std::byte>> messages_;
+
+    // Called by File_store
+    friend class File_store;
+    Cursor(File_store&, std::size_t);
+  };
+
   File_store() = default;
   explicit File_store(std::string_view);
   ~File_store();
@@ -100,26 +138,137 @@ public:
   File_store& operator=(File_store&&) noexcept;
 
   void set_filename(std::string_view);
+  // Keeps the most recent messages added, up to the number of messages and
+  // of payload bytes given, for get() to serve from memory: copied into
+  // Messages, shared as Frames. Off by default.
+  void set_cache_limits(std::size_t, std::size_t);
+  // Records carry a CRC-32C of their size and payload, checked by open(),
+  // which truncates the file at the first bad record, e.g. one torn by a
+  // crash. Must match how the file was written: checking a file written
+  // without them would truncate it at its first record. Off by default.
+  //
+  // Without checksums, open() still truncates a record cut short.
+  void set_checksums(bool);
+  // The number of bytes at the end of the file that open() checks, where a
+  // crash leaves torn writes; zero, the default, checks the whole file.
+  void set_verify_limit(std::size_t);
+  // Bypasses the page cache with O_DIRECT, so a long session neither evicts
+  // other pages nor stalls add() on writeback. Records are gathered in an
+  // aligned buffer and written whole blocks at a time once it fills, the
+  // last partial block on sync() and close(); get() reads the rest of the
+  // file into aligned buffers of its own and the unwritten part from memory.
+  // Until written, added messages do not survive a crash of the process.
+  // open() fails where the file system does not support it. Off by default.
+  void set_direct_io(bool);
+  // Records carry the time they were added, or were received if given to
+  // add(), and open() builds a sparse index of them, an entry for the first
+  // message in each 4 KiB block of the file, for sequence_number_at(). Must
+  // match how the file was written. Off by default.
+  void set_timestamps(bool);
+  // Publishes how far the file has been written, after open() and each
+  // add(), in a Shared_tail at the path given, e.g. under /dev/shm, for
+  // Tail_readers in other processes. Not with direct I/O, where the file
+  // lags add(): open() fails with EINVAL. Empty, the default, for none.
+  void set_shared_tail(std::string_view);
 
   [[nodiscard]] std::error_code open();
   [[nodiscard]] std::error_code close();
 
   [[nodiscard]] std::error_code add(const void*, std::size_t);
   [[nodiscard]] std::error_code add(const void*, const void*);
+  // With timestamps; a time before the last message's is stored as that,
+  // so that they never decrease.
+  [[nodiscard]] std::error_code add(const void*, std::size_t,
+                                    std::chrono::system_clock::time_point);
   [[nodiscard]] std::error_code get(std::size_t, std::size_t,
                                     std::vector<Message>&);
+  // Appends frames rather than copies: those still cached are shared with
+  // the cache, and the rest share one block read from the file.
+  [[nodiscard]] std::error_code get(std::size_t, std::size_t,
+                                    std::vector<Frame>&);
+
+  // Asks the kernel to read ahead the messages from first to last, e.g. the
+  // next range of a replay. Those still cached are skipped.
+  [[nodiscard]] std::error_code will_need(std::size_t, std::size_t) const;
+
+  // The first message with a timestamp at or after the time given, or the
+  // next sequence number if there is none. Reads at most a block of the file
+  // past a binary search of the index.
+  [[nodiscard]] expected<std::size_t, std::error_code>
+  sequence_number_at(std::chrono::system_clock::time_point);
+
+  // From the sequence number given
+  Cursor cursor(std::size_t);
 
   [[nodiscard]] std::error_code sync();
 
   std::size_t next_sequence_number() const;
 
 private:
+  // The size then, where on, the CRC-32C and the timestamp
+  static constexpr std::size_t max_header_size =
+      sizeof(std::uint16_t) + sizeof(std::uint32_t) + sizeof(std::uint64_t);
+  static constexpr off_t time_index_block_size = 4096;
+  // The alignment O_DIRECT needs of offsets, sizes and memory
+  static constexpr std::size_t direct_block_size = 4096;
+  // Holds the largest record after a partial block
+  static constexpr std::size_t direct_buffer_size = 128 * 1024;
+
+  struct Aligned_delete {
+    void operator()(std::byte*) const;
+  };
+
+  struct Time_entry {
+    // Nanoseconds since the epoch
+    std::int64_t time = 0;
+    std::size_t sequence_number = 0;
+  };
+
   std::string filename_;
   int fd_ = -1;
+  // Where the next message is written, so adding needs no lseek
+  off_t end_ = 0;
   std::vector<off_t> offsets_;
+  Tail_cache cache_;
+  bool checksums_ = false;
+  std::size_t verify_limit_ = 0;
+  bool direct_io_ = false;
+  // With direct I/O, the file from the block at tail_offset_ to end_, not
+  // yet written, or written only as far as a partial block
+  std::unique_ptr<std::byte[], Aligned_delete> tail_;
+  off_t tail_offset_ = 0;
+  // With direct I/O, the blocks read from the file, grown as needed and
+  // kept for the next read
+  std::unique_ptr<std::byte[], Aligned_delete> read_blocks_;
+  std::size_t read_blocks_size_ = 0;
+  bool timestamps_ = false;
+  std::vector<Time_entry> time_index_;
+  std::int64_t last_timestamp_ = 0;
+  std::string shared_tail_filename_;
+  Shared_tail* shared_tail_ = nullptr;
+
+  // Aligned for direct I/O
+  static std::unique_ptr<std::byte[], Aligned_delete>
+  allocate_blocks(std::size_t);
 
-  [[nodiscard]] std::error_code set_offsets();
-  [[nodiscard]] std::error_code get(Message&);
+  std::size_t header_size() const;
+  std::size_t timestamp_offset() const;
+  std::int64_t record_timestamp(const std::byte*) const;
+  void index_time(std::size_t, std::int64_t);
+  void publish();
+  [[nodiscard]] std::error_code recover();
+  std::size_t first_bad_record(const std::byte*, std::size_t) const;
+  [[nodiscard]] std::error_code start_direct_io();
+  [[nodiscard]] std::error_code append_direct(std::span<const std::byte>,
+                                              const void*, std::size_t);
+  [[nodiscard]] std::error_code write_tail(bool);
+  [[nodiscard]] std::error_code read_range(off_t, std::size_t, std::byte*);
+  [[nodiscard]] std::error_code validate(std::size_t, std::size_t) const;
+  // The last message up to the one given that is not cached
+  std::size_t last_uncached(std::size_t) const;
+  std::size_t records_size(std::size_t, std::size_t) const;
+  [[nodiscard]] std::error_code read_records(std::size_t, std::size_t,
+                                             std::byte*);
 };
 
 } // namespace bc::soup
@@ -0,0 +1,119 @@
+#ifndef INCLUDE_BC_SOUP_HANDLER_MEMORY_H
+#define INCLUDE_BC_SOUP_HANDLER_MEMORY_H
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace bc::soup {
+
+// Fixed block for the operation state of one outstanding asio operation,
+// after asio's allocation example. An owner keeps one per kind of operation
+// it never has more than one of in flight, e.g. a socket's read, so the
+// operation reuses the block each time instead of going to the heap.
+// Requests that do not fit, or arrive while the block is in use, fall back
+// to operator new.
+class Handler_memory {
+public:
+  Handler_memory() = default;
+  ~Handler_memory() = default;
+
+  Handler_memory(const Handler_memory&) = delete;
+  Handler_memory& operator=(const Handler_memory&) = delete;
+
+  // Only while no operation is using it, like the owner itself
+  Handler_memory(Handler_memory&&) noexcept {}
+  Handler_memory& operator=(Handler_memory&&) noexcept { return *this; }
+
+  void* allocate(std::size_t size) {
+    if (!in_use_ && size <= storage_.size()) {
+      in_use_ = true;
+      return storage_.data();
+    }
+    return ::operator new(size);
+  }
+
+  void deallocate(void* pointer) {
+    if (pointer == storage_.data())
+      in_use_ = false;
+    else
+      ::operator delete(pointer);
+  }
+
+private:
+  // Enough for a read, write or wait with its handler and executor.
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Block size
+  static constexpr std::size_t size = 512;
+
+  alignas(std::max_align_t) std::array<std::byte, size> storage_{};
+  bool in_use_ = false;
+};
+
+// Allocator that draws from a Handler_memory.
+template <typename T>
+class Handler_allocator {
+public:
+  using value_type = T;
+
+  explicit Handler_allocator(Handler_memory& memory) : memory_(&memory) {}
+
+  template <typename U>
+  // NOLINTNEXTLINE(*-explicit-constructor): Allocator rebinding
+  Handler_allocator(const Handler_allocator<U>& other) noexcept
+      : memory_(other.memory_) {}
+
+  T* allocate(std::size_t n) const {
+    return static_cast<T*>(memory_->allocate(sizeof(T) * n));
+  }
+
+  void deallocate(T* pointer, std::size_t) const {
+    memory_->deallocate(pointer);
+  }
+
+  template <typename U>
+  bool operator==(const Handler_allocator<U>& other) const noexcept {
+    return memory_ == other.memory_;
+  }
+
+private:
+  template <typename>
+  friend class Handler_allocator;
+
+  Handler_memory* memory_ = nullptr;
+};
+
+// Wraps a completion handler so that asio allocates the operation through
+// its associated Handler_allocator.
+template <typename Handler>
+class Allocating_handler {
+public:
+  using allocator_type = Handler_allocator<Handler>;
+
+  Allocating_handler(Handler_memory& memory, Handler handler)
+      : memory_(&memory), handler_(std::move(handler)) {}
+
+  allocator_type get_allocator() const noexcept {
+    return allocator_type(*memory_);
+  }
+
+  template <typename... Args>
+  void operator()(Args&&... args) {
+    handler_(std::forward<Args>(args)...);
+  }
+
+private:
+  Handler_memory* memory_ = nullptr;
+  Handler handler_;
+};
+
+template <typename Handler>
+Allocating_handler<std::decay_t<Handler>> bind_memory(Handler_memory& memory,
+                                                      Handler&& handler) {
+  return {memory, std::forward<Handler>(handler)};
+}
+
+} // namespace bc::soup
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef INCLUDE_BC_SOUP_HEARTBEAT_TIMER_H
 #define INCLUDE_BC_SOUP_HEARTBEAT_TIMER_H
 
+#include "bc/soup/handler_memory.h"
+
 #include <asio.hpp>
 
 #include <chrono>
@@ -29,7 +31,9 @@ public:
     Handler& operator=(Handler&&) = default;
   };
 
-  Heartbeat_timer(asio::any_io_executor, Handler&, std::chrono::seconds);
+  // The period and the receive timeout
+  Heartbeat_timer(asio::any_io_executor, Handler&, std::chrono::milliseconds,
+                  std::chrono::milliseconds);
 
   void start();
   void stop();
@@ -40,8 +44,11 @@ public:
 private:
   Handler* handler_ = nullptr;
   asio::steady_timer timer_;
-  std::chrono::seconds timeout_ = std::chrono::seconds::zero();
-  std::chrono::seconds no_receive_period_ = std::chrono::seconds::zero();
+  Handler_memory wait_memory_;
+  std::chrono::milliseconds period_ = std::chrono::milliseconds::zero();
+  std::chrono::milliseconds timeout_ = std::chrono::milliseconds::zero();
+  std::chrono::milliseconds no_receive_period_ =
+      std::chrono::milliseconds::zero();
   std::uint32_t receive_count_ = 0;
   std::uint32_t send_count_ = 0;
   bool started_ = false;
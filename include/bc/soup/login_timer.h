@@ -1,6 +1,8 @@
 #ifndef INCLUDE_BC_SOUP_LOGIN_TIMER_H
 #define INCLUDE_BC_SOUP_LOGIN_TIMER_H
 
+#include "bc/soup/handler_memory.h"
+
 #include <asio.hpp>
 
 #include <chrono>
@@ -27,7 +29,7 @@ public:
     Handler& operator=(Handler&&) = default;
   };
 
-  Login_timer(asio::any_io_executor, Handler&, std::chrono::seconds);
+  Login_timer(asio::any_io_executor, Handler&, std::chrono::milliseconds);
 
   void start();
   void stop();
@@ -35,7 +37,8 @@ public:
 private:
   Handler* handler_ = nullptr;
   asio::steady_timer timer_;
-  std::chrono::seconds timeout_ = std::chrono::seconds::zero();
+  Handler_memory wait_memory_;
+  std::chrono::milliseconds timeout_ = std::chrono::milliseconds::zero();
   bool started_ = false;
   bool wait_pending_ = false;
   bool stopped_signaled_ = false;
@@ -0,0 +1,54 @@
+#ifndef INCLUDE_BC_SOUP_MESSAGE_BATCH_H
+#define INCLUDE_BC_SOUP_MESSAGE_BATCH_H
+
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace bc::soup {
+
+// Collects copies of received messages until they are taken as one batch.
+// Entry has data and size members; the rest is copied as is. Taking a batch
+// swaps it with the previous one, so once both have grown to the largest
+// batch seen no further allocation takes place.
+template <typename Entry>
+class Message_batch {
+public:
+  bool empty() const { return pending_.entries.empty(); }
+
+  void add(Entry entry) {
+    const auto* bytes = static_cast<const std::byte*>(entry.data);
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Message bytes
+    pending_.data.insert(pending_.data.end(), bytes, bytes + entry.size);
+    // Set when taken, as data may yet be reallocated
+    entry.data = nullptr;
+    pending_.entries.push_back(entry);
+  }
+
+  // The entries and their data are valid until the next call.
+  std::span<const Entry> take() {
+    std::swap(pending_, taken_);
+    pending_.data.clear();
+    pending_.entries.clear();
+    std::size_t offset = 0;
+    for (auto& entry : taken_.entries) {
+      entry.data = taken_.data.data() + offset;
+      offset += entry.size;
+    }
+    return taken_.entries;
+  }
+
+private:
+  struct Batch {
+    std::vector<std::byte> data;
+    std::vector<Entry> entries;
+  };
+
+  Batch pending_;
+  Batch taken_;
+};
+
+} // namespace bc::soup
+
+#endif
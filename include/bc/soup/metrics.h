@@ -0,0 +1,320 @@
+#ifndef INCLUDE_BC_SOUP_METRICS_H
+#define INCLUDE_BC_SOUP_METRICS_H
+
+#include "bc/soup/endpoint.h"
+#include "bc/soup/logical_packets.h"
+
+#include <asio.hpp>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace bc::soup {
+
+// Log-linear histogram of nanosecond latencies in the style of HdrHistogram:
+// each power of two is split into sub_bucket_count linear buckets, so any
+// recorded value is reported within 1 / sub_bucket_count of its true value.
+class Latency_histogram {
+public:
+  static constexpr std::size_t sub_bucket_bits = 3;
+  static constexpr std::size_t sub_bucket_count = 1U << sub_bucket_bits;
+  // Values of 2^(max_exponent + 1) ns (about 68 s) or more share the last
+  // bucket.
+  static constexpr std::size_t max_exponent = 35;
+  static constexpr std::size_t bucket_count =
+      sub_bucket_count * (max_exponent - sub_bucket_bits + 2);
+
+  static constexpr std::size_t bucket_index(std::uint64_t ns) {
+    if (ns < sub_bucket_count)
+      return static_cast<std::size_t>(ns);
+    const auto exponent = static_cast<std::size_t>(std::bit_width(ns)) - 1;
+    if (exponent > max_exponent)
+      return bucket_count - 1;
+    const auto shift = exponent - sub_bucket_bits;
+    const auto sub_bucket =
+        static_cast<std::size_t>(ns >> shift) - sub_bucket_count;
+    return sub_bucket_count * (shift + 1) + sub_bucket;
+  }
+
+  // Highest value that maps to the bucket.
+  static constexpr std::uint64_t bucket_value(std::size_t i) {
+    if (i < sub_bucket_count)
+      return i;
+    const auto shift = (i / sub_bucket_count) - 1;
+    const std::uint64_t low = (sub_bucket_count + (i % sub_bucket_count))
+                              << shift;
+    return low + (std::uint64_t{1} << shift) - 1;
+  }
+
+  void record(std::chrono::nanoseconds);
+  void merge(const Latency_histogram&);
+
+  std::uint64_t count() const;
+  // Smallest recorded bucket value at or above the given fraction of samples,
+  // e.g. percentile(0.99). Zero if empty.
+  std::chrono::nanoseconds percentile(double) const;
+
+  std::array<std::uint64_t, bucket_count>& buckets() { return buckets_; }
+
+  const std::array<std::uint64_t, bucket_count>& buckets() const {
+    return buckets_;
+  }
+
+private:
+  std::array<std::uint64_t, bucket_count> buckets_{};
+};
+
+struct Traffic_counts {
+  std::uint64_t packets = 0;
+  std::uint64_t bytes = 0;
+};
+
+// Packets are counted by logical packet type; types are indexed in the order
+// below, with unknown types counted as other.
+constexpr std::size_t packet_type_count = 11;
+
+constexpr std::size_t packet_type_index(char packet_type) {
+  switch (packet_type) {
+  case Debug_packet::packet_type:
+    return 0;
+  case Login_accepted_packet::packet_type:
+    return 1;
+  case Login_rejected_packet::packet_type:
+    return 2;
+  case Sequenced_data_packet::packet_type:
+    return 3;
+  case Server_heartbeat_packet::packet_type:
+    return 4;
+  case End_of_session_packet::packet_type:
+    return 5;
+  case Login_request_packet::packet_type:
+    return 6;
+  case Unsequenced_data_packet::packet_type:
+    return 7;
+  case Client_heartbeat_packet::packet_type:
+    return 8;
+  case Logout_request_packet::packet_type:
+    return 9;
+  default:
+    return packet_type_count - 1;
+  }
+}
+
+class Metrics_registry;
+
+// Counters for one TCP connection. Updated only from the thread running the
+// connection's io_context and read from any thread: every field is an atomic
+// written with a relaxed load and store rather than a read-modify-write, as
+// there is a single writer.
+class Connection_metrics {
+public:
+  struct Snapshot {
+    asio::ip::tcp::endpoint remote_endpoint;
+    std::array<Traffic_counts, packet_type_count> received_by_type{};
+    std::array<Traffic_counts, packet_type_count> sent_by_type{};
+    std::uint64_t write_queue_depth = 0;
+    std::uint64_t write_queue_high_water_mark = 0;
+    // Longest interval between two received packets, of any type. Peers
+    // send heartbeats only when otherwise idle, so this is the gap the
+    // heartbeat timeout is measured against.
+    std::chrono::nanoseconds max_receive_gap = std::chrono::nanoseconds::zero();
+    // Time from a packet being queued for writing to its write completing.
+    Latency_histogram write_latency;
+
+    Traffic_counts received() const;
+    Traffic_counts received(char) const;
+    Traffic_counts sent() const;
+    Traffic_counts sent(char) const;
+
+    // Sums counts and depths; takes the larger high-water mark and gap.
+    void merge(const Snapshot&);
+  };
+
+  Connection_metrics(Metrics_registry&, const asio::ip::tcp::endpoint&);
+  ~Connection_metrics();
+
+  Connection_metrics(const Connection_metrics&) = delete;
+  Connection_metrics& operator=(const Connection_metrics&) = delete;
+
+  Connection_metrics(Connection_metrics&&) = delete;
+  Connection_metrics& operator=(Connection_metrics&&) = delete;
+
+  Snapshot snapshot() const;
+
+  // Called by Socket
+  void on_read(char packet_type, std::size_t size,
+               std::chrono::steady_clock::time_point now) {
+    const auto i = packet_type_index(packet_type);
+    increment(received_packets_[i], 1);
+    increment(received_bytes_[i], size);
+    if (last_read_ != std::chrono::steady_clock::time_point()) {
+      const auto gap = static_cast<std::uint64_t>(
+          std::chrono::nanoseconds(now - last_read_).count());
+      if (gap > max_receive_gap_.load(std::memory_order_relaxed))
+        max_receive_gap_.store(gap, std::memory_order_relaxed);
+    }
+    last_read_ = now;
+  }
+
+  void on_write_queued(std::size_t depth) {
+    write_queue_depth_.store(depth, std::memory_order_relaxed);
+    if (depth > write_queue_high_water_mark_.load(std::memory_order_relaxed))
+      write_queue_high_water_mark_.store(depth, std::memory_order_relaxed);
+  }
+
+  void on_write_complete(char packet_type, std::size_t size,
+                         std::chrono::nanoseconds latency, std::size_t depth) {
+    const auto i = packet_type_index(packet_type);
+    increment(sent_packets_[i], 1);
+    increment(sent_bytes_[i], size);
+    const auto ns = latency.count() < 0
+                        ? std::uint64_t{0}
+                        : static_cast<std::uint64_t>(latency.count());
+    increment(write_latency_[Latency_histogram::bucket_index(ns)], 1);
+    write_queue_depth_.store(depth, std::memory_order_relaxed);
+  }
+
+private:
+  using Counter = std::atomic<std::uint64_t>;
+
+  Metrics_registry* registry_ = nullptr;
+  asio::ip::tcp::endpoint remote_endpoint_;
+  std::array<Counter, packet_type_count> received_packets_{};
+  std::array<Counter, packet_type_count> received_bytes_{};
+  std::array<Counter, packet_type_count> sent_packets_{};
+  std::array<Counter, packet_type_count> sent_bytes_{};
+  Counter write_queue_depth_{0};
+  Counter write_queue_high_water_mark_{0};
+  Counter max_receive_gap_{0};
+  std::array<Counter, Latency_histogram::bucket_count> write_latency_{};
+  // Owned by the writer; not read by snapshot()
+  std::chrono::steady_clock::time_point last_read_;
+
+  static void increment(Counter& counter, std::uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+};
+
+// How one of a Client's redundant connections, i.e. lines, fares against the
+// others at delivering sequenced data. Kept for the life of the line, across
+// reconnects, and updated and read as Connection_metrics is.
+class Arbitration_metrics {
+public:
+  struct Snapshot {
+    Endpoint endpoint;
+    // Messages the line delivered first
+    std::uint64_t wins = 0;
+    // Messages another line had already delivered
+    std::uint64_t duplicates = 0;
+    // How long before another line delivered the same message, recorded for
+    // each other line that did
+    Latency_histogram lead;
+    // How long after the line that delivered it first
+    Latency_histogram lag;
+
+    // Fraction of the messages the line delivered that it delivered first
+    double win_rate() const;
+  };
+
+  Arbitration_metrics(Metrics_registry&, const Endpoint&);
+  ~Arbitration_metrics();
+
+  Arbitration_metrics(const Arbitration_metrics&) = delete;
+  Arbitration_metrics& operator=(const Arbitration_metrics&) = delete;
+
+  Arbitration_metrics(Arbitration_metrics&&) = delete;
+  Arbitration_metrics& operator=(Arbitration_metrics&&) = delete;
+
+  Snapshot snapshot() const;
+
+  // Called by Client
+  void on_win() { increment(wins_, 1); }
+
+  void on_lead(std::chrono::nanoseconds lead) {
+    increment(lead_[Latency_histogram::bucket_index(to_ns(lead))], 1);
+  }
+
+  // Untimed when the first delivery is too long ago to be remembered
+  void on_duplicate(std::optional<std::chrono::nanoseconds> lag) {
+    increment(duplicates_, 1);
+    if (lag)
+      increment(lag_[Latency_histogram::bucket_index(to_ns(*lag))], 1);
+  }
+
+private:
+  using Counter = std::atomic<std::uint64_t>;
+
+  Metrics_registry* registry_ = nullptr;
+  Endpoint endpoint_;
+  Counter wins_{0};
+  Counter duplicates_{0};
+  std::array<Counter, Latency_histogram::bucket_count> lead_{};
+  std::array<Counter, Latency_histogram::bucket_count> lag_{};
+
+  static std::uint64_t to_ns(std::chrono::nanoseconds duration) {
+    return duration.count() < 0 ? std::uint64_t{0}
+                                : static_cast<std::uint64_t>(duration.count());
+  }
+
+  static void increment(Counter& counter, std::uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+};
+
+// The set of live connection metrics owned by a Server or Client, plus the
+// totals of connections that have closed. The mutex is taken only when a
+// connection opens or closes and when a snapshot is taken, never on the
+// per-packet path.
+class Metrics_registry {
+public:
+  struct Snapshot {
+    std::chrono::steady_clock::time_point time;
+    // Live connections
+    std::vector<Connection_metrics::Snapshot> connections;
+    // Live and closed connections
+    Connection_metrics::Snapshot total;
+    std::size_t closed_connections = 0;
+    // A Client's lines, in the order they were added
+    std::vector<Arbitration_metrics::Snapshot> lines;
+  };
+
+  Metrics_registry() = default;
+
+  Metrics_registry(const Metrics_registry&) = delete;
+  Metrics_registry& operator=(const Metrics_registry&) = delete;
+
+  Metrics_registry(Metrics_registry&&) = delete;
+  Metrics_registry& operator=(Metrics_registry&&) = delete;
+
+  Snapshot snapshot() const;
+
+private:
+  mutable std::mutex mutex_;
+  std::vector<const Connection_metrics*> connections_;
+  Connection_metrics::Snapshot closed_;
+  std::size_t closed_connections_ = 0;
+  std::vector<const Arbitration_metrics*> lines_;
+
+  // Called by Connection_metrics
+  friend class Connection_metrics;
+  void add(const Connection_metrics&);
+  void remove(const Connection_metrics&);
+
+  // Called by Arbitration_metrics
+  friend class Arbitration_metrics;
+  void add(const Arbitration_metrics&);
+  void remove(const Arbitration_metrics&);
+};
+
+} // namespace bc::soup
+
+#endif
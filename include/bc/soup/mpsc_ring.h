@@ -0,0 +1,92 @@
+#ifndef INCLUDE_BC_SOUP_MPSC_RING_H
+#define INCLUDE_BC_SOUP_MPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace bc::soup {
+
+// Bounded lock-free queue for many producer threads and one consumer thread,
+// after Dmitry Vyukov's bounded MPMC queue. Each cell carries a sequence
+// number that tells a producer whether the cell is free for its position and
+// the consumer whether the cell holds the value for its position, so a push
+// is one compare-exchange and a pop is plain loads and stores. Capacity is
+// rounded up to a power of two of at least 2.
+template <typename T>
+class Mpsc_ring {
+public:
+  explicit Mpsc_ring(std::size_t capacity)
+      : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+        // NOLINTNEXTLINE(*-avoid-c-arrays): Dynamically-allocated array
+        cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+    for (std::size_t i = 0; i <= mask_; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  Mpsc_ring(const Mpsc_ring&) = delete;
+  Mpsc_ring& operator=(const Mpsc_ring&) = delete;
+
+  Mpsc_ring(Mpsc_ring&&) = delete;
+  Mpsc_ring& operator=(Mpsc_ring&&) = delete;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // May be called from any thread. The value is moved from only on success.
+  [[nodiscard]] bool try_push(T&& value) {
+    auto position = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& cell = cells_[position & mask_];
+      const auto sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::intptr_t>(sequence) -
+                        static_cast<std::intptr_t>(position);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Must only be called from the consumer thread.
+  [[nodiscard]] bool try_pop(T& value) {
+    auto& cell = cells_[head_ & mask_];
+    const auto sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != head_ + 1)
+      return false;
+    value = std::move(cell.value);
+    cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+    return true;
+  }
+
+private:
+  static constexpr std::size_t cache_line_size = 64;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::size_t mask_ = 0;
+  // NOLINTNEXTLINE(*-avoid-c-arrays): Dynamically-allocated array
+  std::unique_ptr<Cell[]> cells_;
+  // Producers and the consumer write to separate cache lines.
+  alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+  alignas(cache_line_size) std::size_t head_ = 0;
+};
+
+} // namespace bc::soup
+
+#endif
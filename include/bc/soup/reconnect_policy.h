@@ -0,0 +1,51 @@
+#ifndef INCLUDE_BC_SOUP_RECONNECT_POLICY_H
+#define INCLUDE_BC_SOUP_RECONNECT_POLICY_H
+
+#include "bc/soup/constants.h"
+
+#include <chrono>
+#include <random>
+
+namespace bc::soup {
+
+// How long to wait before each attempt to reconnect a line that has gone.
+// The ceiling on the delay starts at the initial delay and is multiplied
+// after each attempt, up to the maximum. With full jitter each delay is
+// drawn uniformly from zero to the ceiling, so that clients dropped at once
+// do not all come back at once.
+struct Reconnect_policy {
+  std::chrono::milliseconds initial_delay = reconnect_initial_delay;
+  std::chrono::milliseconds max_delay = reconnect_max_delay;
+  int multiplier = reconnect_delay_multiplier;
+  bool full_jitter = true;
+  // The first attempt after a line that logged in goes, without delay
+  bool immediate_first_retry = true;
+};
+
+// The delays of a Reconnect_policy, attempt by attempt.
+class Reconnect_backoff {
+public:
+  explicit Reconnect_backoff(const Reconnect_policy& = {});
+  // Seeded, e.g. for a reproducible sequence of jittered delays
+  Reconnect_backoff(const Reconnect_policy&, std::minstd_rand::result_type);
+
+  void set_policy(const Reconnect_policy&);
+  const Reconnect_policy& policy() const { return policy_; }
+
+  std::chrono::milliseconds next_delay();
+  // So the next delay is the first again, e.g. on stopping
+  void reset();
+  // As reset(), and the next attempt may be immediate: only a line that has
+  // logged in is retried without delay.
+  void on_login();
+
+private:
+  Reconnect_policy policy_;
+  std::chrono::milliseconds ceiling_ = std::chrono::milliseconds::zero();
+  bool first_ = false;
+  std::minstd_rand random_;
+};
+
+} // namespace bc::soup
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef INCLUDE_BC_SOUP_RECONNECT_TIMER_H
 #define INCLUDE_BC_SOUP_RECONNECT_TIMER_H
 
+#include "bc/soup/handler_memory.h"
+
 #include <asio.hpp>
 
 #include <chrono>
@@ -29,7 +31,7 @@ public:
 
   Reconnect_timer(asio::any_io_executor, Handler&);
 
-  void start(std::chrono::seconds);
+  void start(std::chrono::milliseconds);
   void stop();
 
   bool started() const { return started_; }
@@ -37,6 +39,7 @@ public:
 private:
   Handler* handler_ = nullptr;
   asio::steady_timer timer_;
+  Handler_memory wait_memory_;
   bool started_ = false;
   std::uint32_t epoch_ = 0;
 
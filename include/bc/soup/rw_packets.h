@@ -80,6 +80,36 @@ private:
   Buffer payload_;
 };
 
+// A complete packet, header included, held in someone else's buffer, e.g. a
+// Socket's receive buffer. Valid only while that buffer is unchanged.
+class Packet_view {
+public:
+  Packet_view(const void* data, std::size_t size)
+      : data_(static_cast<const std::byte*>(data)), size_(size) {}
+
+  std::uint16_t packet_size() const;
+
+  char packet_type() const {
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Packet type location
+    return static_cast<char>(data_[packet_size_length]);
+  }
+
+  const void* payload_data() const {
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Payload location
+    return data_ + packet_header_length;
+  }
+
+  std::size_t payload_size() const { return size_ - packet_header_length; }
+
+  const void* data() const { return data_; }
+
+  std::size_t size() const { return size_; }
+
+private:
+  const std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
 class Write_packet {
 public:
   enum class Resize_result {
@@ -0,0 +1,166 @@
+#ifndef INCLUDE_BC_SOUP_SEND_QUEUE_H
+#define INCLUDE_BC_SOUP_SEND_QUEUE_H
+
+#include "bc/soup/constants.h"
+#include "bc/soup/mpsc_ring.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace bc::soup {
+
+// Hands messages from any number of threads to a sink (server::Port or
+// client::Client) that may only be used from its io_context's thread.
+// Producers push into a lock-free ring; the first push after the ring has
+// been drained posts a single drain to the io_context, which then sends
+// everything queued in batches. A message the sink refuses with
+// Write_error::buffer_full is held until resume() is called, normally from the
+// sink handler's write_buffer_empty; other failures are reported to the
+// handler, if set, and the message dropped.
+//
+// The queue must outlive any drain it has posted, i.e. destroy it only after
+// the io_context has stopped or been destroyed.
+template <typename Sink, typename Message>
+class Send_queue {
+public:
+  class Handler {
+  public:
+    virtual void send_failure(Write_error, Message&&) = 0;
+
+  protected:
+    Handler() = default;
+    ~Handler() = default;
+
+    Handler(const Handler&) = default;
+    Handler& operator=(const Handler&) = default;
+
+    Handler(Handler&&) = default;
+    Handler& operator=(Handler&&) = default;
+  };
+
+  Send_queue(asio::any_io_executor io_executor, Sink& sink,
+             std::size_t capacity)
+      : io_executor_(io_executor), sink_(&sink), ring_(capacity) {}
+
+  Send_queue(asio::any_io_executor io_executor, Sink& sink,
+             std::size_t capacity, Handler& handler)
+      : io_executor_(io_executor),
+        sink_(&sink),
+        handler_(&handler),
+        ring_(capacity) {}
+
+  Send_queue(const Send_queue&) = delete;
+  Send_queue& operator=(const Send_queue&) = delete;
+
+  Send_queue(Send_queue&&) = delete;
+  Send_queue& operator=(Send_queue&&) = delete;
+
+  // Called from the io_context thread
+
+  void set_handler(Handler& handler) { handler_ = &handler; }
+
+  // Messages sent per drain before yielding to other handlers.
+  void set_batch_size(std::size_t batch_size) {
+    batch_size_ = std::max<std::size_t>(batch_size, 1);
+  }
+
+  void resume() {
+    if (!blocked_)
+      return;
+    auto message = std::move(*blocked_);
+    blocked_.reset();
+    if (send(std::move(message)))
+      on_drain();
+  }
+
+  // Called from any thread
+
+  std::size_t capacity() const { return ring_.capacity(); }
+
+  // The message is moved from only on success.
+  [[nodiscard]] Write_error push(Message&& message) {
+    if (message.payload_size() == 0)
+      return Write_error::empty_buffer;
+    if (!ring_.try_push(std::move(message)))
+      return Write_error::buffer_full;
+    schedule_drain();
+    return Write_error::none;
+  }
+
+  [[nodiscard]] Write_error push(const void* data, std::size_t size) {
+    if (size == 0)
+      return Write_error::empty_buffer;
+    if (!data)
+      return Write_error::null_buffer;
+    if (size > max_payload_length)
+      return Write_error::message_too_long;
+    Message message(data, static_cast<std::uint16_t>(size));
+    return push(std::move(message));
+  }
+
+private:
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Default value
+  static constexpr std::size_t default_batch_size = 256;
+
+  asio::any_io_executor io_executor_;
+  Sink* sink_ = nullptr;
+  Handler* handler_ = nullptr;
+  Mpsc_ring<Message> ring_;
+  std::size_t batch_size_ = default_batch_size;
+  // Consumer only
+  std::optional<Message> blocked_;
+  // Set by the push that posts a drain and cleared by the drain before it
+  // pops. Both sides exchange, so a push that sees it set is ordered before
+  // the drain's pops and its message is picked up. A drain that finds a
+  // message held returns without clearing it, so while one is held only the
+  // first push posts a drain, and the rest wait for resume().
+  std::atomic<bool> drain_scheduled_{false};
+
+  void schedule_drain() {
+    if (!drain_scheduled_.exchange(true, std::memory_order_acq_rel))
+      asio::post(io_executor_, [this] { on_drain(); });
+  }
+
+  void on_drain() {
+    if (blocked_)
+      return;
+    drain_scheduled_.exchange(false, std::memory_order_acq_rel);
+    drain();
+  }
+
+  void drain() {
+    Message message;
+    for (std::size_t n = 0; n < batch_size_; ++n) {
+      if (!ring_.try_pop(message))
+        return;
+      if (!send(std::move(message)))
+        return;
+    }
+    schedule_drain();
+  }
+
+  // Returns false if the sink is full and the message is held.
+  bool send(Message&& message) {
+    const auto error = sink_->send_message(std::move(message));
+    if (error == Write_error::none)
+      return true;
+    if (error == Write_error::buffer_full) {
+      blocked_.emplace(std::move(message));
+      return false;
+    }
+    if (handler_)
+      handler_->send_failure(error, std::move(message));
+    return true;
+  }
+};
+
+} // namespace bc::soup
+
+#endif
@@ -1,10 +1,13 @@
 #ifndef INCLUDE_BC_SOUP_SERVER_ACCEPTOR_H
 #define INCLUDE_BC_SOUP_SERVER_ACCEPTOR_H
 
+#include "bc/soup/endpoint.h"
 #include "bc/soup/expected.h"
 #include "bc/soup/server/port.h"
 #include "bc/soup/server/tcp_connection.h"
+#include "bc/soup/slab_list.h"
 #include "bc/soup/socket_acceptor.h"
+#include "bc/soup/timeouts.h"
 #include "bc/soup/types.h"
 
 #include <asio.hpp>
@@ -29,15 +32,19 @@ class Port_handler;
 
 class Acceptor final : public Socket_acceptor::Handler {
 public:
-  Acceptor(asio::any_io_executor, const asio::ip::tcp::endpoint&, Server&,
-           Acceptor_handler*);
+  Acceptor(asio::any_io_executor, const Endpoint&, Server&, Acceptor_handler*);
 
   void accept_failure(asio::error_code) override;
-  void accept_success(asio::ip::tcp::socket&&) override;
+  void accept_success(asio::generic::stream_protocol::socket&&) override;
 
   void set_handler(Acceptor_handler&);
   void set_write_packets_limit(std::size_t);
+  // Packets of at least this size are sent without copying, where the
+  // platform supports it. Zero, the default, turns it off.
+  void set_zero_copy_threshold(std::size_t);
   void set_debug_banner(std::string_view);
+  // For connections accepted from then on; the server's by default.
+  [[nodiscard]] std::error_code set_timeouts(const Timeouts&);
 
   [[nodiscard]] expected<Port*, std::error_code> add_port(std::string_view,
                                                           std::string_view);
@@ -45,19 +52,21 @@ public:
   [[nodiscard]] expected<Port*, std::error_code>
   add_port(std::string_view, std::string_view, Port_handler&);
 
-  const asio::ip::tcp::endpoint& endpoint() const { return endpoint_; }
+  const Endpoint& endpoint() const { return endpoint_; }
 
 private:
   static constexpr std::size_t default_write_packets_limit = 100;
 
   Server* server_ = nullptr;
   Acceptor_handler* handler_ = nullptr;
-  asio::ip::tcp::endpoint endpoint_;
+  Endpoint endpoint_;
   Socket_acceptor acceptor_;
   std::list<Port> ports_;
   std::size_t write_packets_limit_ = default_write_packets_limit;
+  std::size_t zero_copy_threshold_ = 0;
   std::string debug_banner_;
-  std::list<Tcp_connection> connections_;
+  Timeouts timeouts_;
+  Slab_list<Tcp_connection> connections_;
 
   [[nodiscard]] expected<Port*, std::error_code>
   add_port(std::string_view, std::string_view, Port_handler*);
@@ -47,6 +47,10 @@ public:
 private:
   static constexpr char packet_type_ = Sequenced_data_packet::packet_type;
   Write_packet packet_;
+
+  // Called by Port
+  friend class Port;
+  Write_packet& packet() { return packet_; }
 };
 
 } // namespace bc::soup::server
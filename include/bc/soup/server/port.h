@@ -37,6 +37,7 @@ public:
   bool has_session_ended() const { return has_session_ended_; }
 
   [[nodiscard]] Write_error send_message(const void*, std::size_t);
+  // The message is moved from only on success.
   [[nodiscard]] Write_error send_message(Message&&);
 
   [[nodiscard]] Write_error send_debug(std::string_view);
@@ -0,0 +1,85 @@
+#ifndef INCLUDE_BC_SOUP_SERVER_PORT_SESSION_H
+#define INCLUDE_BC_SOUP_SERVER_PORT_SESSION_H
+
+#include "bc/soup/async_signal.h"
+#include "bc/soup/message_batch.h"
+#include "bc/soup/server/handler.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace bc::soup::server {
+
+class Message;
+class Port;
+
+struct Unsequenced_data {
+  const void* data = nullptr;
+  std::size_t size = 0;
+};
+
+// Coroutine interface to a Port. Becomes the port's handler and passes every
+// event but unsequenced_data on to the given handler, if any, so a coroutine
+// can co_await send() instead of handling write_buffer_empty, and
+// next_messages() instead of handling unsequenced_data. Received messages are
+// copied into buffers that are reused from one batch to the next.
+//
+// Must be used from the server's io_context and destroyed only after it has
+// stopped or been destroyed.
+class Port_session final : public Port_handler {
+public:
+  Port_session(asio::any_io_executor, Port&);
+  Port_session(asio::any_io_executor, Port&, Port_handler&);
+
+  Port_session(const Port_session&) = delete;
+  Port_session& operator=(const Port_session&) = delete;
+
+  Port_session(Port_session&&) = delete;
+  Port_session& operator=(Port_session&&) = delete;
+
+  // Sends the message, waiting while the connection's write buffer is full.
+  // Returns buffer_full only if cancel() is called while waiting. The data
+  // must remain valid until the send completes.
+  asio::awaitable<Write_error> send(const void*, std::size_t);
+  // The message is moved from only on success.
+  asio::awaitable<Write_error> send(Message&&);
+
+  // Messages received since the previous call, waiting for at least one.
+  // They are valid until the next call. Empty after a disconnect, a logout
+  // request or cancel().
+  asio::awaitable<std::span<const Unsequenced_data>> next_messages();
+
+  // Wakes coroutines waiting in send() or next_messages().
+  void cancel();
+
+  // Port_handler
+  void login_success(const Login_accepted_packet&) override;
+  void unsequenced_data(const void*, std::size_t) override;
+  void logout_request() override;
+  void write_buffer_empty() override;
+  void debug(std::string_view) override;
+  void transport_error(asio::error_code, std::string_view) override;
+  void protocol_violation(Packet_error) override;
+  void disconnect(Disconnect_reason) override;
+
+private:
+  Port* port_ = nullptr;
+  Port_handler* handler_ = nullptr;
+  Message_batch<Unsequenced_data> batch_;
+  Async_signal readable_;
+  Async_signal writable_;
+  // Incremented by cancel(), so each waiting send() sees it
+  std::uint64_t cancellations_ = 0;
+  bool read_interrupted_ = false;
+
+  void interrupt_reads();
+};
+
+} // namespace bc::soup::server
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef INCLUDE_BC_SOUP_SERVER_REPLAY_SCHEDULER_H
+#define INCLUDE_BC_SOUP_SERVER_REPLAY_SCHEDULER_H
+
+#include "bc/soup/handler_memory.h"
+#include "bc/soup/tail_cache.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <vector>
+
+namespace bc::soup {
+class File_store;
+}
+
+namespace bc::soup::server {
+
+class Port;
+
+// Sends ports that log in behind the messages they are missing from the
+// session's File_store, taking turns so that no one replay holds the
+// io_context or the disk. Each turn sends a port up to a quantum of payload
+// bytes, then the next port has its turn; rounds are separated by a trip
+// through the io_context, so live traffic is handled between them. An
+// optional rate limit caps the replay bytes sent per second across all
+// ports, and the kernel is asked to read ahead each port's next range.
+//
+// A port is replayed until it reaches the end of the store, which live
+// messages keep extending: while is_replaying(), live messages for the port
+// go only to the store. A port whose write buffer fills is retried after a
+// millisecond, or at once if write_buffer_empty() is passed on from its
+// handler.
+//
+// Must be used from the server's io_context and destroyed only after it has
+// stopped or been destroyed.
+class Replay_scheduler {
+public:
+  struct Progress {
+    const Port* port = nullptr;
+    // Of the next message to send and of the end of the store
+    std::uint64_t next_sequence_number = 0;
+    std::uint64_t end_sequence_number = 0;
+    std::uint64_t messages_sent = 0;
+    std::uint64_t bytes_sent = 0;
+    // Reading the store failed, so the replay has stopped; the port is
+    // still is_replaying() until removed or added again.
+    std::error_code error;
+  };
+
+  static constexpr std::size_t default_quantum = 64 * 1024;
+
+  Replay_scheduler(asio::any_io_executor, File_store&);
+
+  Replay_scheduler(const Replay_scheduler&) = delete;
+  Replay_scheduler& operator=(const Replay_scheduler&) = delete;
+
+  Replay_scheduler(Replay_scheduler&&) = delete;
+  Replay_scheduler& operator=(Replay_scheduler&&) = delete;
+
+  void set_quantum(std::size_t);
+  // Bytes per second; zero, the default, for no limit.
+  void set_rate_limit(std::size_t);
+
+  // Starts replaying from the port's next sequence number, e.g. from its
+  // handler's login_success(). A port that is caught up is left alone.
+  void add(Port&);
+  // Sets the port's next sequence number to the first message stored at or
+  // after the time given, for a store with timestamps, so that add() replays
+  // from there, e.g. when a client that logged in from sequence number 0
+  // asks to resume from a time instead.
+  [[nodiscard]] std::error_code rewind(Port&,
+                                       std::chrono::system_clock::time_point);
+  // E.g. on the port's disconnect; a port that is disconnected when its turn
+  // comes is removed anyway.
+  void remove(const Port&);
+  void write_buffer_empty(const Port&);
+  void stop();
+
+  bool is_replaying(const Port&) const;
+  std::vector<Progress> progress() const;
+
+private:
+  // Messages read from the store at a time
+  static constexpr std::size_t batch_messages = 256;
+  static constexpr std::chrono::milliseconds retry_delay{1};
+
+  enum class Turn_result {
+    progress,
+    blocked,
+    // Caught up, or the port can no longer be sent to
+    finished,
+    // Reading the store failed
+    failed
+  };
+
+  struct Replay {
+    Port* port = nullptr;
+    // Read from the store and not yet sent
+    std::vector<Frame> frames;
+    std::uint64_t first_sequence_number = 0;
+    std::size_t next_frame = 0;
+    std::uint64_t messages_sent = 0;
+    std::uint64_t bytes_sent = 0;
+    std::error_code error;
+  };
+
+  File_store* store_ = nullptr;
+  asio::steady_timer timer_;
+  Handler_memory wait_memory_;
+  std::size_t quantum_ = default_quantum;
+  std::size_t rate_limit_ = 0;
+  // Token bucket for the rate limit, holding up to a quantum. Negative after
+  // a message overdraws it.
+  double tokens_ = 0.0;
+  std::chrono::steady_clock::time_point refilled_;
+  std::vector<Replay> replays_;
+  // The next turn, in the order added
+  std::size_t next_turn_ = 0;
+  // A sooner round cancels a later one, whose wait is pending until then
+  std::size_t waits_pending_ = 0;
+
+  void schedule(std::chrono::steady_clock::duration);
+  void run_round();
+  Turn_result take_turn(Replay&);
+  void refill();
+  void fail(std::error_code);
+  std::vector<Replay>::iterator find(const Port&);
+  std::vector<Replay>::const_iterator find(const Port&) const;
+};
+
+} // namespace bc::soup::server
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef INCLUDE_BC_SOUP_SERVER_REPLICATION_H
+#define INCLUDE_BC_SOUP_SERVER_REPLICATION_H
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/client/handler.h"
+#include "bc/soup/endpoint.h"
+#include "bc/soup/expected.h"
+#include "bc/soup/handler_memory.h"
+
+#include <asio.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <system_error>
+
+namespace bc::soup {
+class File_store;
+}
+
+namespace bc::soup::client {
+class Connection_handler;
+class Journal;
+} // namespace bc::soup::client
+
+namespace bc::soup::server {
+
+class Port;
+
+// A standby acknowledges how far it has replicated with unsequenced data of
+// this form: 'R', then its next sequence number, big-endian.
+struct Replication_acknowledgement {
+  static constexpr char type = 'R';
+  static constexpr std::size_t size = 1 + sizeof(std::uint64_t);
+
+  std::uint64_t next_sequence_number = 0;
+
+  std::array<std::byte, size> encode() const;
+  // False if the data is not an acknowledgement
+  [[nodiscard]] bool decode(const void*, std::size_t);
+};
+
+// Keeps a hot standby of a primary server's session: logs in to a port of
+// the primary set aside for it, as a client, and journals every sequenced
+// message, so the journal's store holds the session as the primary's does.
+// Acknowledges each read's messages once journaled, and the position every
+// acknowledgement interval besides, for the primary's Replica to measure the
+// lag from.
+//
+// On failover, promote() stops replicating and sets the standby server's
+// ports to the end of the journal, so that a client logging in rewinds its
+// port to where it left off, for a Replay_scheduler on the journal's store
+// to send it the rest. The server's session is the journal's.
+class Standby final : public client::Client_handler,
+                      public client::Sequenced_batch_handler {
+public:
+  static constexpr std::chrono::milliseconds default_acknowledgement_interval{
+      100};
+
+  // The journal must be open, and outlive the standby.
+  Standby(asio::any_io_executor, client::Journal&);
+
+  void sequenced_data(std::uint64_t, const void*, std::size_t) override;
+  void sequenced_data(std::span<const client::Sequenced_data>) override;
+  void end_of_session() override;
+
+  void set_acknowledgement_interval(std::chrono::milliseconds);
+
+  // To the primary; the username and password of its port for the standby
+  // are set on the connection returned. More than one for redundant lines.
+  [[nodiscard]] expected<client::Connection*, std::error_code>
+  add_connection(const Endpoint&, client::Connection_handler&);
+
+  [[nodiscard]] std::error_code start();
+  void stop();
+
+  // Stops replicating, then sets each port given to the next sequence
+  // number of the journal. Call before starting the standby server.
+  void promote(std::span<Port* const>);
+
+  std::uint64_t next_sequence_number() const {
+    return client_.next_sequence_number();
+  }
+  bool has_session_ended() const { return client_.has_session_ended(); }
+  bool is_promoted() const { return promoted_; }
+
+  // May be called from any thread.
+  Metrics_registry::Snapshot metrics() const { return client_.metrics(); }
+
+private:
+  client::Journal* journal_ = nullptr;
+  client::Client client_;
+  asio::steady_timer timer_;
+  Handler_memory wait_memory_;
+  std::chrono::milliseconds acknowledgement_interval_ =
+      default_acknowledgement_interval;
+  bool started_ = false;
+  bool promoted_ = false;
+
+  void acknowledge();
+  void schedule_acknowledgement();
+};
+
+// The primary's side of a Standby: measures the replication lag from the
+// acknowledgements the standby sends on its port, passed on from the port's
+// handler, against the store the standby is sent. Used from the server's
+// io_context.
+class Replica {
+public:
+  struct Lag {
+    // Acknowledged, i.e. journaled by the standby
+    std::uint64_t next_sequence_number = 0;
+    // In the store and not yet acknowledged
+    std::uint64_t messages = 0;
+    // Since the standby last acknowledged all the store held, to within an
+    // acknowledgement interval; zero if it has acknowledged all it holds.
+    std::chrono::nanoseconds time = std::chrono::nanoseconds::zero();
+    // Since the last acknowledgement, e.g. to tell a standby that has gone
+    std::chrono::nanoseconds since_acknowledged =
+        std::chrono::nanoseconds::zero();
+  };
+
+  explicit Replica(const File_store&);
+
+  // Returns false if the data is not an acknowledgement.
+  [[nodiscard]] bool unsequenced_data(const void*, std::size_t);
+
+  Lag lag() const;
+
+private:
+  // Positions of the store remembered while not yet acknowledged
+  static constexpr std::size_t max_samples = 1024;
+
+  struct Sample {
+    std::uint64_t next_sequence_number = 0;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  const File_store* store_ = nullptr;
+  std::uint64_t acknowledged_ = 0;
+  std::chrono::steady_clock::time_point acknowledged_time_;
+  // When the store was last known to hold no more than was acknowledged
+  std::chrono::steady_clock::time_point caught_up_time_;
+  std::deque<Sample> samples_;
+};
+
+} // namespace bc::soup::server
+
+#endif
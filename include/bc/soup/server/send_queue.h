@@ -0,0 +1,14 @@
+#ifndef INCLUDE_BC_SOUP_SERVER_SEND_QUEUE_H
+#define INCLUDE_BC_SOUP_SERVER_SEND_QUEUE_H
+
+#include "bc/soup/send_queue.h"
+#include "bc/soup/server/message.h"
+#include "bc/soup/server/port.h"
+
+namespace bc::soup::server {
+
+using Send_queue = soup::Send_queue<Port, Message>;
+
+} // namespace bc::soup::server
+
+#endif
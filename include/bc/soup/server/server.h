@@ -1,12 +1,15 @@
 #ifndef INCLUDE_BC_SOUP_SERVER_SERVER_H
 #define INCLUDE_BC_SOUP_SERVER_SERVER_H
 
+#include "bc/soup/endpoint.h"
 #include "bc/soup/expected.h"
+#include "bc/soup/metrics.h"
 #include "bc/soup/server/acceptor.h"
+#include "bc/soup/slab_list.h"
+#include "bc/soup/timeouts.h"
 
 #include <asio.hpp>
 
-#include <list>
 #include <string>
 #include <string_view>
 #include <system_error>
@@ -20,15 +23,26 @@ public:
   explicit Server(asio::any_io_executor);
 
   [[nodiscard]] std::error_code set_session(std::string_view);
+  // For acceptors added from then on, which may set their own.
+  [[nodiscard]] std::error_code set_timeouts(const Timeouts&);
 
+  // A TCP endpoint, or a Unix-domain one for clients on the same host. A
+  // Unix-domain socket file must not already exist, and is left in place
+  // when the server stops; handlers are given default-constructed TCP
+  // endpoints for its connections.
   [[nodiscard]] expected<Acceptor*, std::error_code>
-  add_acceptor(const asio::ip::tcp::endpoint&);
+  add_acceptor(const Endpoint&);
 
   [[nodiscard]] expected<Acceptor*, std::error_code>
-  add_acceptor(const asio::ip::tcp::endpoint&, Acceptor_handler&);
+  add_acceptor(const Endpoint&, Acceptor_handler&);
 
   std::string_view session() const { return session_; }
 
+  // May be called from any thread.
+  Metrics_registry::Snapshot metrics() const {
+    return metrics_registry_.snapshot();
+  }
+
   [[nodiscard]] std::error_code start();
   void end_session();
   void stop();
@@ -36,11 +50,19 @@ public:
 private:
   asio::any_io_executor io_executor_;
   std::string session_;
-  std::list<Acceptor> acceptors_;
+  Timeouts timeouts_ = Timeouts::server();
+  // Outlives the acceptors and their connections
+  Metrics_registry metrics_registry_;
+  Slab_list<Acceptor> acceptors_;
   bool started_ = false;
 
   [[nodiscard]] expected<Acceptor*, std::error_code>
-  add_acceptor(const asio::ip::tcp::endpoint&, Acceptor_handler*);
+  add_acceptor(const Endpoint&, Acceptor_handler*);
+
+  // Called by Acceptor
+  friend class Acceptor;
+  Metrics_registry& metrics_registry() { return metrics_registry_; }
+  const Timeouts& timeouts() const { return timeouts_; }
 };
 
 } // namespace bc::soup::server
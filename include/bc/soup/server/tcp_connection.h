@@ -4,7 +4,9 @@
 #include "bc/soup/connection_state.h"
 #include "bc/soup/heartbeat_timer.h"
 #include "bc/soup/login_timer.h"
+#include "bc/soup/metrics.h"
 #include "bc/soup/socket.h"
+#include "bc/soup/timeouts.h"
 #include "bc/soup/types.h"
 
 #include <asio.hpp>
@@ -13,7 +15,7 @@
 #include <string_view>
 
 namespace bc::soup {
-class Read_packet;
+class Packet_view;
 class Write_packet;
 } // namespace bc::soup
 
@@ -24,11 +26,15 @@ class Acceptor_handler;
 class Port;
 class Port_handler;
 
-class Tcp_connection final : public Socket::Handler,
+class Tcp_connection final : public Socket_handler,
                              public Login_timer::Handler,
                              public Heartbeat_timer::Handler {
 public:
-  Tcp_connection(asio::any_io_executor, Socket&&, Acceptor&, Acceptor_handler&);
+  Tcp_connection(asio::any_io_executor,
+                 asio::generic::stream_protocol::socket&&, Acceptor&,
+                 Acceptor_handler&, std::size_t write_packets_limit,
+                 std::size_t zero_copy_threshold, const Timeouts&,
+                 Metrics_registry&);
   ~Tcp_connection() = default;
 
   Tcp_connection(const Tcp_connection&) = delete;
@@ -42,7 +48,8 @@ public:
 
   void read_failure(asio::error_code) override;
   void read_failure(Packet_error) override;
-  void read_success(const Read_packet&) override;
+  void read_success(const Packet_view&) override;
+  void read_batch_complete() override;
   void read_aborted() override;
   void read_end_of_file() override;
 
@@ -66,7 +73,8 @@ private:
   Acceptor_handler* acceptor_handler_ = nullptr;
   Port* port_ = nullptr;
   Port_handler* handler_ = nullptr;
-  Socket socket_;
+  Connection_metrics metrics_;
+  Basic_socket<Tcp_connection> socket_;
   Connection_state state_{Connection_state::State::connected};
   Login_timer login_timer_;
   Heartbeat_timer heartbeat_timer_;
@@ -74,7 +82,7 @@ private:
   bool login_timer_stopped_ = true;
   bool heartbeat_timer_stopped_ = true;
 
-  [[nodiscard]] Packet_error process_packet(const Read_packet&);
+  [[nodiscard]] Packet_error process_packet(const Packet_view&);
 
   void process_debug(const void*, std::size_t);
 
@@ -0,0 +1,127 @@
+#ifndef INCLUDE_BC_SOUP_SHARED_TAIL_H
+#define INCLUDE_BC_SOUP_SHARED_TAIL_H
+
+#include "bc/soup/expected.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace bc::soup {
+
+// How far a File_store's journal has been written, kept in a small file of
+// its own for other processes to map, e.g. under /dev/shm. The store
+// publishes after each add() under a seqlock, so a reader sees the end of
+// the journal and the number of messages in it together, and never a
+// message whose write is under way. One writer at a time.
+//
+// The fields are only accessed atomically, through std::atomic_ref, so the
+// layout is that of the file.
+struct Shared_tail {
+  struct Position {
+    // Of the journal, in bytes
+    std::uint64_t end = 0;
+    std::uint64_t messages = 0;
+    // How its records are laid out
+    std::uint64_t flags = 0;
+  };
+
+  static constexpr std::uint64_t checksums = 1;
+  static constexpr std::uint64_t timestamps = 2;
+  // "bcsoupst", once the store has first published
+  static constexpr std::uint64_t magic_value = 0x6263736f75707374;
+
+  // Maps the file given; a writer creates it if need be.
+  [[nodiscard]] static expected<Shared_tail*, std::error_code>
+  map(const std::string&, bool);
+  static void unmap(Shared_tail*);
+
+  // Called by the writer
+  void store(const Position&);
+  // False if the writer is part way through, has never published, or was
+  // stopped part way through and has not published since.
+  [[nodiscard]] bool load(Position&);
+
+  std::uint64_t magic;
+  // Odd while the rest is being written
+  std::uint64_t sequence;
+  std::uint64_t end;
+  std::uint64_t messages;
+  std::uint64_t flags;
+};
+
+// Tails a journal written by a File_store in another process, through the
+// store's Shared_tail, with the journal mapped read only. Reading what has
+// been published makes no system calls, but to double the mapping when the
+// journal outgrows it, and messages are read in place rather than copied.
+//
+// A store reopened after a crash may truncate records it published, which a
+// reader that has read them reports as ESTALE.
+class Tail_reader {
+public:
+  Tail_reader() = default;
+  // The journal's and the Shared_tail's filenames
+  Tail_reader(std::string_view, std::string_view);
+  ~Tail_reader();
+
+  Tail_reader(const Tail_reader&) = delete;
+  Tail_reader& operator=(const Tail_reader&) = delete;
+
+  Tail_reader(Tail_reader&&) = delete;
+  Tail_reader& operator=(Tail_reader&&) = delete;
+
+  void set_filename(std::string_view);
+  void set_tail_filename(std::string_view);
+
+  // Fails with ENOENT until the store has been opened once.
+  [[nodiscard]] std::error_code open();
+  void close();
+
+  std::size_t next_sequence_number() const { return next_; }
+  // Where the next read() starts; a sequence number behind the reader is
+  // found again by walking the journal from its start.
+  void seek(std::size_t);
+
+  // Reads the messages published from the next sequence number on, up to
+  // the number given. Reads nothing while the store is part way through
+  // publishing.
+  [[nodiscard]] std::error_code read(std::size_t);
+
+  // Those read last, valid until the next read
+  std::span<const std::span<const std::byte>> messages() const {
+    return messages_;
+  }
+  // Of messages(), where the journal has timestamps
+  std::span<const std::chrono::system_clock::time_point> timestamps() const {
+    return timestamps_;
+  }
+
+private:
+  static constexpr std::size_t min_map_size = 1024 * 1024;
+  // Before giving up on a read until the next
+  static constexpr int load_attempts = 64;
+
+  std::string filename_;
+  std::string tail_filename_;
+  int fd_ = -1;
+  Shared_tail* tail_ = nullptr;
+  const std::byte* journal_ = nullptr;
+  std::size_t map_size_ = 0;
+  std::size_t next_ = 1;
+  // Where the record with sequence number record_ starts
+  std::uint64_t offset_ = 0;
+  std::size_t record_ = 1;
+  std::vector<std::span<const std::byte>> messages_;
+  std::vector<std::chrono::system_clock::time_point> timestamps_;
+
+  [[nodiscard]] std::error_code map_journal(std::uint64_t);
+};
+
+} // namespace bc::soup
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef INCLUDE_BC_SOUP_SLAB_LIST_H
+#define INCLUDE_BC_SOUP_SLAB_LIST_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bc::soup {
+
+// Doubly-linked list whose nodes are carved out of fixed-size slabs. Elements
+// never move once constructed, insertion reuses freed nodes, and an element
+// can be erased in constant time given only a reference to it.
+template <typename T, std::size_t Slab_size = 64>
+class Slab_list {
+  static_assert(Slab_size > 0);
+
+  struct Links {
+    Links* prev = nullptr;
+    Links* next = nullptr;
+  };
+
+  struct Node {
+    Links links;
+    // NOLINTNEXTLINE(*-avoid-c-arrays): Raw element storage
+    alignas(T) std::byte storage[sizeof(T)];
+
+    T* element() { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+  template <bool Const>
+  class Iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+
+    Iterator() = default;
+
+    template <bool C = Const>
+      requires C
+    // NOLINTNEXTLINE(*-explicit-constructor): iterator to const_iterator
+    Iterator(const Iterator<false>& other) : links_(other.links_) {}
+
+    reference operator*() const {
+      return *reinterpret_cast<Node*>(links_)->element();
+    }
+
+    pointer operator->() const { return &**this; }
+
+    Iterator& operator++() {
+      links_ = links_->next;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    Iterator& operator--() {
+      links_ = links_->prev;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      auto copy = *this;
+      --*this;
+      return copy;
+    }
+
+    friend bool operator==(const Iterator&, const Iterator&) = default;
+
+  private:
+    friend class Slab_list;
+    friend class Iterator<!Const>;
+
+    Links* links_ = nullptr;
+
+    explicit Iterator(const Links* links)
+        : links_(const_cast<Links*>(links)) {}
+  };
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  Slab_list() { root_.prev = root_.next = &root_; }
+
+  ~Slab_list() { clear(); }
+
+  Slab_list(const Slab_list&) = delete;
+  Slab_list& operator=(const Slab_list&) = delete;
+
+  Slab_list(Slab_list&& other) noexcept : Slab_list() { swap(other); }
+
+  Slab_list& operator=(Slab_list&& other) noexcept {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    Node* node = acquire();
+    try {
+      ::new (static_cast<void*>(node->storage))
+          T(std::forward<Args>(args)...);
+    } catch (...) {
+      release(node);
+      throw;
+    }
+    Links& links = node->links;
+    links.prev = root_.prev;
+    links.next = &root_;
+    root_.prev->next = &links;
+    root_.prev = &links;
+    ++size_;
+    return *node->element();
+  }
+
+  // The element must belong to this list.
+  void erase(T& element) {
+    Node* node = node_of(element);
+    Links& links = node->links;
+    links.prev->next = links.next;
+    links.next->prev = links.prev;
+    --size_;
+    element.~T();
+    release(node);
+  }
+
+  void clear() {
+    while (!empty())
+      erase(front());
+  }
+
+  size_type size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  T& front() { return *begin(); }
+
+  const T& front() const { return *begin(); }
+
+  T& back() { return *std::prev(end()); }
+
+  const T& back() const { return *std::prev(end()); }
+
+  iterator begin() { return iterator(root_.next); }
+
+  const_iterator begin() const { return const_iterator(root_.next); }
+
+  iterator end() { return iterator(&root_); }
+
+  const_iterator end() const { return const_iterator(&root_); }
+
+private:
+  Links root_;
+  size_type size_ = 0;
+  Node* free_ = nullptr;
+  // NOLINTNEXTLINE(*-avoid-c-arrays): Dynamically-allocated array
+  std::vector<std::unique_ptr<Node[]>> slabs_;
+
+  static Node* node_of(T& element) {
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Node from element
+    auto* storage =
+        reinterpret_cast<std::byte*>(&element) - offsetof(Node, storage);
+    return reinterpret_cast<Node*>(storage);
+  }
+
+  Node* acquire() {
+    if (!free_) {
+      // NOLINTNEXTLINE(*-avoid-c-arrays): Dynamically-allocated array
+      auto& slab = slabs_.emplace_back(std::make_unique<Node[]>(Slab_size));
+      for (std::size_t i = Slab_size; i > 0; --i)
+        release(&slab[i - 1]);
+    }
+    Node* node = free_;
+    free_ = reinterpret_cast<Node*>(node->links.next);
+    return node;
+  }
+
+  void release(Node* node) {
+    node->links.prev = nullptr;
+    node->links.next = reinterpret_cast<Links*>(free_);
+    free_ = node;
+  }
+
+  void swap(Slab_list& other) noexcept {
+    using std::swap;
+    swap(root_, other.root_);
+    swap(size_, other.size_);
+    swap(free_, other.free_);
+    swap(slabs_, other.slabs_);
+    relink_root();
+    other.relink_root();
+  }
+
+  // After swapping roots, point the first and last nodes back at our root.
+  void relink_root() {
+    if (empty()) {
+      root_.prev = root_.next = &root_;
+      return;
+    }
+    root_.next->prev = &root_;
+    root_.prev->next = &root_;
+  }
+};
+
+} // namespace bc::soup
+
+#endif
@@ -1,102 +1,745 @@
 #ifndef INCLUDE_BC_SOUP_SOCKET_H
 #define INCLUDE_BC_SOUP_SOCKET_H
 
+#include "bc/soup/constants.h"
+#include "bc/soup/endpoint.h"
+#include "bc/soup/handler_memory.h"
+#include "bc/soup/metrics.h"
+#include "bc/soup/packing.h"
 #include "bc/soup/rw_packets.h"
+#include "bc/soup/slab_list.h"
 #include "bc/soup/types.h"
 
 #include <asio.hpp>
 
+#include <cerrno>
+#include <chrono>
 #include <cstddef>
-#include <list>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <utility>
 
 namespace bc::soup {
 
-class Socket {
+class Socket_handler {
 public:
-  class Handler {
-  public:
-    virtual void connect_failure(asio::error_code) = 0;
-    virtual void connect_success() = 0;
+  virtual void connect_failure(asio::error_code) = 0;
+  virtual void connect_success() = 0;
 
-    virtual void read_failure(asio::error_code) = 0;
-    virtual void read_failure(Packet_error) = 0;
-    virtual void read_success(const Read_packet&) = 0;
-    virtual void read_aborted() = 0;
-    virtual void read_end_of_file() = 0;
+  virtual void read_failure(asio::error_code) = 0;
+  virtual void read_failure(Packet_error) = 0;
+  virtual void read_success(const Packet_view&) = 0;
+  virtual void read_batch_complete() = 0;
+  virtual void read_aborted() = 0;
+  virtual void read_end_of_file() = 0;
 
-    virtual void write_failure(asio::error_code) = 0;
-    virtual void write_success(const Write_packet&) = 0;
-    virtual void write_buffer_empty() = 0;
+  virtual void write_failure(asio::error_code) = 0;
+  virtual void write_success(const Write_packet&) = 0;
+  virtual void write_buffer_empty() = 0;
 
-    virtual void closed() = 0;
+  virtual void closed() = 0;
 
-  protected:
-    Handler() = default;
-    ~Handler() = default;
+protected:
+  Socket_handler() = default;
+  ~Socket_handler() = default;
 
-    Handler(const Handler&) = default;
-    Handler& operator=(const Handler&) = default;
+  Socket_handler(const Socket_handler&) = default;
+  Socket_handler& operator=(const Socket_handler&) = default;
 
-    Handler(Handler&&) = default;
-    Handler& operator=(Handler&&) = default;
-  };
+  Socket_handler(Socket_handler&&) = default;
+  Socket_handler& operator=(Socket_handler&&) = default;
+};
+
+// The callbacks a Basic_socket makes, i.e. those of Socket_handler.
+template <typename T>
+concept Socket_handler_like =
+    requires(T& handler, asio::error_code ec, Packet_error error,
+             const Packet_view& read_packet, const Write_packet& write_packet) {
+      handler.connect_failure(ec);
+      handler.connect_success();
+      handler.read_failure(ec);
+      handler.read_failure(error);
+      handler.read_success(read_packet);
+      handler.read_batch_complete();
+      handler.read_aborted();
+      handler.read_end_of_file();
+      handler.write_failure(ec);
+      handler.write_success(write_packet);
+      handler.write_buffer_empty();
+      handler.closed();
+    };
+
+// Once async_read() is called the socket reads continuously into a receive
+// buffer until it is closed or a read fails. Each receive is parsed in place:
+// read_success is called for every complete packet in it, then
+// read_batch_complete once, after which the packet views are invalidated.
+//
+// The handler type is a template parameter so that a connection can name
+// itself: when it is a final class the callbacks are direct calls the
+// compiler can inline into the receive path. Socket dispatches through the
+// abstract Socket_handler instead.
+template <typename Handler_type>
+class Basic_socket {
+public:
+  using Handler = Handler_type;
 
-  explicit Socket(asio::any_io_executor);
-  Socket(asio::any_io_executor, Handler&);
-  explicit Socket(asio::ip::tcp::socket&&);
-  Socket(asio::ip::tcp::socket&&, Handler&);
-  ~Socket() = default;
+  explicit Basic_socket(asio::any_io_executor);
+  Basic_socket(asio::any_io_executor, Handler&);
+  // TCP and Unix-domain sockets convert to a generic one.
+  explicit Basic_socket(asio::generic::stream_protocol::socket&&);
+  Basic_socket(asio::generic::stream_protocol::socket&&, Handler&);
+  ~Basic_socket() = default;
 
-  Socket(const Socket&) = delete;
-  Socket& operator=(const Socket&) = delete;
+  Basic_socket(const Basic_socket&) = delete;
+  Basic_socket& operator=(const Basic_socket&) = delete;
 
-  Socket(Socket&&) noexcept = default;
-  Socket& operator=(Socket&&) noexcept = default;
+  Basic_socket(Basic_socket&&) noexcept = default;
+  Basic_socket& operator=(Basic_socket&&) noexcept = default;
 
   void set_handler(Handler&);
   void set_write_packets_limit(std::size_t);
+  void set_metrics(Connection_metrics&);
 
+  // For IPv4 TCP
   [[nodiscard]] asio::error_code open();
+  [[nodiscard]] asio::error_code open(asio::generic::stream_protocol);
   void shutdown(asio::error_code* = nullptr);
   void close(asio::error_code* = nullptr);
 
   [[nodiscard]] asio::error_code set_no_delay();
+  [[nodiscard]] asio::error_code set_busy_poll(std::chrono::microseconds);
+  // Reads are then performed by poll() rather than by the io_context.
+  [[nodiscard]] asio::error_code set_polled_reads();
+  // Packets of at least the given size are sent with MSG_ZEROCOPY and held
+  // until the kernel reports it is done with them; zero turns it off. Worth
+  // it only for large packets. Packets still held when the socket is closed
+  // are held on with its descriptor, which the kernel goes on sending from,
+  // until then; the socket reports it is closed without waiting.
+  [[nodiscard]] asio::error_code set_zero_copy(std::size_t);
 
-  void async_connect(const asio::ip::tcp::endpoint&);
+  void async_connect(const Endpoint&);
 
   void async_read();
   Write_error async_write(Write_packet&&);
 
-  asio::ip::tcp::endpoint local_endpoint(asio::error_code* = nullptr) const;
-  asio::ip::tcp::endpoint remote_endpoint(asio::error_code* = nullptr) const;
+  // With polled reads, reads whatever has arrived without blocking. Returns
+  // the number of receives, plus one while a connect or write is
+  // outstanding on the io_context; zero means idle.
+  std::size_t poll();
 
-  asio::ip::tcp::socket::executor_type get_executor();
+  Endpoint local_endpoint(asio::error_code* = nullptr) const;
+  Endpoint remote_endpoint(asio::error_code* = nullptr) const;
+
+  asio::generic::stream_protocol::socket::executor_type get_executor();
 
 private:
+  struct Queued_packet {
+    Write_packet packet;
+    // Set only when metrics are recorded
+    std::chrono::steady_clock::time_point queued;
+  };
+
+  struct Held_packet {
+    Write_packet packet;
+    // Released once the kernel has completed every send before this one
+    std::uint32_t send_count = 0;
+  };
+
+  static constexpr std::size_t max_packet_length =
+      packet_size_length + std::numeric_limits<std::uint16_t>::max();
+  // After moving a partial packet to the front there is always room for the
+  // rest of it.
+  static constexpr std::size_t read_buffer_size = 2 * max_packet_length;
+
   Handler* handler_ = nullptr;
-  asio::ip::tcp::socket socket_;
-  Read_packet read_packet_;
-  std::list<Write_packet> write_packets_;
+  Connection_metrics* metrics_ = nullptr;
+  asio::generic::stream_protocol::socket socket_;
+  Buffer read_buffer_;
+  // Unparsed bytes are [read_begin_, read_end_)
+  std::size_t read_begin_ = 0;
+  std::size_t read_end_ = 0;
+  // Nodes are reused, so queueing a packet does not allocate.
+  Slab_list<Queued_packet> write_packets_;
   // NOLINTNEXTLINE(*-avoid-magic-numbers): Default value
   std::size_t write_packets_limit_ = 100;
+  Slab_list<Held_packet> zero_copy_packets_;
+  std::size_t zero_copy_threshold_ = 0;
+  // Zero-copy sends made and completed; the kernel numbers them from zero.
+  std::uint32_t zero_copy_sends_ = 0;
+  std::uint32_t zero_copy_completed_ = 0;
+  // At most one read, one connect or write, and one wait for zero-copy
+  // completions is outstanding at a time.
+  Handler_memory read_memory_;
+  Handler_memory write_memory_;
+  Handler_memory error_memory_;
   bool write_buffer_was_full_ = false;
+  bool polled_reads_ = false;
   bool connect_pending_ = false;
   bool read_pending_ = false;
   bool write_pending_ = false;
+  bool error_wait_pending_ = false;
+  // The packet being written was sent at least partly with MSG_ZEROCOPY.
+  bool zero_copy_write_ = false;
   bool closing_ = false;
   bool closed_signaled_ = false;
 
-  void read_header();
-  void header_received(asio::error_code, std::size_t);
-  void read_payload();
-  void payload_received(asio::error_code, std::size_t);
+  void read_some();
+  asio::mutable_buffer read_space();
+  void bytes_received(asio::error_code, std::size_t);
+  [[nodiscard]] bool parse_packets();
+  void packet_received(const Packet_view&);
   void write_packet();
+  void write_from(std::size_t);
+  void send_zero_copy(std::size_t);
+  void zero_copy_sent(asio::error_code, std::size_t);
   void packet_sent(asio::error_code, std::size_t);
+  void hold_zero_copy_packet(Write_packet&);
+  void wait_for_zero_copy();
+  void release_zero_copy_packets();
+  void drain_zero_copy();
 
   bool is_idle() const;
   void maybe_signal_closed();
 };
 
+namespace detail {
+
+// Reads zero-copy completion notifications from the socket's error queue
+// without blocking. Returns the number of sends completed, given the number
+// before.
+std::uint32_t read_zero_copy_completions(int fd, std::uint32_t completed);
+
+} // namespace detail
+
+using Socket = Basic_socket<Socket_handler>;
+
+extern template class Basic_socket<Socket_handler>;
+
+template <typename Handler_type>
+Basic_socket<Handler_type>::Basic_socket(asio::any_io_executor io_executor)
+    : socket_(io_executor) {}
+
+template <typename Handler_type>
+Basic_socket<Handler_type>::Basic_socket(asio::any_io_executor io_executor,
+                                         Handler& handler)
+    : handler_(&handler), socket_(io_executor) {
+  static_assert(Socket_handler_like<Handler>);
+}
+
+template <typename Handler_type>
+Basic_socket<Handler_type>::Basic_socket(
+    asio::generic::stream_protocol::socket&& socket)
+    : socket_(std::move(socket)) {}
+
+template <typename Handler_type>
+Basic_socket<Handler_type>::Basic_socket(
+    asio::generic::stream_protocol::socket&& socket, Handler& handler)
+    : handler_(&handler), socket_(std::move(socket)) {
+  static_assert(Socket_handler_like<Handler>);
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::set_handler(Handler& handler) {
+  static_assert(Socket_handler_like<Handler>);
+  handler_ = &handler;
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::set_write_packets_limit(
+    std::size_t write_packets_limit) {
+  write_packets_limit_ = write_packets_limit;
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::set_metrics(Connection_metrics& metrics) {
+  metrics_ = &metrics;
+}
+
+template <typename Handler_type>
+asio::error_code Basic_socket<Handler_type>::open() {
+  asio::error_code ec;
+  socket_.open(asio::ip::tcp::v4(), ec);
+  return ec;
+}
+
+template <typename Handler_type>
+asio::error_code
+Basic_socket<Handler_type>::open(asio::generic::stream_protocol protocol) {
+  asio::error_code ec;
+  socket_.open(protocol, ec);
+  return ec;
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::shutdown(asio::error_code* error) {
+  if (socket_.is_open()) {
+    asio::error_code ec;
+    socket_.shutdown(asio::socket_base::shutdown_both, ec);
+    if (error)
+      *error = ec;
+  }
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::close(asio::error_code* error) {
+  closing_ = true;
+  // A polled read has no operation to cancel.
+  if (polled_reads_)
+    read_pending_ = false;
+  if (socket_.is_open()) {
+    asio::error_code ec;
+    // With zero-copy, a send may complete after this, so what is held is
+    // known only once the cancelled operations have finished.
+    if (zero_copy_threshold_ == 0)
+      socket_.close(ec);
+    else
+      socket_.cancel(ec);
+    if (error)
+      *error = ec;
+  }
+  maybe_signal_closed();
+}
+
+template <typename Handler_type>
+asio::error_code Basic_socket<Handler_type>::set_no_delay() {
+  const asio::ip::tcp::no_delay option(true);
+  asio::error_code ec;
+  socket_.set_option(option, ec);
+  return ec;
+}
+
+template <typename Handler_type>
+asio::error_code
+Basic_socket<Handler_type>::set_busy_poll(std::chrono::microseconds busy_poll) {
+#ifdef SO_BUSY_POLL
+  using option_type = asio::detail::socket_option::integer<SOL_SOCKET,
+                                                          SO_BUSY_POLL>;
+  const option_type option(static_cast<int>(busy_poll.count()));
+  asio::error_code ec;
+  socket_.set_option(option, ec);
+  return ec;
+#else
+  (void)busy_poll;
+  return asio::error::operation_not_supported;
+#endif
+}
+
+template <typename Handler_type>
+asio::error_code Basic_socket<Handler_type>::set_polled_reads() {
+  asio::error_code ec;
+  socket_.non_blocking(true, ec);
+  if (!ec)
+    polled_reads_ = true;
+  return ec;
+}
+
+template <typename Handler_type>
+asio::error_code Basic_socket<Handler_type>::set_zero_copy(
+    std::size_t threshold) {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  if (threshold != 0) {
+    using option_type =
+        asio::detail::socket_option::boolean<SOL_SOCKET, SO_ZEROCOPY>;
+    asio::error_code ec;
+    socket_.set_option(option_type(true), ec);
+    if (ec)
+      return ec;
+  }
+  zero_copy_threshold_ = threshold;
+  return {};
+#else
+  (void)threshold;
+  return asio::error::operation_not_supported;
+#endif
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::async_connect(const Endpoint& endpoint) {
+  if (closing_)
+    return;
+  connect_pending_ = true;
+  auto on_completion = [this](asio::error_code ec) {
+    connect_pending_ = false;
+    if (ec) {
+      if (ec != asio::error::operation_aborted)
+        handler_->connect_failure(ec);
+    } else {
+      handler_->connect_success();
+    }
+    maybe_signal_closed();
+  };
+
+  socket_.async_connect(endpoint,
+                        bind_memory(write_memory_, std::move(on_completion)));
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::async_read() {
+  if (closing_ || read_pending_)
+    return;
+  if (read_buffer_.size() == 0)
+    read_buffer_ = Buffer(read_buffer_size);
+  read_some();
+}
+
+template <typename Handler_type>
+Write_error Basic_socket<Handler_type>::async_write(Write_packet&& packet) {
+  if (closing_)
+    return Write_error::disconnected;
+  const auto size = write_packets_.size();
+  if (size == write_packets_limit_) {
+    write_buffer_was_full_ = true;
+    return Write_error::buffer_full;
+  }
+  if (metrics_) {
+    write_packets_.emplace_back(std::move(packet),
+                                std::chrono::steady_clock::now());
+    metrics_->on_write_queued(size + 1);
+  } else {
+    write_packets_.emplace_back(std::move(packet),
+                                std::chrono::steady_clock::time_point());
+  }
+  if (size == 0)
+    write_packet();
+  return Write_error::none;
+}
+
+template <typename Handler_type>
+std::size_t Basic_socket<Handler_type>::poll() {
+  std::size_t progress = 0;
+  while (polled_reads_ && read_pending_) {
+    asio::error_code ec;
+    const auto n = socket_.read_some(read_space(), ec);
+    if (ec == asio::error::would_block || ec == asio::error::try_again)
+      break;
+    ++progress;
+    read_pending_ = false;
+    bytes_received(ec, n);
+    maybe_signal_closed();
+  }
+  if (connect_pending_ || write_pending_)
+    ++progress;
+  return progress;
+}
+
+template <typename Handler_type>
+Endpoint
+Basic_socket<Handler_type>::local_endpoint(asio::error_code* error) const {
+  asio::error_code ec;
+  const auto endpoint = socket_.local_endpoint(ec);
+  if (error)
+    *error = ec;
+  return endpoint;
+}
+
+template <typename Handler_type>
+Endpoint
+Basic_socket<Handler_type>::remote_endpoint(asio::error_code* error) const {
+  asio::error_code ec;
+  const auto endpoint = socket_.remote_endpoint(ec);
+  if (error)
+    *error = ec;
+  return endpoint;
+}
+
+template <typename Handler_type>
+asio::generic::stream_protocol::socket::executor_type
+Basic_socket<Handler_type>::get_executor() {
+  return socket_.get_executor();
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::read_some() {
+  read_pending_ = true;
+  if (polled_reads_)
+    return;
+
+  auto on_completion = [this](asio::error_code ec, std::size_t n) {
+    read_pending_ = false;
+    bytes_received(ec, n);
+    maybe_signal_closed();
+  };
+
+  socket_.async_read_some(read_space(),
+                          bind_memory(read_memory_, std::move(on_completion)));
+}
+
+template <typename Handler_type>
+asio::mutable_buffer Basic_socket<Handler_type>::read_space() {
+  return asio::buffer(read_buffer_.data(), read_buffer_.size()) + read_end_;
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::bytes_received(asio::error_code ec,
+                                                std::size_t n) {
+  if (ec) {
+    if (ec == asio::error::operation_aborted)
+      handler_->read_aborted();
+    else if (ec == asio::error::eof)
+      handler_->read_end_of_file();
+    else
+      handler_->read_failure(ec);
+    return;
+  }
+  read_end_ += n;
+  if (!parse_packets() || closing_)
+    return;
+  read_some();
+}
+
+template <typename Handler_type>
+bool Basic_socket<Handler_type>::parse_packets() {
+  bool received = false;
+  bool malformed = false;
+  while (!closing_) {
+    const auto available = read_end_ - read_begin_;
+    if (available < packet_size_length)
+      break;
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Unparsed bytes
+    const auto* data = read_buffer_.data() + read_begin_;
+    std::uint16_t packet_size = 0;
+    unpack(packet_size, data);
+    if (packet_size < packet_type_length) {
+      malformed = true;
+      break;
+    }
+    const auto size = packet_size_length + packet_size;
+    if (available < size)
+      break;
+    read_begin_ += size;
+    received = true;
+    packet_received(Packet_view(data, size));
+  }
+  if (received)
+    handler_->read_batch_complete();
+  if (malformed) {
+    handler_->read_failure(Packet_error::malformed_header);
+    return false;
+  }
+
+  // Keep room for a whole packet after the partial one, if any.
+  if (read_begin_ == read_end_) {
+    read_begin_ = 0;
+    read_end_ = 0;
+  } else if (read_buffer_.size() - read_end_ < max_packet_length) {
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Unparsed bytes
+    std::memmove(read_buffer_.data(), read_buffer_.data() + read_begin_,
+                 read_end_ - read_begin_);
+    read_end_ -= read_begin_;
+    read_begin_ = 0;
+  }
+  return true;
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::packet_received(const Packet_view& packet) {
+  if (metrics_) {
+    metrics_->on_read(packet.packet_type(), packet.size(),
+                      std::chrono::steady_clock::now());
+  }
+  handler_->read_success(packet);
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::write_packet() {
+  zero_copy_write_ = false;
+  if (zero_copy_threshold_ != 0 &&
+      write_packets_.front().packet.size() >= zero_copy_threshold_)
+    send_zero_copy(0);
+  else
+    write_from(0);
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::write_from(std::size_t offset) {
+  const auto& packet = write_packets_.front().packet;
+  const auto buffer = asio::buffer(packet.data(), packet.size()) + offset;
+
+  write_pending_ = true;
+  auto on_completion = [this, offset](asio::error_code ec, std::size_t n) {
+    write_pending_ = false;
+    packet_sent(ec, offset + n);
+    maybe_signal_closed();
+  };
+
+  asio::async_write(socket_, buffer,
+                    bind_memory(write_memory_, std::move(on_completion)));
+}
+
+// Each send that succeeds is one zero-copy send to the kernel, so a partial
+// send is continued with another rather than with async_write.
+template <typename Handler_type>
+void Basic_socket<Handler_type>::send_zero_copy(std::size_t offset) {
+#ifdef MSG_ZEROCOPY
+  const auto& packet = write_packets_.front().packet;
+  const auto buffer = asio::buffer(packet.data(), packet.size()) + offset;
+
+  write_pending_ = true;
+  auto on_completion = [this, offset](asio::error_code ec, std::size_t n) {
+    write_pending_ = false;
+    zero_copy_sent(ec, offset + n);
+    maybe_signal_closed();
+  };
+
+  socket_.async_send(buffer, MSG_ZEROCOPY,
+                     bind_memory(write_memory_, std::move(on_completion)));
+#else
+  write_from(offset);
+#endif
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::zero_copy_sent(asio::error_code ec,
+                                                std::size_t n) {
+  // Out of option memory for notifications; copy the rest instead.
+  if (ec == asio::error::no_buffer_space) {
+    write_from(n);
+    return;
+  }
+  if (!ec) {
+    ++zero_copy_sends_;
+    zero_copy_write_ = true;
+    if (n < write_packets_.front().packet.size() && !closing_) {
+      send_zero_copy(n);
+      return;
+    }
+  }
+  packet_sent(ec, n);
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::packet_sent(asio::error_code ec,
+                                             std::size_t n) {
+  auto& [packet, queued] = write_packets_.front();
+  if (ec || n != packet.size()) {
+    // The kernel may still be sending what went with MSG_ZEROCOPY. The
+    // moved-from packet stays queued, so nothing more is written.
+    if (zero_copy_write_)
+      hold_zero_copy_packet(packet);
+    if (!ec) { // Needed? Error code should be set.
+      const asio::error_code ec(ECANCELED, asio::system_category());
+      handler_->write_failure(ec);
+    } else if (ec != asio::error::operation_aborted) {
+      handler_->write_failure(ec);
+    }
+    return;
+  }
+  if (metrics_) {
+    metrics_->on_write_complete(packet.packet_type(), n,
+                                std::chrono::steady_clock::now() - queued,
+                                write_packets_.size() - 1);
+  }
+  handler_->write_success(packet);
+  if (zero_copy_write_)
+    hold_zero_copy_packet(packet);
+  write_packets_.erase(write_packets_.front());
+  if (closing_)
+    return;
+  if (!write_packets_.empty())
+    write_packet();
+  else if (write_buffer_was_full_) {
+    write_buffer_was_full_ = false;
+    handler_->write_buffer_empty();
+  }
+}
+
+// Held until the kernel has completed every zero-copy send so far
+template <typename Handler_type>
+void Basic_socket<Handler_type>::hold_zero_copy_packet(Write_packet& packet) {
+  zero_copy_packets_.emplace_back(std::move(packet), zero_copy_sends_);
+  wait_for_zero_copy();
+}
+
+// Notifications raise an error event on the socket. The wait is started
+// before the queue is read, so one arriving in between is not missed.
+template <typename Handler_type>
+void Basic_socket<Handler_type>::wait_for_zero_copy() {
+  if (!error_wait_pending_ && !closing_) {
+    error_wait_pending_ = true;
+    auto on_completion = [this](asio::error_code ec) {
+      error_wait_pending_ = false;
+      if (!ec && !zero_copy_packets_.empty())
+        wait_for_zero_copy();
+      maybe_signal_closed();
+    };
+    socket_.async_wait(asio::socket_base::wait_error,
+                       bind_memory(error_memory_, std::move(on_completion)));
+  }
+  release_zero_copy_packets();
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::release_zero_copy_packets() {
+  zero_copy_completed_ = detail::read_zero_copy_completions(
+      socket_.native_handle(), zero_copy_completed_);
+  while (!zero_copy_packets_.empty()) {
+    auto& held = zero_copy_packets_.front();
+    const auto outstanding = held.send_count - zero_copy_completed_;
+    if (static_cast<std::int32_t>(outstanding) > 0)
+      break;
+    zero_copy_packets_.erase(held);
+  }
+}
+
+// Closing the descriptor would not stop the kernel sending what is queued
+// from the held packets, so the descriptor and the packets are moved out
+// together, to be released once the kernel is done. The peer is sent FIN
+// after the queued data. Held until the io_context is destroyed at the
+// latest.
+template <typename Handler_type>
+void Basic_socket<Handler_type>::drain_zero_copy() {
+  struct Drain {
+    asio::generic::stream_protocol::socket socket;
+    Slab_list<Held_packet> packets;
+    std::uint32_t sends = 0;
+    std::uint32_t completed = 0;
+
+    static void wait(std::shared_ptr<Drain> drain) {
+      drain->completed = detail::read_zero_copy_completions(
+          drain->socket.native_handle(), drain->completed);
+      if (static_cast<std::int32_t>(drain->sends - drain->completed) <= 0)
+        return;
+      auto& socket = drain->socket;
+      socket.async_wait(asio::socket_base::wait_error,
+                        [drain = std::move(drain)](asio::error_code ec) {
+                          if (!ec)
+                            wait(drain);
+                        });
+    }
+  };
+
+  asio::error_code ec;
+  socket_.shutdown(asio::socket_base::shutdown_send, ec);
+  Drain::wait(std::make_shared<Drain>(std::move(socket_),
+                                      std::move(zero_copy_packets_),
+                                      zero_copy_sends_, zero_copy_completed_));
+}
+
+template <typename Handler_type>
+bool Basic_socket<Handler_type>::is_idle() const {
+  return !connect_pending_ && !read_pending_ && !write_pending_ &&
+         !error_wait_pending_;
+}
+
+template <typename Handler_type>
+void Basic_socket<Handler_type>::maybe_signal_closed() {
+  if (closing_ && !closed_signaled_ && is_idle()) {
+    if (socket_.is_open()) {
+      release_zero_copy_packets();
+      if (zero_copy_packets_.empty()) {
+        asio::error_code ec;
+        socket_.close(ec);
+      } else {
+        drain_zero_copy();
+      }
+    }
+    closed_signaled_ = true;
+    asio::post(socket_.get_executor(), [this] { handler_->closed(); });
+  }
+}
+
 } // namespace bc::soup
 
 #endif
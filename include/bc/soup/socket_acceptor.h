@@ -1,6 +1,8 @@
 #ifndef INCLUDE_BC_SOUP_SOCKET_ACCEPTOR_H
 #define INCLUDE_BC_SOUP_SOCKET_ACCEPTOR_H
 
+#include "bc/soup/endpoint.h"
+
 #include <asio.hpp>
 
 #include <optional>
@@ -12,7 +14,8 @@ public:
   class Handler {
   public:
     virtual void accept_failure(asio::error_code) = 0;
-    virtual void accept_success(asio::ip::tcp::socket&&) = 0;
+    virtual void
+    accept_success(asio::generic::stream_protocol::socket&&) = 0;
 
   protected:
     Handler() = default;
@@ -37,8 +40,10 @@ public:
 
   void set_handler(Handler&);
 
+  // For IPv4 TCP
   [[nodiscard]] asio::error_code open();
-  [[nodiscard]] asio::error_code bind(const asio::ip::tcp::endpoint&);
+  [[nodiscard]] asio::error_code open(asio::generic::stream_protocol);
+  [[nodiscard]] asio::error_code bind(const Endpoint&);
   [[nodiscard]] asio::error_code listen();
   void close(asio::error_code* = nullptr);
 
@@ -47,14 +52,14 @@ public:
 
   void async_accept();
 
-  asio::ip::tcp::endpoint local_endpoint(asio::error_code* = nullptr) const;
+  Endpoint local_endpoint(asio::error_code* = nullptr) const;
 
-  asio::ip::tcp::acceptor::executor_type get_executor();
+  asio::any_io_executor get_executor();
 
 private:
   Handler* handler_ = nullptr;
-  asio::ip::tcp::acceptor acceptor_;
-  std::optional<asio::ip::tcp::socket> socket_;
+  asio::basic_socket_acceptor<asio::generic::stream_protocol> acceptor_;
+  std::optional<asio::generic::stream_protocol::socket> socket_;
 };
 
 } // namespace bc::soup
@@ -0,0 +1,83 @@
+#ifndef INCLUDE_BC_SOUP_TAIL_CACHE_H
+#define INCLUDE_BC_SOUP_TAIL_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace bc::soup {
+
+// A message held in a shared, reference-counted block, e.g. one of a
+// Tail_cache's. Copying a frame shares the block, which lives as long as any
+// frame in it, so frames stay valid after the cache has moved on.
+class Frame {
+public:
+  Frame() = default;
+  Frame(std::shared_ptr<const std::byte> data, std::size_t size)
+      : data_(std::move(data)), size_(size) {}
+
+  const void* data() const { return data_.get(); }
+
+  std::size_t size() const { return size_; }
+
+private:
+  std::shared_ptr<const std::byte> data_;
+  std::size_t size_ = 0;
+};
+
+// The most recent messages of a session, so that a client logging in a
+// little behind is served from memory instead of from a File_store. Messages
+// are copied into blocks of block_size bytes shared by their frames, so
+// adding allocates once per block rather than once per message. Whichever
+// limit is reached first evicts the oldest messages; a block is freed once
+// no frame in it is held, here or elsewhere.
+//
+// Both limits are zero by default, which keeps nothing.
+class Tail_cache {
+public:
+  static constexpr std::size_t block_size = 64 * 1024;
+
+  Tail_cache() = default;
+  Tail_cache(std::size_t, std::size_t);
+
+  // The number of messages and the number of payload bytes to keep
+  void set_limits(std::size_t, std::size_t);
+
+  // What is held always runs up to the last message added: a sequence
+  // number that does not follow the last one held starts afresh with it, and
+  // a message too large to keep empties the cache.
+  void add(std::uint64_t, const void*, std::size_t);
+  void clear();
+
+  bool empty() const { return frames_.empty(); }
+  std::size_t size() const { return frames_.size(); }
+  std::size_t bytes() const { return bytes_; }
+
+  // Of the oldest message held, if any
+  std::uint64_t first_sequence_number() const { return first_; }
+
+  // Appends the frames of the messages from first to last inclusive, or
+  // returns false, appending nothing, if not all of them are held.
+  [[nodiscard]] bool get(std::uint64_t, std::uint64_t,
+                         std::vector<Frame>&) const;
+
+private:
+  std::size_t max_messages_ = 0;
+  std::size_t max_bytes_ = 0;
+  std::deque<Frame> frames_;
+  std::uint64_t first_ = 0;
+  std::size_t bytes_ = 0;
+  // The block being filled
+  std::shared_ptr<std::byte[]> block_;
+  std::size_t block_used_ = 0;
+  std::size_t block_capacity_ = 0;
+
+  void evict();
+};
+
+} // namespace bc::soup
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef INCLUDE_BC_SOUP_TIMEOUTS_H
+#define INCLUDE_BC_SOUP_TIMEOUTS_H
+
+#include "bc/soup/constants.h"
+
+#include <chrono>
+
+namespace bc::soup {
+
+// How a connection times its heartbeats and login, in milliseconds, so that
+// a dead line can be detected within a fraction of a second. The defaults
+// are the protocol's, from constants.h, which differ between the server's
+// end of a connection and the client's.
+struct Timeouts {
+  // Between heartbeats sent on an otherwise idle connection, and between
+  // checks for the heartbeat timeout, which is therefore noticed up to a
+  // period late
+  std::chrono::milliseconds heartbeat_period = soup::heartbeat_period;
+  // Without receiving anything from the peer, before disconnecting
+  std::chrono::milliseconds heartbeat_timeout = client_heartbeat_timeout;
+  // For the login request, or at the client's end for the response
+  std::chrono::milliseconds login_timeout = login_request_timeout;
+
+  static constexpr Timeouts server() { return {}; }
+
+  static constexpr Timeouts client() {
+    return {.heartbeat_period = soup::heartbeat_period,
+            .heartbeat_timeout = server_heartbeat_timeout,
+            .login_timeout = login_response_timeout};
+  }
+};
+
+} // namespace bc::soup
+
+#endif
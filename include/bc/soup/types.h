@@ -32,7 +32,8 @@ enum class Write_error {
   session_ended,
   disconnected,
   not_logged_in,
-  buffer_full
+  buffer_full,
+  message_too_long
 };
 
 const char* to_string(Write_error);
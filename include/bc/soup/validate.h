@@ -1,6 +1,9 @@
 #ifndef INCLUDE_BC_SOUP_VALIDATE_H
 #define INCLUDE_BC_SOUP_VALIDATE_H
 
+#include "bc/soup/reconnect_policy.h"
+#include "bc/soup/timeouts.h"
+
 #include <string_view>
 #include <system_error>
 
@@ -9,6 +12,13 @@ namespace bc::soup {
 [[nodiscard]] std::error_code validate_username(std::string_view);
 [[nodiscard]] std::error_code validate_password(std::string_view);
 [[nodiscard]] std::error_code validate_session(std::string_view);
+// EINVAL unless every interval is positive and the heartbeat timeout is at
+// least a heartbeat period
+[[nodiscard]] std::error_code validate_timeouts(const Timeouts&);
+// EINVAL unless the initial delay is positive and at most the maximum, and
+// the multiplier at least one
+[[nodiscard]] std::error_code
+validate_reconnect_policy(const Reconnect_policy&);
 
 } // namespace bc::soup
 
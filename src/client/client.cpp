@@ -1,15 +1,19 @@
 #include "bc/soup/client/client.h"
 
 #include "bc/soup/client/handler.h"
+#include "bc/soup/client/journal.h"
 #include "bc/soup/client/message.h"
 #include "bc/soup/error.h"
+#include "bc/soup/file_store.h"
 #include "bc/soup/logical_packets.h"
 #include "bc/soup/rw_packets.h"
+#include "bc/soup/validate.h"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <iterator>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -24,21 +28,55 @@ void Client::set_handler(Client_handler& handler) {
   handler_ = &handler;
 }
 
+void Client::set_batch_handler(Sequenced_batch_handler& batch_handler) {
+  batch_handler_ = &batch_handler;
+}
+
 void Client::set_write_packets_limit(std::size_t write_packets_limit) {
   write_packets_limit_ = write_packets_limit;
 }
 
+void Client::set_busy_poll(std::chrono::microseconds busy_poll) {
+  busy_poll_ = busy_poll;
+}
+
+void Client::set_polled_reads(bool polled_reads) {
+  polled_reads_ = polled_reads;
+}
+
+void Client::set_send_policy(Send_policy send_policy) {
+  send_policy_ = send_policy;
+}
+
+std::error_code Client::set_timeouts(const Timeouts& timeouts) {
+  if (const auto ec = validate_timeouts(timeouts))
+    return ec;
+  timeouts_ = timeouts;
+  return {};
+}
+
+std::error_code Client::set_reconnect_policy(const Reconnect_policy& policy) {
+  if (const auto ec = validate_reconnect_policy(policy))
+    return ec;
+  reconnect_policy_ = policy;
+  return {};
+}
+
 void Client::set_next_sequence_number(std::uint64_t next_sequence_number) {
   next_sequence_number_ = next_sequence_number;
 }
 
+void Client::set_journal(Journal& journal) {
+  journal_ = &journal;
+}
+
 expected<Connection*, std::error_code>
-Client::add_connection(const asio::ip::tcp::endpoint& endpoint) {
+Client::add_connection(const Endpoint& endpoint) {
   return add_connection(endpoint, nullptr);
 }
 
 expected<Connection*, std::error_code>
-Client::add_connection(const asio::ip::tcp::endpoint& endpoint,
+Client::add_connection(const Endpoint& endpoint,
                        Connection_handler& connection_handler) {
   return add_connection(endpoint, &connection_handler);
 }
@@ -50,6 +88,10 @@ std::error_code Client::start() {
     if (!connection.is_handler_set())
       return Error::handler_not_set;
   }
+  if (journal_) {
+    if (const auto ec = replay_journal())
+      return ec;
+  }
 
   asio::post(io_executor_, [this] {
     if (started_)
@@ -74,6 +116,13 @@ void Client::stop() {
   });
 }
 
+std::size_t Client::poll() {
+  std::size_t progress = 0;
+  for (auto& connection : connections_)
+    progress += connection.poll();
+  return progress;
+}
+
 Write_error Client::send_message(const void* data, std::size_t size) {
   if (size == 0)
     return Write_error::empty_buffer;
@@ -84,15 +133,14 @@ Write_error Client::send_message(const void* data, std::size_t size) {
   return send_packet(std::move(packet));
 }
 
-// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved via release_packet
+// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved only on success
 Write_error Client::send_message(Message&& message) {
   if (message.payload_size() == 0)
     return Write_error::empty_buffer;
   if (!message.payload_data())
     return Write_error::null_buffer;
 
-  auto packet = message.release_packet();
-  return send_packet(std::move(packet));
+  return send_packet(std::move(message.packet()));
 }
 
 void Client::send_logout_request() {
@@ -106,7 +154,7 @@ void Client::send_debug(std::string_view text) {
 }
 
 expected<Connection*, std::error_code>
-Client::add_connection(const asio::ip::tcp::endpoint& endpoint,
+Client::add_connection(const Endpoint& endpoint,
                        Connection_handler* connection_handler) {
   for (const auto& connection : connections_) {
     if (endpoint == connection.endpoint())
@@ -116,12 +164,68 @@ Client::add_connection(const asio::ip::tcp::endpoint& endpoint,
                                     connection_handler);
 }
 
+std::error_code Client::replay_journal() {
+  const auto session = journal_->session();
+  if (!session.empty()) {
+    for (auto& connection : connections_) {
+      if (connection.session().empty()) {
+        if (const auto ec = connection.set_session(session))
+          return ec;
+      } else if (connection.session() != session) {
+        return Error::journal_mismatch;
+      }
+    }
+  }
+
+  const auto end = journal_->next_sequence_number();
+  auto first = std::max<std::uint64_t>(next_sequence_number_, 1);
+  // Messages after the journal's last could only be requested by leaving a
+  // gap in it.
+  if (first > end)
+    return Error::journal_mismatch;
+
+  // In batches through one buffer, to bound the memory held for a long
+  // journal
+  constexpr std::size_t batch_messages = 1024;
+  constexpr std::size_t batch_bytes = 1024 * 1024;
+  auto cursor = journal_->cursor(first);
+  while (cursor.next_sequence_number() < end) {
+    if (const auto ec = cursor.read(batch_messages, batch_bytes))
+      return ec;
+
+    auto sequence_number = first;
+    for (const auto message : cursor.messages()) {
+      if (batch_handler_)
+        batch_.push_back({sequence_number, message.data(), message.size()});
+      else
+        handler_->sequenced_data(sequence_number, message.data(),
+                                 message.size());
+      ++sequence_number;
+    }
+    on_read_batch_complete();
+    first = cursor.next_sequence_number();
+  }
+  next_sequence_number_ = end;
+  return {};
+}
+
 Write_error Client::send_packet(Write_packet&& packet) {
   if (has_session_ended_)
     return Write_error::session_ended;
 
   if (connections_.size() == 1)
     return send_one(std::move(packet));
+  if (connections_.size() > 1) {
+    switch (send_policy_) {
+    case Send_policy::all_lines:
+      break;
+    case Send_policy::fastest_line:
+      return send_preferred(fastest_ ? *fastest_ : connections_.front(),
+                            std::move(packet));
+    case Send_policy::primary_line:
+      return send_preferred(connections_.front(), std::move(packet));
+    }
+  }
   if (connections_.size() == 2)
     return send_two(std::move(packet));
   return send_multiple(std::move(packet));
@@ -181,18 +285,108 @@ Write_error Client::send_multiple(Write_packet&& packet) {
   return priority_error(errors);
 }
 
-void Client::on_sequenced_data(std::uint64_t sequence_number, const void* data,
-                               std::size_t size) {
-  if (sequence_number < next_sequence_number_)
-    return;
+// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved only on success
+Write_error Client::send_preferred(Connection& preferred,
+                                  Write_packet&& packet) {
+  auto error = preferred.send_packet(std::move(packet));
+  if (error != Write_error::not_logged_in &&
+      error != Write_error::disconnected)
+    return error;
+
+  for (auto& connection : connections_) {
+    if (&connection == &preferred)
+      continue;
+    // NOLINTNEXTLINE(bugprone-use-after-move): Moved only on success
+    const auto other = connection.send_packet(std::move(packet));
+    if (other == Write_error::none)
+      return other;
+    error = priority_error(std::array{error, other});
+  }
+  return error;
+}
+
+std::error_code Client::on_login_success(std::string_view session) {
+  if (!journal_ || !journal_->session().empty())
+    return {};
+  return journal_->set_session(session);
+}
+
+std::error_code Client::on_sequenced_data(Connection& connection,
+                                          std::uint64_t sequence_number,
+                                          const void* data, std::size_t size) {
+  if (sequence_number < next_sequence_number_) {
+    on_duplicate(connection, sequence_number);
+    return {};
+  }
   assert(sequence_number == next_sequence_number_);
+  // Neither delivered nor counted unless journaled, so that it is requested
+  // again on reconnecting.
+  if (journal_) {
+    if (const auto ec = journal_->add(data, size))
+      return ec;
+  }
   next_sequence_number_ = sequence_number + 1;
-  handler_->sequenced_data(sequence_number, data, size);
+  on_win(connection, sequence_number);
+  if (batch_handler_)
+    batch_.push_back({sequence_number, data, size});
+  else
+    handler_->sequenced_data(sequence_number, data, size);
+  return {};
+}
+
+void Client::on_win(Connection& connection, std::uint64_t sequence_number) {
+  connection.on_win();
+  if (connections_.size() < 2)
+    return;
+
+  if (arrivals_.empty())
+    arrivals_.resize(arrival_count);
+  arrivals_[sequence_number % arrival_count] = {
+      sequence_number, std::chrono::steady_clock::now(), &connection};
+  if (++window_messages_ == arbitration_window)
+    choose_fastest();
+}
+
+void Client::on_duplicate(Connection& connection,
+                          std::uint64_t sequence_number) {
+  std::optional<std::chrono::nanoseconds> lag;
+  if (!arrivals_.empty()) {
+    const auto& arrival = arrivals_[sequence_number % arrival_count];
+    if (arrival.sequence_number == sequence_number &&
+        arrival.connection != &connection) {
+      lag = std::chrono::steady_clock::now() - arrival.time;
+      arrival.connection->on_lead(*lag);
+    }
+  }
+  connection.on_duplicate(lag);
+}
+
+// Ties go to the line added first.
+void Client::choose_fastest() {
+  Connection* fastest = nullptr;
+  std::uint64_t most_wins = 0;
+  for (auto& connection : connections_) {
+    const auto wins = connection.take_recent_wins();
+    if (!fastest || wins > most_wins) {
+      fastest = &connection;
+      most_wins = wins;
+    }
+  }
+  fastest_ = fastest;
+  window_messages_ = 0;
+}
+
+void Client::on_read_batch_complete() {
+  if (batch_.empty())
+    return;
+  batch_handler_->sequenced_data(batch_);
+  batch_.clear();
 }
 
 void Client::on_end_of_session() {
   if (has_session_ended_)
     return;
+  on_read_batch_complete();
   has_session_ended_ = true;
   handler_->end_of_session();
 }
@@ -3,7 +3,7 @@
 #include "bc/soup/client/client.h"
 #include "bc/soup/client/handler.h"
 #include "bc/soup/client/message.h"
-#include "bc/soup/constants.h"
+#include "bc/soup/error.h"
 #include "bc/soup/logical_packets.h"
 #include "bc/soup/rw_packets.h"
 #include "bc/soup/validate.h"
@@ -41,13 +41,16 @@ bool is_retryable(Disconnect_reason reason) {
 } // namespace
 
 Connection::Connection(asio::any_io_executor io_executor,
-                       const asio::ip::tcp::endpoint& endpoint, Client& client,
+                       const Endpoint& endpoint, Client& client,
                        Connection_handler* handler)
     : client_(&client),
       handler_(handler),
       io_executor_(io_executor),
       endpoint_(endpoint),
-      reconnect_timer_(io_executor, *this) {}
+      timeouts_(client.timeouts()),
+      reconnect_timer_(io_executor, *this),
+      reconnect_backoff_(client.reconnect_policy()),
+      arbitration_metrics_(client.metrics_registry(), endpoint) {}
 
 void Connection::reconnect_timer_error(asio::error_code ec,
                                        std::string_view operation) {
@@ -55,8 +58,7 @@ void Connection::reconnect_timer_error(asio::error_code ec,
 }
 
 void Connection::reconnect_timer_expired() {
-  connection_.emplace(io_executor_, *this, *handler_,
-                      client_->write_packets_limit());
+  start_connections();
 }
 
 void Connection::set_handler(Connection_handler& handler) {
@@ -84,22 +86,45 @@ std::error_code Connection::set_session(std::string_view session) {
   return {};
 }
 
+std::error_code Connection::set_timeouts(const Timeouts& timeouts) {
+  if (const auto ec = validate_timeouts(timeouts))
+    return ec;
+  timeouts_ = timeouts;
+  return {};
+}
+
+std::error_code
+Connection::set_reconnect_policy(const Reconnect_policy& policy) {
+  if (const auto ec = validate_reconnect_policy(policy))
+    return ec;
+  reconnect_backoff_.set_policy(policy);
+  return {};
+}
+
+std::error_code Connection::add_alternate_endpoint(const Endpoint& endpoint) {
+  if (endpoint == endpoint_ ||
+      std::ranges::find(alternate_endpoints_, endpoint) !=
+          alternate_endpoints_.end())
+    return Error::endpoint_in_use;
+  alternate_endpoints_.push_back(endpoint);
+  return {};
+}
+
 void Connection::connect() {
   if (!client_->started())
     return;
-  if (connection_)
+  if (!connections_.empty())
     return;
   if (reconnect_timer_.started())
     return;
-  connection_.emplace(io_executor_, *this, *handler_,
-                      client_->write_packets_limit());
+  start_connections();
 }
 
 void Connection::close() {
-  if (connection_)
-    connection_->close();
+  for (auto& connection : connections_)
+    connection.close();
   reconnect_timer_.stop();
-  reconnect_next_delay_ = std::chrono::seconds::zero();
+  reconnect_backoff_.reset();
 }
 
 Write_error Connection::send_message(const void* data, std::size_t size) {
@@ -112,41 +137,51 @@ Write_error Connection::send_message(const void* data, std::size_t size) {
   return send_packet(std::move(packet));
 }
 
-// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved via release_packet
+// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved only on success
 Write_error Connection::send_message(Message&& message) {
   if (message.payload_size() == 0)
     return Write_error::empty_buffer;
   if (!message.payload_data())
     return Write_error::null_buffer;
 
-  auto packet = message.release_packet();
-  return send_packet(std::move(packet));
+  return send_packet(std::move(message.packet()));
 }
 
 Write_error Connection::send_logout_request() {
-  if (!connection_)
+  if (connections_.empty())
     return Write_error::disconnected;
 
-  return connection_->send_packet(
-      Write_packet(Logout_request_packet::packet_type));
+  return send_to_line(Write_packet(Logout_request_packet::packet_type));
 }
 
 Write_error Connection::send_debug(std::string_view text) {
   if (text.empty())
     return Write_error::empty_buffer;
-  if (!connection_)
+  if (connections_.empty())
     return Write_error::disconnected;
+  // Before logging in, to the endpoint itself rather than an alternate
+  if (!line_)
+    return connections_.front().send_debug_packet(text);
 
-  return connection_->send_debug_packet(text);
+  return line_->send_debug_packet(text);
+}
+
+// One connection per endpoint, raced to log in
+void Connection::start_connections() {
+  logged_in_ = false;
+  retryable_ = true;
+  connections_.emplace_back(io_executor_, *this, *handler_, endpoint_,
+                            client_->write_packets_limit(),
+                            client_->metrics_registry());
+  for (const auto& endpoint : alternate_endpoints_) {
+    connections_.emplace_back(io_executor_, *this, *handler_, endpoint,
+                              client_->write_packets_limit(),
+                              client_->metrics_registry());
+  }
 }
 
 void Connection::schedule_reconnect() {
-  const auto delay = reconnect_next_delay_;
-  reconnect_next_delay_ =
-      (reconnect_next_delay_ == std::chrono::seconds::zero())
-          ? reconnect_initial_delay
-          : std::min(reconnect_next_delay_ * reconnect_delay_multiplier,
-                     reconnect_max_delay);
+  const auto delay = reconnect_backoff_.next_delay();
   handler_->reconnect_scheduled(delay);
   reconnect_timer_.start(delay);
 }
@@ -154,16 +189,38 @@ void Connection::schedule_reconnect() {
 Write_error Connection::send_packet(Write_packet&& packet) {
   if (has_session_ended_)
     return Write_error::session_ended;
-  if (!connection_)
+  if (connections_.empty())
     return Write_error::disconnected;
 
-  return connection_->send_packet(std::move(packet));
+  return send_to_line(std::move(packet));
+}
+
+// Still racing, no line is logged in.
+Write_error Connection::send_to_line(Write_packet&& packet) {
+  if (!line_)
+    return Write_error::not_logged_in;
+  return line_->send_packet(std::move(packet));
 }
 
 bool Connection::is_handler_set() const {
   return handler_ != nullptr;
 }
 
+std::size_t Connection::poll() {
+  std::size_t count = 0;
+  for (auto& connection : connections_)
+    count += connection.poll();
+  return count;
+}
+
+std::chrono::microseconds Connection::busy_poll() const {
+  return client_->busy_poll();
+}
+
+bool Connection::polled_reads() const {
+  return client_->polled_reads();
+}
+
 Login_request_packet Connection::on_connect_success() {
   next_sequence_number_ = client_->next_sequence_number();
   return Login_request_packet(username_, password_, session_,
@@ -171,7 +228,10 @@ Login_request_packet Connection::on_connect_success() {
 }
 
 Disconnect_reason
-Connection::on_login_success(const Login_accepted_packet& response) {
+Connection::on_login_success(Tcp_connection& connection,
+                             const Login_accepted_packet& response) {
+  if (line_)
+    return Disconnect_reason::superseded;
   if (!session_.empty() && response.session != session_)
     return Disconnect_reason::session_mismatch;
 
@@ -186,16 +246,37 @@ Connection::on_login_success(const Login_accepted_packet& response) {
     return Disconnect_reason::sequence_number_ahead_of_session;
   }
 
+  if (const auto ec = client_->on_login_success(response.session)) {
+    handler_->transport_error(ec, "journal set_session");
+    return Disconnect_reason::transport_error;
+  }
+
   session_ = response.session;
   next_sequence_number_ = response.next_sequence_number;
-  reconnect_next_delay_ = std::chrono::seconds::zero();
+  reconnect_backoff_.on_login();
+  line_ = &connection;
+  // Whatever the others closed for, only the line now counts.
+  logged_in_ = true;
+  retryable_ = true;
+  for (auto& other : connections_) {
+    if (&other != &connection)
+      other.supersede();
+  }
   return Disconnect_reason::none;
 }
 
-void Connection::on_sequenced_data(const void* data, std::size_t size) {
+std::error_code Connection::on_sequenced_data(const void* data,
+                                              std::size_t size) {
   const auto sequence_number = next_sequence_number_;
+  if (const auto ec =
+          client_->on_sequenced_data(*this, sequence_number, data, size))
+    return ec;
   ++next_sequence_number_;
-  client_->on_sequenced_data(sequence_number, data, size);
+  return {};
+}
+
+void Connection::on_read_batch_complete() {
+  client_->on_read_batch_complete();
 }
 
 void Connection::on_end_of_session() {
@@ -205,12 +286,26 @@ void Connection::on_end_of_session() {
   client_->on_end_of_session();
 }
 
-void Connection::on_closed(Disconnect_reason reason) {
-  connection_.reset();
+// Reconnects once the last of the connections raced has closed, unless the
+// line closed for a reason not worth retrying or, if none logged in, one of
+// those raced did.
+void Connection::on_closed(Tcp_connection& connection,
+                           Disconnect_reason reason) {
+  const bool is_line = &connection == line_;
+  if (is_line)
+    line_ = nullptr;
+  connections_.erase(connection);
   handler_->disconnect(reason);
+  if (is_line)
+    retryable_ = is_retryable(reason);
+  else if (!logged_in_ && reason != Disconnect_reason::superseded &&
+           !is_retryable(reason))
+    retryable_ = false;
+  if (!connections_.empty())
+    return;
   if (!client_->started())
     return;
-  if (!is_retryable(reason))
+  if (!retryable_)
     return;
   schedule_reconnect();
 }
@@ -0,0 +1,78 @@
+#include "bc/soup/client/journal.h"
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
+
+namespace bc::soup::client {
+
+Journal::Journal(std::string_view filename) : filename_(filename) {}
+
+void Journal::set_filename(std::string_view filename) {
+  filename_ = filename;
+}
+
+void Journal::set_shared_tail(std::string_view filename) {
+  store_.set_shared_tail(filename);
+}
+
+std::error_code Journal::open() {
+  store_.set_filename(filename_);
+  if (const auto ec = store_.open())
+    return ec;
+
+  session_.clear();
+  std::ifstream file(session_filename(), std::ios::binary);
+  if (file)
+    session_.assign(std::istreambuf_iterator<char>(file), {});
+  if (file.bad())
+    return std::make_error_code(std::errc::io_error);
+  return {};
+}
+
+std::error_code Journal::close() {
+  return store_.close();
+}
+
+std::error_code Journal::sync() {
+  return store_.sync();
+}
+
+std::uint64_t Journal::next_sequence_number() const {
+  return store_.next_sequence_number();
+}
+
+std::string Journal::session_filename() const {
+  return filename_ + ".session";
+}
+
+// Written aside and renamed over, so that the file holds either no session
+// or all of it.
+std::error_code Journal::set_session(std::string_view session) {
+  const auto filename = session_filename();
+  const auto temporary = filename + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(session.data(), static_cast<std::streamsize>(session.size()));
+    file.close();
+    if (!file)
+      return std::make_error_code(std::errc::io_error);
+  }
+  std::error_code ec;
+  std::filesystem::rename(temporary, filename, ec);
+  if (ec)
+    return ec;
+  session_ = session;
+  return {};
+}
+
+std::error_code Journal::add(const void* data, std::size_t size) {
+  return store_.add(data, size);
+}
+
+File_store::Cursor Journal::cursor(std::uint64_t sequence_number) {
+  return store_.cursor(sequence_number);
+}
+
+} // namespace bc::soup::client
@@ -0,0 +1,42 @@
+#include "bc/soup/client/session.h"
+
+#include "bc/soup/client/client.h"
+
+namespace bc::soup::client {
+
+Session::Session(asio::any_io_executor io_executor, Client& client)
+    : readable_(io_executor) {
+  client.set_handler(*this);
+  client.set_batch_handler(*this);
+}
+
+asio::awaitable<std::span<const Sequenced_data>> Session::next_messages() {
+  while (batch_.empty() && !has_session_ended_ && !cancelled_)
+    co_await readable_.wait();
+  cancelled_ = false;
+  co_return batch_.take();
+}
+
+void Session::cancel() {
+  cancelled_ = true;
+  readable_.notify();
+}
+
+void Session::sequenced_data(std::uint64_t sequence_number, const void* data,
+                             std::size_t size) {
+  batch_.add({sequence_number, data, size});
+  readable_.notify();
+}
+
+void Session::end_of_session() {
+  has_session_ended_ = true;
+  readable_.notify();
+}
+
+void Session::sequenced_data(std::span<const Sequenced_data> batch) {
+  for (const auto& message : batch)
+    batch_.add(message);
+  readable_.notify();
+}
+
+} // namespace bc::soup::client
@@ -0,0 +1,41 @@
+#include "bc/soup/client/spin_runner.h"
+
+#include "bc/soup/client/client.h"
+
+namespace bc::soup::client {
+
+Spin_runner::Spin_runner(asio::io_context& io_context)
+    : io_context_(&io_context) {}
+
+Spin_runner::Spin_runner(asio::io_context& io_context, Client& client)
+    : io_context_(&io_context), clients_{&client} {}
+
+void Spin_runner::add(Client& client) {
+  clients_.push_back(&client);
+}
+
+void Spin_runner::set_io_poll_interval(std::chrono::nanoseconds interval) {
+  io_poll_interval_ = interval;
+}
+
+std::size_t Spin_runner::poll_once() {
+  std::size_t progress = 0;
+  for (auto* client : clients_)
+    progress += client->poll();
+  const auto now = std::chrono::steady_clock::now();
+  if (progress == 0 && now < next_io_poll_)
+    return 0;
+  next_io_poll_ = now + io_poll_interval_;
+  // poll() stops the io_context once it runs out of work.
+  if (io_context_->stopped())
+    io_context_->restart();
+  progress += io_context_->poll();
+  return progress;
+}
+
+void Spin_runner::run() {
+  while (!stopped_.load(std::memory_order_relaxed))
+    poll_once();
+}
+
+} // namespace bc::soup::client
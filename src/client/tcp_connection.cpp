@@ -3,9 +3,11 @@
 #include "bc/soup/client/connection.h"
 #include "bc/soup/client/handler.h"
 #include "bc/soup/constants.h"
+#include "bc/soup/endpoint.h"
 #include "bc/soup/logical_packets.h"
 #include "bc/soup/rw_packets.h"
 
+#include <chrono>
 #include <utility>
 
 namespace bc::soup::client {
@@ -15,24 +17,45 @@ using State = Connection_state::State;
 Tcp_connection::Tcp_connection(asio::any_io_executor io_executor,
                                Connection& connection,
                                Connection_handler& handler,
-                               std::size_t write_packets_limit)
+                               const Endpoint& endpoint,
+                               std::size_t write_packets_limit,
+                               Metrics_registry& metrics_registry)
     : connection_(&connection),
       handler_(&handler),
+      metrics_(metrics_registry, to_tcp(endpoint)),
       socket_(io_executor, *this),
-      login_timer_(io_executor, *this, login_response_timeout),
-      heartbeat_timer_(io_executor, *this, server_heartbeat_timeout) {
+      login_timer_(io_executor, *this, connection.timeouts().login_timeout),
+      heartbeat_timer_(io_executor, *this,
+                       connection.timeouts().heartbeat_period,
+                       connection.timeouts().heartbeat_timeout) {
 
-  handler_->connecting(connection_->endpoint());
+  handler_->connecting(to_tcp(endpoint));
   socket_.set_write_packets_limit(write_packets_limit);
-  if (const auto ec = socket_.open()) {
+  socket_.set_metrics(metrics_);
+  if (const auto ec = socket_.open(endpoint.protocol())) {
     handle_connect_failure(ec, "open");
     return;
   }
-  if (const auto ec = socket_.set_no_delay()) {
-    handle_connect_failure(ec, "set_no_delay");
-    return;
+  if (is_tcp(endpoint)) {
+    if (const auto ec = socket_.set_no_delay()) {
+      handle_connect_failure(ec, "set_no_delay");
+      return;
+    }
+  }
+  if (const auto busy_poll = connection_->busy_poll();
+      busy_poll != std::chrono::microseconds::zero()) {
+    if (const auto ec = socket_.set_busy_poll(busy_poll)) {
+      handle_connect_failure(ec, "set_busy_poll");
+      return;
+    }
   }
-  socket_.async_connect(connection_->endpoint());
+  if (connection_->polled_reads()) {
+    if (const auto ec = socket_.set_polled_reads()) {
+      handle_connect_failure(ec, "set_polled_reads");
+      return;
+    }
+  }
+  socket_.async_connect(endpoint);
 }
 
 void Tcp_connection::connect_failure(asio::error_code ec) {
@@ -41,8 +64,8 @@ void Tcp_connection::connect_failure(asio::error_code ec) {
 
 void Tcp_connection::connect_success() {
   state_.set_state(State::connected);
-  const auto local_endpoint = socket_.local_endpoint();
-  const auto remote_endpoint = socket_.remote_endpoint();
+  const auto local_endpoint = to_tcp(socket_.local_endpoint());
+  const auto remote_endpoint = to_tcp(socket_.remote_endpoint());
   handler_->connect_success(local_endpoint, remote_endpoint);
 
   const Login_request_packet request = connection_->on_connect_success();
@@ -64,15 +87,16 @@ void Tcp_connection::read_failure(Packet_error error) {
   handle_protocol_violation(error);
 }
 
-void Tcp_connection::read_success(const Read_packet& packet) {
+void Tcp_connection::read_success(const Packet_view& packet) {
   if (state_.is_closing())
     return;
   const auto error = process_packet(packet);
   if (error != Packet_error::none)
     handle_protocol_violation(error);
-  if (state_.is_closing())
-    return;
-  socket_.async_read();
+}
+
+void Tcp_connection::read_batch_complete() {
+  connection_->on_read_batch_complete();
 }
 
 void Tcp_connection::read_aborted() {
@@ -131,7 +155,7 @@ void Tcp_connection::heartbeat_timer_stopped() {
   maybe_signal_closed();
 }
 
-Packet_error Tcp_connection::process_packet(const Read_packet& packet) {
+Packet_error Tcp_connection::process_packet(const Packet_view& packet) {
   const auto* data = packet.payload_data();
   const auto size = packet.payload_size();
   switch (packet.packet_type()) {
@@ -171,7 +195,7 @@ Packet_error Tcp_connection::process_login_accepted(const void* data,
 
   login_timer_.stop();
   state_.set_state(State::logged_in);
-  const auto reason = connection_->on_login_success(response);
+  const auto reason = connection_->on_login_success(*this, response);
   if (reason == Disconnect_reason::none) {
     handler_->login_success(response);
     heartbeat_timer_stopped_ = false;
@@ -216,7 +240,8 @@ Packet_error Tcp_connection::process_sequenced_data(const void* data,
     return Packet_error::unexpected_sequence;
 
   heartbeat_timer_.increment_receive_count();
-  connection_->on_sequenced_data(data, size);
+  if (const auto ec = connection_->on_sequenced_data(data, size))
+    handle_transport_error(ec, "journal add");
   return Packet_error::none;
 }
 
@@ -271,7 +296,7 @@ void Tcp_connection::maybe_signal_closed() {
   if (!socket_closed_ || !login_timer_stopped_ || !heartbeat_timer_stopped_)
     return;
   // on_closed destroys *this — the owner drops it here
-  connection_->on_closed(state_.reason());
+  connection_->on_closed(*this, state_.reason());
   // Do not add any statements; on_closed must be last
 }
 
@@ -297,4 +322,12 @@ void Tcp_connection::close() {
   disconnect(Disconnect_reason::user_initiated);
 }
 
+void Tcp_connection::supersede() {
+  disconnect(Disconnect_reason::superseded);
+}
+
+std::size_t Tcp_connection::poll() {
+  return socket_.poll();
+}
+
 } // namespace bc::soup::client
@@ -0,0 +1,78 @@
+#include "bc/soup/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace bc::soup {
+namespace {
+
+// Reversed
+constexpr std::uint32_t polynomial = 0x82f63b78;
+
+// Indexed by byte
+// NOLINTNEXTLINE(*-avoid-magic-numbers): Number of byte values
+constexpr std::array<std::uint32_t, 256> make_table() {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Number of byte values
+  std::array<std::uint32_t, 256> table{};
+  for (std::uint32_t i = 0; i < table.size(); ++i) {
+    auto crc = i;
+    // NOLINTNEXTLINE(*-avoid-magic-numbers): Bits in a byte
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? polynomial : 0);
+    table[i] = crc;
+  }
+  return table;
+}
+
+constexpr auto table = make_table();
+
+std::uint32_t crc32c_table(std::uint32_t crc, const unsigned char* data,
+                           std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    // NOLINTNEXTLINE(*-pro-bounds-*, *-avoid-magic-numbers): A byte at a time
+    crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+// Eight bytes an instruction. Consecutive records are independent, so the
+// CPU overlaps their chains without interleaving streams by hand.
+__attribute__((target("sse4.2"))) std::uint32_t
+crc32c_sse42(std::uint32_t crc, const unsigned char* data, std::size_t size) {
+  std::uint64_t crc64 = crc;
+  for (; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t)) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the bytes
+    data += sizeof(word);
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+  for (std::size_t i = 0; i < size; ++i) {
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the bytes
+    crc = _mm_crc32_u8(crc, data[i]);
+  }
+  return crc;
+}
+
+const bool has_sse42 = __builtin_cpu_supports("sse4.2") != 0;
+#endif
+
+} // namespace
+
+std::uint32_t crc32c(std::uint32_t crc, const void* data, std::size_t size) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  crc = ~crc;
+#if defined(__x86_64__)
+  if (has_sse42)
+    return ~crc32c_sse42(crc, bytes, size);
+#endif
+  return ~crc32c_table(crc, bytes, size);
+}
+
+} // namespace bc::soup
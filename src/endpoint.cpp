@@ -0,0 +1,22 @@
+#include "bc/soup/endpoint.h"
+
+#include <cstring>
+
+namespace bc::soup {
+
+bool is_tcp(const Endpoint& endpoint) {
+  const auto family = endpoint.protocol().family();
+  return family == asio::ip::tcp::v4().family() ||
+         family == asio::ip::tcp::v6().family();
+}
+
+asio::ip::tcp::endpoint to_tcp(const Endpoint& endpoint) {
+  asio::ip::tcp::endpoint tcp_endpoint;
+  if (is_tcp(endpoint) && endpoint.size() <= tcp_endpoint.capacity()) {
+    std::memcpy(tcp_endpoint.data(), endpoint.data(), endpoint.size());
+    tcp_endpoint.resize(endpoint.size());
+  }
+  return tcp_endpoint;
+}
+
+} // namespace bc::soup
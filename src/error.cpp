@@ -28,6 +28,12 @@ public:
       return "username in use";
     case Error::handler_not_set:
       return "handler not set";
+    case Error::journal_mismatch:
+      return "journal mismatch";
+    case Error::invalid_timeouts:
+      return "invalid timeouts";
+    case Error::invalid_reconnect_policy:
+      return "invalid reconnect policy";
     }
     return "unknown error";
   }
@@ -40,11 +46,14 @@ public:
     case Error::invalid_password:
     case Error::session_too_long:
     case Error::invalid_session:
+    case Error::invalid_timeouts:
+    case Error::invalid_reconnect_policy:
       return std::errc::invalid_argument;
     case Error::endpoint_in_use:
       return std::errc::address_in_use;
     case Error::username_in_use:
     case Error::handler_not_set:
+    case Error::journal_mismatch:
       break;
     }
     return std::error_condition(ev, *this);
@@ -1,9 +1,28 @@
 #include "bc/soup/file_store.h"
 
+#include "bc/soup/crc32c.h"
+#include "bc/soup/shared_tail.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <system_error>
+#include <thread>
 
 #include <arpa/inet.h>
+#include <endian.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace bc::soup {
@@ -31,20 +50,142 @@ int close(int fd) {
   return status;
 }
 
-detail::Read_result read(int fd, void* buf, size_t nbyte) {
-  auto r = [](int fd, void* buf, size_t nbyte) {
-    return while_interrupted<ssize_t>(::read, fd, buf, nbyte);
+detail::Read_result read_at(int fd, off_t off, void* buf, size_t nbyte) {
+  auto r = [&off](int fd, void* buf, size_t nbyte) {
+    const auto n = while_interrupted<ssize_t>(::pread, fd, buf, nbyte, off);
+    if (n > 0)
+      off += n;
+    return n;
   };
   return detail::read_partial_handling(fd, buf, nbyte, r);
 }
 
-detail::Write_result write(int fd, const void* buf, size_t nbyte) {
-  auto w = [](int fd, const void* buf, size_t nbyte) {
-    return while_interrupted<ssize_t>(::write, fd, buf, nbyte);
+std::uint16_t record_size(const std::byte* header) {
+  std::uint16_t sz = 0;
+  std::memcpy(&sz, header, sizeof(sz));
+  return ntohs(sz);
+}
+
+// Calls message(data, size) for each of count records held back to back,
+// each with a header of the size given.
+template <typename Message_fn>
+std::error_code split_records(std::span<const std::byte> records,
+                              std::size_t count, std::size_t header_size,
+                              Message_fn&& message) {
+  for (std::size_t i = 0; i < count; ++i) {
+    if (records.size() < header_size)
+      return {EIO, std::system_category()};
+    const std::uint16_t size = record_size(records.data());
+    records = records.subspan(header_size);
+    // A record cut short, e.g. by a crash during add()
+    if (records.size() < size)
+      return {EIO, std::system_category()};
+    message(records.data(), size);
+    records = records.subspan(size);
+  }
+  return {};
+}
+
+detail::Write_result write_at(int fd, off_t off, const void* buf,
+                              size_t nbyte) {
+  auto w = [&off](int fd, const void* buf, size_t nbyte) {
+    const auto n = while_interrupted<ssize_t>(::pwrite, fd, buf, nbyte, off);
+    if (n > 0)
+      off += n;
+    return n;
   };
   return detail::write_partial_handling(fd, buf, nbyte, w);
 }
 
+// Writes the header and the message with a single pwritev, finishing a short
+// write part by part.
+detail::Write_result write_record(int fd, off_t off,
+                                  std::span<std::byte> header,
+                                  const void* data, size_t size) {
+  // NOLINTNEXTLINE(*-const-cast): iovec is shared with readv
+  const iovec payload{const_cast<void*>(data), size};
+  const std::array<iovec, 2> iov{{{header.data(), header.size()}, payload}};
+  const auto nbyte = header.size() + size;
+  const auto n = while_interrupted<ssize_t>(::pwritev, fd, iov.data(),
+                                            static_cast<int>(iov.size()), off);
+  if (n == -1)
+    return {detail::Write_status::failure, 0};
+  auto written = static_cast<size_t>(n);
+  if (written == nbyte)
+    return {detail::Write_status::success, nbyte};
+
+  auto pos = off;
+  for (const auto& part : iov) {
+    if (written < part.iov_len) {
+      const auto* base = static_cast<const std::byte*>(part.iov_base);
+      const auto remaining = part.iov_len - written;
+      // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Unwritten part
+      const auto res = write_at(fd, pos + static_cast<off_t>(written),
+                                base + written, remaining);
+      if (res.status == detail::Write_status::failure) {
+        const auto done = static_cast<size_t>(pos - off) + written + res.nbyte;
+        return {detail::Write_status::failure, done};
+      }
+      written = part.iov_len;
+    }
+    written -= part.iov_len;
+    pos += static_cast<off_t>(part.iov_len);
+  }
+  return {detail::Write_status::success, nbyte};
+}
+
+// Where a checksummed record's header holds its CRC
+constexpr std::size_t checksum_offset = sizeof(std::uint16_t);
+constexpr std::size_t checksum_end = checksum_offset + sizeof(std::uint32_t);
+
+// Of the header but for the CRC itself, i.e. of the size and any timestamp,
+// and of the payload
+std::uint32_t record_checksum(std::span<const std::byte> header,
+                              const void* data, std::size_t size) {
+  const auto sz = header.first(checksum_offset);
+  const auto rest = header.subspan(checksum_end);
+  const auto crc = crc32c(crc32c(0, sz.data(), sz.size()), rest.data(),
+                          rest.size());
+  return crc32c(crc, data, size);
+}
+
+std::int64_t to_nanoseconds(std::chrono::system_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+// The file, mapped for reading while it is indexed, and read in up front
+// rather than page fault by page fault
+class Mapping {
+public:
+  Mapping() = default;
+  ~Mapping() {
+    if (data_ != MAP_FAILED)
+      munmap(data_, size_);
+  }
+
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  Mapping(Mapping&&) = delete;
+  Mapping& operator=(Mapping&&) = delete;
+
+  [[nodiscard]] std::error_code map(int fd, std::size_t size) {
+    data_ = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    if (data_ == MAP_FAILED)
+      return {errno, std::system_category()};
+    size_ = size;
+    return {};
+  }
+
+  const std::byte* data() const { return static_cast<std::byte*>(data_); }
+
+private:
+  void* data_ = MAP_FAILED;
+  std::size_t size_ = 0;
+};
+
 } // namespace
 
 File_store::File_store(std::string_view filename) : filename_(filename) {}
@@ -56,16 +197,46 @@ File_store::~File_store() {
 File_store::File_store(File_store&& other) noexcept
     : filename_(std::move(other.filename_)),
       fd_(other.fd_),
-      offsets_(std::move(other.offsets_)) {
+      end_(other.end_),
+      offsets_(std::move(other.offsets_)),
+      cache_(std::move(other.cache_)),
+      checksums_(other.checksums_),
+      verify_limit_(other.verify_limit_),
+      direct_io_(other.direct_io_),
+      tail_(std::move(other.tail_)),
+      tail_offset_(other.tail_offset_),
+      read_blocks_(std::move(other.read_blocks_)),
+      read_blocks_size_(other.read_blocks_size_),
+      timestamps_(other.timestamps_),
+      time_index_(std::move(other.time_index_)),
+      last_timestamp_(other.last_timestamp_),
+      shared_tail_filename_(std::move(other.shared_tail_filename_)),
+      shared_tail_(other.shared_tail_) {
   other.fd_ = -1;
+  other.shared_tail_ = nullptr;
 }
 
 File_store& File_store::operator=(File_store&& other) noexcept {
   (void)close();
   filename_ = std::move(other.filename_);
   fd_ = other.fd_;
+  end_ = other.end_;
   offsets_ = std::move(other.offsets_);
+  cache_ = std::move(other.cache_);
+  checksums_ = other.checksums_;
+  verify_limit_ = other.verify_limit_;
+  direct_io_ = other.direct_io_;
+  tail_ = std::move(other.tail_);
+  tail_offset_ = other.tail_offset_;
+  read_blocks_ = std::move(other.read_blocks_);
+  read_blocks_size_ = other.read_blocks_size_;
+  timestamps_ = other.timestamps_;
+  time_index_ = std::move(other.time_index_);
+  last_timestamp_ = other.last_timestamp_;
+  shared_tail_filename_ = std::move(other.shared_tail_filename_);
+  shared_tail_ = other.shared_tail_;
   other.fd_ = -1;
+  other.shared_tail_ = nullptr;
   return *this;
 }
 
@@ -73,48 +244,113 @@ void File_store::set_filename(std::string_view filename) {
   filename_ = filename;
 }
 
+void File_store::set_cache_limits(std::size_t max_messages,
+                                  std::size_t max_bytes) {
+  cache_.set_limits(max_messages, max_bytes);
+}
+
+void File_store::set_checksums(bool checksums) {
+  checksums_ = checksums;
+}
+
+void File_store::set_verify_limit(std::size_t bytes) {
+  verify_limit_ = bytes;
+}
+
+void File_store::set_direct_io(bool direct_io) {
+  direct_io_ = direct_io;
+}
+
+void File_store::set_timestamps(bool timestamps) {
+  timestamps_ = timestamps;
+}
+
+void File_store::set_shared_tail(std::string_view filename) {
+  shared_tail_filename_ = filename;
+}
+
 std::error_code File_store::open() {
-  fd_ = soup::open(filename_.c_str(), O_RDONLY);
-  if (fd_ != -1) {
-    const auto ec = set_offsets();
-    (void)close();
-    if (ec)
-      return ec;
-  }
+  offsets_.clear();
+  cache_.clear();
+  time_index_.clear();
+  last_timestamp_ = 0;
+  if (direct_io_ && !shared_tail_filename_.empty())
+    return {EINVAL, std::system_category()};
   fd_ = soup::open(filename_.c_str(), O_RDWR | O_CREAT);
   if (fd_ == -1)
     return {errno, std::system_category()};
+  auto ec = recover();
+  if (!ec && direct_io_)
+    ec = start_direct_io();
+  if (!ec && !shared_tail_filename_.empty()) {
+    if (const auto tail = Shared_tail::map(shared_tail_filename_, true))
+      shared_tail_ = *tail;
+    else
+      ec = tail.error();
+  }
+  if (ec) {
+    (void)close();
+    return ec;
+  }
+  publish();
   return {};
 }
 
 std::error_code File_store::close() {
   if (fd_ == -1)
     return {};
+  std::error_code ec;
+  if (tail_) {
+    ec = write_tail(true);
+    tail_.reset();
+  }
+  read_blocks_.reset();
+  read_blocks_size_ = 0;
+  Shared_tail::unmap(shared_tail_);
+  shared_tail_ = nullptr;
   const int status = soup::close(fd_);
   fd_ = -1;
-  if (status == -1)
-    return {errno, std::system_category()};
-  return {};
+  if (status == -1 && !ec)
+    ec.assign(errno, std::system_category());
+  return ec;
 }
 
 std::error_code File_store::add(const void* data, std::size_t size) {
-  const off_t off = lseek(fd_, 0, SEEK_END);
-  if (off == -1)
-    return {errno, std::system_category()};
-  offsets_.push_back(off);
+  return add(data, size,
+             timestamps_ ? std::chrono::system_clock::now()
+                         : std::chrono::system_clock::time_point{});
+}
 
-  {
-    const std::uint16_t sz = htons(size);
-    const auto res = soup::write(fd_, &sz, sizeof(sz));
-    if (res.status == detail::Write_status::failure)
-      return {errno, std::system_category()};
+std::error_code File_store::add(const void* data, std::size_t size,
+                                std::chrono::system_clock::time_point time) {
+  std::array<std::byte, max_header_size> header_array{};
+  const auto header = std::span(header_array).first(header_size());
+  const auto sz = htons(static_cast<std::uint16_t>(size));
+  std::memcpy(header.data(), &sz, sizeof(sz));
+  const auto timestamp = std::max(to_nanoseconds(time), last_timestamp_);
+  if (timestamps_) {
+    const auto ts = htobe64(static_cast<std::uint64_t>(timestamp));
+    std::memcpy(header.subspan(timestamp_offset()).data(), &ts, sizeof(ts));
+  }
+  if (checksums_) {
+    const auto crc = htonl(record_checksum(header, data, size));
+    std::memcpy(header.subspan(checksum_offset).data(), &crc, sizeof(crc));
   }
 
-  {
-    const auto res = soup::write(fd_, data, size);
+  if (tail_) {
+    if (const auto ec = append_direct(header, data, size))
+      return ec;
+  } else {
+    const auto res = write_record(fd_, end_, header, data, size);
     if (res.status == detail::Write_status::failure)
       return {errno, std::system_category()};
   }
+  offsets_.push_back(end_);
+  if (timestamps_)
+    index_time(offsets_.size(), timestamp);
+  end_ += static_cast<off_t>(header.size() + size);
+  cache_.add(offsets_.size(), data, size);
+  publish();
   return {};
 }
 
@@ -127,26 +363,131 @@ std::error_code File_store::add(const void* begin, const void* end) {
 
 std::error_code File_store::get(std::size_t first, std::size_t last,
                                 std::vector<Message>& messages) {
-  if (first < 1 || first > offsets_.size())
-    return {EINVAL, std::system_category()};
-  if (last < first || last > offsets_.size())
-    return {EINVAL, std::system_category()};
+  if (const auto ec = validate(first, last))
+    return ec;
 
-  const off_t off = lseek(fd_, offsets_[first - 1], SEEK_SET);
-  if (off == -1)
-    return {errno, std::system_category()};
+  const auto file_last = last_uncached(last);
+  if (first <= file_last) {
+    Buffer records(records_size(first, file_last));
+    if (const auto ec = read_records(first, file_last, records.data()))
+      return ec;
+    const auto count = messages.size();
+    const auto ec = split_records(
+        {records.data(), records.size()}, file_last - first + 1, header_size(),
+        [&messages](const std::byte* data, std::size_t size) {
+          Message& message = messages.emplace_back(size);
+          std::memcpy(message.data(), data, size);
+        });
+    if (ec) {
+      messages.resize(count);
+      return ec;
+    }
+  }
+  if (file_last < last) {
+    std::vector<Frame> frames;
+    [[maybe_unused]] const auto held =
+        cache_.get(std::max(first, file_last + 1), last, frames);
+    assert(held);
+    for (const auto& frame : frames) {
+      Message& message = messages.emplace_back(frame.size());
+      std::memcpy(message.data(), frame.data(), frame.size());
+    }
+  }
+  return {};
+}
 
-  for (std::size_t i = first; i <= last; ++i) {
-    Message message;
-    const auto ec = get(message);
-    if (ec)
+std::error_code File_store::get(std::size_t first, std::size_t last,
+                                std::vector<Frame>& frames) {
+  if (const auto ec = validate(first, last))
+    return ec;
+
+  const auto file_last = last_uncached(last);
+  if (first <= file_last) {
+    const auto size = records_size(first, file_last);
+    const std::shared_ptr<std::byte[]> block =
+        std::make_shared_for_overwrite<std::byte[]>(size);
+    if (const auto ec = read_records(first, file_last, block.get()))
+      return ec;
+    const auto count = frames.size();
+    const auto ec = split_records(
+        {block.get(), size}, file_last - first + 1, header_size(),
+        [&frames, &block](const std::byte* data, std::size_t size) {
+          frames.emplace_back(std::shared_ptr<const std::byte>(block, data),
+                              size);
+        });
+    if (ec) {
+      frames.resize(count);
       return ec;
-    messages.push_back(std::move(message));
+    }
+  }
+  if (file_last < last) {
+    [[maybe_unused]] const auto held =
+        cache_.get(std::max(first, file_last + 1), last, frames);
+    assert(held);
   }
   return {};
 }
 
+std::error_code File_store::will_need(std::size_t first,
+                                      std::size_t last) const {
+  if (const auto ec = validate(first, last))
+    return ec;
+  // Reads bypass the page cache.
+  if (tail_)
+    return {};
+  last = last_uncached(last);
+  if (last < first)
+    return {};
+  const auto status =
+      posix_fadvise(fd_, offsets_[first - 1],
+                    static_cast<off_t>(records_size(first, last)),
+                    POSIX_FADV_WILLNEED);
+  // Returns the error rather than setting errno
+  if (status != 0)
+    return {status, std::system_category()};
+  return {};
+}
+
+// The index holds the first message of each block of the file, so the one
+// wanted is in the block before the first entry at or after the time, or is
+// that entry.
+expected<std::size_t, std::error_code>
+File_store::sequence_number_at(std::chrono::system_clock::time_point time) {
+  if (!timestamps_)
+    return unexpected(std::error_code(EINVAL, std::system_category()));
+  const auto timestamp = to_nanoseconds(time);
+  const auto entry =
+      std::ranges::lower_bound(time_index_, timestamp, {}, &Time_entry::time);
+  if (entry == time_index_.begin())
+    return entry == time_index_.end() ? next_sequence_number()
+                                      : entry->sequence_number;
+
+  const auto first = std::prev(entry)->sequence_number;
+  const auto last = entry == time_index_.end() ? offsets_.size()
+                                               : entry->sequence_number;
+  const auto size = records_size(first, last);
+  Buffer records(size);
+  if (const auto ec = read_records(first, last, records.data()))
+    return unexpected(ec);
+  std::span rest(records.data(), size);
+  for (auto sequence_number = first; sequence_number <= last;
+       ++sequence_number) {
+    if (record_timestamp(rest.data()) >= timestamp)
+      return sequence_number;
+    rest = rest.subspan(header_size() + record_size(rest.data()));
+  }
+  return next_sequence_number();
+}
+
+File_store::Cursor File_store::cursor(std::size_t sequence_number) {
+  return {*this, sequence_number};
+}
+
 std::error_code File_store::sync() {
+  if (tail_) {
+    if (const auto ec = write_tail(true))
+      return ec;
+  }
   const int status = fsync(fd_);
   if (status == -1)
     return {errno, std::system_category()};
@@ -157,44 +498,353 @@ std::size_t File_store::next_sequence_number() const {
   return offsets_.size() + 1;
 }
 
-std::error_code File_store::set_offsets() {
-  off_t off = 0;
-  while (true) {
-    std::uint16_t sz = 0;
-    const auto res = soup::read(fd_, &sz, sizeof(sz));
-    if (res.status == detail::Read_status::failure)
-      return {errno, std::system_category()};
-    if (res.status == detail::Read_status::end_of_file)
+std::error_code File_store::validate(std::size_t first,
+                                     std::size_t last) const {
+  if (first < 1 || first > offsets_.size())
+    return {EINVAL, std::system_category()};
+  if (last < first || last > offsets_.size())
+    return {EINVAL, std::system_category()};
+  return {};
+}
+
+// The cache holds a run up to the last message, so only what precedes it
+// is read from the file.
+std::size_t File_store::last_uncached(std::size_t last) const {
+  if (!cache_.empty() && cache_.first_sequence_number() <= last)
+    return cache_.first_sequence_number() - 1;
+  return last;
+}
+
+std::size_t File_store::records_size(std::size_t first,
+                                     std::size_t last) const {
+  const auto begin = offsets_[first - 1];
+  const auto end = last < offsets_.size() ? offsets_[last] : end_;
+  return static_cast<std::size_t>(end - begin);
+}
+
+// The records are contiguous, so the whole range is read with one pread
+// rather than with two reads per message.
+std::error_code File_store::read_records(std::size_t first, std::size_t last,
+                                         std::byte* records) {
+  return read_range(offsets_[first - 1], records_size(first, last), records);
+}
+
+std::size_t File_store::header_size() const {
+  return timestamp_offset() +
+         (timestamps_ ? sizeof(std::uint64_t) : std::size_t{0});
+}
+
+std::size_t File_store::timestamp_offset() const {
+  return checksums_ ? checksum_end : checksum_offset;
+}
+
+std::int64_t File_store::record_timestamp(const std::byte* header) const {
+  std::uint64_t ts = 0;
+  // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the header
+  std::memcpy(&ts, header + timestamp_offset(), sizeof(ts));
+  return static_cast<std::int64_t>(be64toh(ts));
+}
+
+void File_store::publish() {
+  if (!shared_tail_)
+    return;
+  std::uint64_t flags = 0;
+  if (checksums_)
+    flags |= Shared_tail::checksums;
+  if (timestamps_)
+    flags |= Shared_tail::timestamps;
+  shared_tail_->store({.end = static_cast<std::uint64_t>(end_),
+                       .messages = offsets_.size(),
+                       .flags = flags});
+}
+
+// Indexes the message if it is the first to start in its block of the file.
+// Called in order, with the message's offset already recorded.
+void File_store::index_time(std::size_t sequence_number,
+                            std::int64_t timestamp) {
+  const auto block = offsets_[sequence_number - 1] / time_index_block_size;
+  if (sequence_number == 1 ||
+      offsets_[sequence_number - 2] / time_index_block_size != block)
+    time_index_.push_back({timestamp, sequence_number});
+  last_timestamp_ = timestamp;
+}
+
+// Indexes the records and drops a torn tail: a record cut short by a crash
+// during add() and, with checksums, every record from the first that fails
+// its check.
+std::error_code File_store::recover() {
+  struct stat st {};
+  if (fstat(fd_, &st) == -1)
+    return {errno, std::system_category()};
+  const auto file_size = static_cast<std::size_t>(st.st_size);
+  end_ = 0;
+  if (file_size == 0)
+    return {};
+
+  Mapping file;
+  if (const auto ec = file.map(fd_, file_size))
+    return ec;
+  // Each record is found from the size of the one before, so in order
+  const auto header = header_size();
+  std::size_t off = 0;
+  while (file_size - off >= header) {
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the file
+    const auto size = record_size(file.data() + off);
+    if (file_size - off - header < size)
       break;
-    const std::uint16_t size = ntohs(sz);
+    offsets_.push_back(static_cast<off_t>(off));
+    off += header + size;
+  }
+  end_ = static_cast<off_t>(off);
+  if (checksums_) {
+    const auto bad = first_bad_record(file.data(), file_size);
+    if (bad < offsets_.size()) {
+      off = static_cast<std::size_t>(offsets_[bad]);
+      offsets_.resize(bad);
+      end_ = static_cast<off_t>(off);
+    }
+  }
 
-    offsets_.push_back(off);
-    off = lseek(fd_, size, SEEK_CUR);
-    if (off == -1)
-      return {errno, std::system_category()};
+  if (timestamps_) {
+    for (std::size_t i = 1; i <= offsets_.size(); ++i) {
+      // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the file
+      index_time(i, record_timestamp(file.data() + offsets_[i - 1]));
+    }
   }
+
+  if (off < file_size && ftruncate(fd_, end_) == -1)
+    return {errno, std::system_category()};
   return {};
 }
 
-std::error_code File_store::get(Message& message) {
-  std::uint16_t sz = 0;
-  {
-    const auto res = soup::read(fd_, &sz, sizeof(sz));
-    if (res.status == detail::Read_status::failure)
-      return {errno, std::system_category()};
-    if (res.status == detail::Read_status::end_of_file)
-      return {EIO, std::system_category()};
+// Threads check the records of the verified part of the file, up to end_,
+// in chunks of contiguous records, each stopping at its first bad record.
+std::size_t File_store::first_bad_record(const std::byte* file,
+                                         std::size_t file_size) const {
+  // Less than this a thread is not worth starting for
+  constexpr std::size_t min_chunk_bytes = 4 * 1024 * 1024;
+
+  const auto verify_from =
+      verify_limit_ == 0 || verify_limit_ >= file_size
+          ? 0
+          : static_cast<off_t>(file_size - verify_limit_);
+  const auto begin = static_cast<std::size_t>(
+      std::ranges::lower_bound(offsets_, verify_from) - offsets_.begin());
+  const auto end = offsets_.size();
+  if (begin == end)
+    return end;
+
+  const auto bytes = static_cast<std::size_t>(end_ - offsets_[begin]);
+  const auto chunks = std::clamp<std::size_t>(
+      bytes / min_chunk_bytes, 1,
+      std::max(std::thread::hardware_concurrency(), 1U));
+
+  const auto first_bad = [this, file, end](std::size_t first,
+                                           std::size_t last) {
+    for (auto i = first; i < last; ++i) {
+      const auto off = static_cast<std::size_t>(offsets_[i]);
+      // NOLINTBEGIN(*-pro-bounds-pointer-arithmetic): Within the file
+      const std::span header(file + off, header_size());
+      const auto size = record_size(header.data());
+      std::uint32_t crc = 0;
+      std::memcpy(&crc, header.subspan(checksum_offset).data(), sizeof(crc));
+      if (ntohl(crc) != record_checksum(header, header.data() + header.size(),
+                                        size))
+        return i;
+      // NOLINTEND(*-pro-bounds-pointer-arithmetic)
+    }
+    return end;
+  };
+
+  // Chunk boundaries, by bytes rather than by records
+  std::vector<std::size_t> bounds{begin};
+  for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+    const auto chunk_begin =
+        offsets_[begin] + static_cast<off_t>(bytes / chunks * chunk);
+    bounds.push_back(static_cast<std::size_t>(
+        std::ranges::lower_bound(offsets_, chunk_begin) - offsets_.begin()));
   }
-  const std::uint16_t size = ntohs(sz);
+  bounds.push_back(end);
 
-  message = Message(size);
+  std::vector<std::size_t> results(chunks, end);
   {
-    const auto res = soup::read(fd_, message.data(), message.size());
+    std::vector<std::jthread> threads;
+    for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+      auto verify = [&results, &bounds, &first_bad, chunk] {
+        results[chunk] = first_bad(bounds[chunk], bounds[chunk + 1]);
+      };
+      try {
+        threads.emplace_back(verify);
+      } catch (const std::system_error&) {
+        verify();
+      }
+    }
+    results[0] = first_bad(bounds[0], bounds[1]);
+  }
+  return std::ranges::min(results);
+}
+
+void File_store::Aligned_delete::operator()(std::byte* p) const {
+  ::operator delete[](p, std::align_val_t{direct_block_size});
+}
+
+std::unique_ptr<std::byte[], File_store::Aligned_delete>
+File_store::allocate_blocks(std::size_t size) {
+  return std::unique_ptr<std::byte[], Aligned_delete>(static_cast<std::byte*>(
+      ::operator new[](size, std::align_val_t{direct_block_size})));
+}
+
+// Called once the file is indexed, when what recovery read of it can be
+// dropped from the page cache
+std::error_code File_store::start_direct_io() {
+  (void)posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+  const int flags = fcntl(fd_, F_GETFL);
+  if (flags == -1 || fcntl(fd_, F_SETFL, flags | O_DIRECT) == -1)
+    return {errno, std::system_category()};
+
+  tail_ = allocate_blocks(direct_buffer_size);
+  tail_offset_ = end_ / direct_block_size * direct_block_size;
+  if (tail_offset_ < end_) {
+    // Comes back short, at the end of the file
+    const auto n = while_interrupted<ssize_t>(
+        ::pread, fd_, tail_.get(), direct_block_size, tail_offset_);
+    if (n < end_ - tail_offset_) {
+      const std::error_code ec(n == -1 ? errno : EIO, std::system_category());
+      tail_.reset();
+      return ec;
+    }
+  }
+  return {};
+}
+
+std::error_code File_store::append_direct(std::span<const std::byte> header,
+                                          const void* data, std::size_t size) {
+  auto used = static_cast<std::size_t>(end_ - tail_offset_);
+  if (direct_buffer_size - used < header.size() + size) {
+    if (const auto ec = write_tail(false))
+      return ec;
+    used = static_cast<std::size_t>(end_ - tail_offset_);
+  }
+  const std::span buffer(tail_.get(), direct_buffer_size);
+  std::memcpy(buffer.subspan(used).data(), header.data(), header.size());
+  std::memcpy(buffer.subspan(used + header.size()).data(), data, size);
+  return {};
+}
+
+// Writes the whole blocks of the buffer and, if asked, the partial block
+// after them, padded and then cut from the file. The padding is all ones, so
+// that if a crash leaves it in the file its first header gives a size larger
+// than the rest of the block, which recovery drops as a record cut short.
+// Only whole blocks leave the buffer.
+std::error_code File_store::write_tail(bool partial) {
+  const std::span buffer(tail_.get(), direct_buffer_size);
+  const auto used = static_cast<std::size_t>(end_ - tail_offset_);
+  const auto whole = used / direct_block_size * direct_block_size;
+  auto size = whole;
+  if (partial && used > whole) {
+    size += direct_block_size;
+    std::ranges::fill(buffer.subspan(used, size - used), std::byte{0xff});
+  }
+  if (size == 0)
+    return {};
+
+  const auto res = write_at(fd_, tail_offset_, buffer.data(), size);
+  if (res.status == detail::Write_status::failure)
+    return {errno, std::system_category()};
+  if (size > whole && ftruncate(fd_, end_) == -1)
+    return {errno, std::system_category()};
+  std::memmove(buffer.data(), buffer.subspan(whole).data(), used - whole);
+  tail_offset_ += static_cast<off_t>(whole);
+  return {};
+}
+
+// With direct I/O, the part written is read in whole blocks, through a
+// buffer kept from one read to the next, and the rest copied from the tail
+// buffer.
+std::error_code File_store::read_range(off_t offset, std::size_t size,
+                                       std::byte* data) {
+  const std::span out(data, size);
+  const auto end = offset + static_cast<off_t>(size);
+  const auto file_end = tail_ ? std::min(end, tail_offset_) : end;
+  if (offset < file_end) {
+    const auto file_size = static_cast<std::size_t>(file_end - offset);
+    if (!tail_) {
+      const auto res = read_at(fd_, offset, data, file_size);
+      if (res.status == detail::Read_status::failure)
+        return {errno, std::system_category()};
+      if (res.status == detail::Read_status::end_of_file)
+        return {EIO, std::system_category()};
+      return {};
+    }
+
+    constexpr auto block = static_cast<off_t>(direct_block_size);
+    const auto begin = offset / block * block;
+    const auto blocks_end = (file_end + block - 1) / block * block;
+    const auto blocks_size = static_cast<std::size_t>(blocks_end - begin);
+    if (read_blocks_size_ < blocks_size) {
+      read_blocks_ = allocate_blocks(blocks_size);
+      read_blocks_size_ = blocks_size;
+    }
+    const auto res = read_at(fd_, begin, read_blocks_.get(), blocks_size);
     if (res.status == detail::Read_status::failure)
       return {errno, std::system_category()};
     if (res.status == detail::Read_status::end_of_file)
       return {EIO, std::system_category()};
+    const std::span read(read_blocks_.get(), blocks_size);
+    std::ranges::copy(
+        read.subspan(static_cast<std::size_t>(offset - begin), file_size),
+        out.begin());
+  }
+  if (tail_ && end > tail_offset_) {
+    const auto from = std::max(offset, tail_offset_);
+    const std::span buffer(tail_.get(), direct_buffer_size);
+    std::ranges::copy(
+        buffer.subspan(static_cast<std::size_t>(from - tail_offset_),
+                       static_cast<std::size_t>(end - from)),
+        out.subspan(static_cast<std::size_t>(from - offset)).begin());
+  }
+  return {};
+}
+
+File_store::Cursor::Cursor(File_store& store, std::size_t sequence_number)
+    : store_(&store), next_(sequence_number) {}
+
+std::error_code File_store::Cursor::read(std::size_t max_messages,
+                                         std::size_t max_bytes) {
+  messages_.clear();
+  if (next_ < 1)
+    return {EINVAL, std::system_category()};
+  const auto stored = store_->offsets_.size();
+  if (next_ > stored || max_messages == 0)
+    return {};
+
+  // Records are back to back, so the last message within the byte limit is
+  // found by bisection. The first is read whatever its size.
+  const auto first = next_;
+  const auto last_allowed =
+      first - 1 + std::min(max_messages, stored - first + 1);
+  const auto within_limit = [this, first, max_bytes](std::size_t last) {
+    return store_->records_size(first, last) <= max_bytes;
+  };
+  const auto candidates = std::views::iota(first + 1, last_allowed + 1);
+  const auto beyond = std::ranges::partition_point(candidates, within_limit);
+  const auto last = beyond == candidates.end() ? last_allowed : *beyond - 1;
+
+  const auto records_size = store_->records_size(first, last);
+  if (buffer_.size() < records_size)
+    buffer_ = Buffer(records_size);
+  if (const auto ec = store_->read_records(first, last, buffer_.data()))
+    return ec;
+  const auto ec = split_records(
+      {buffer_.data(), records_size}, last - first + 1, store_->header_size(),
+      [this](const std::byte* data, std::size_t size) {
+        messages_.emplace_back(data, size);
+      });
+  if (ec) {
+    messages_.clear();
+    return ec;
   }
+  next_ = last + 1;
   return {};
 }
 
@@ -1,12 +1,15 @@
 #include "bc/soup/heartbeat_timer.h"
 
-#include "bc/soup/constants.h"
+#include <utility>
 
 namespace bc::soup {
 
 Heartbeat_timer::Heartbeat_timer(asio::any_io_executor io_executor,
-                                 Handler& handler, std::chrono::seconds timeout)
-    : handler_(&handler), timer_(io_executor), timeout_(timeout) {}
+                                 Handler& handler,
+                                 std::chrono::milliseconds period,
+                                 std::chrono::milliseconds timeout)
+    : handler_(&handler), timer_(io_executor), period_(period),
+      timeout_(timeout) {}
 
 void Heartbeat_timer::start() {
   if (started_)
@@ -36,17 +39,19 @@ void Heartbeat_timer::stop() {
 
 void Heartbeat_timer::schedule() {
   try {
-    timer_.expires_at(timer_.expiry() + heartbeat_period);
+    timer_.expires_at(timer_.expiry() + period_);
   } catch (const asio::system_error& e) {
     handler_->heartbeat_timer_error(e.code(), "timer expires_at");
     return;
   }
   wait_pending_ = true;
-  timer_.async_wait([this](asio::error_code ec) {
+  auto on_completion = [this](asio::error_code ec) {
     wait_pending_ = false;
     on_expiry(ec);
     maybe_signal_stopped();
-  });
+  };
+
+  timer_.async_wait(bind_memory(wait_memory_, std::move(on_completion)));
 }
 
 void Heartbeat_timer::on_expiry(asio::error_code ec) {
@@ -58,13 +63,13 @@ void Heartbeat_timer::on_expiry(asio::error_code ec) {
   }
 
   if (receive_count_ == 0) {
-    no_receive_period_ += heartbeat_period;
+    no_receive_period_ += period_;
     if (no_receive_period_ >= timeout_) {
       handler_->heartbeat_receive_timeout();
       return;
     }
   } else {
-    no_receive_period_ = std::chrono::seconds::zero();
+    no_receive_period_ = std::chrono::milliseconds::zero();
     receive_count_ = 0;
   }
 
@@ -1,9 +1,11 @@
 #include "bc/soup/login_timer.h"
 
+#include <utility>
+
 namespace bc::soup {
 
 Login_timer::Login_timer(asio::any_io_executor io_executor, Handler& handler,
-                         std::chrono::seconds timeout)
+                         std::chrono::milliseconds timeout)
     : handler_(&handler), timer_(io_executor), timeout_(timeout) {}
 
 void Login_timer::start() {
@@ -18,11 +20,13 @@ void Login_timer::start() {
     return;
   }
   wait_pending_ = true;
-  timer_.async_wait([this](asio::error_code ec) {
+  auto on_completion = [this](asio::error_code ec) {
     wait_pending_ = false;
     on_expiry(ec);
     maybe_signal_stopped();
-  });
+  };
+
+  timer_.async_wait(bind_memory(wait_memory_, std::move(on_completion)));
 }
 
 void Login_timer::stop() {
@@ -0,0 +1,195 @@
+#include "bc/soup/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bc::soup {
+
+void Latency_histogram::record(std::chrono::nanoseconds latency) {
+  const auto ns = latency.count() < 0
+                      ? std::uint64_t{0}
+                      : static_cast<std::uint64_t>(latency.count());
+  ++buckets_[bucket_index(ns)];
+}
+
+void Latency_histogram::merge(const Latency_histogram& other) {
+  for (std::size_t i = 0; i < bucket_count; ++i)
+    buckets_[i] += other.buckets_[i];
+}
+
+std::uint64_t Latency_histogram::count() const {
+  std::uint64_t n = 0;
+  for (const auto b : buckets_)
+    n += b;
+  return n;
+}
+
+std::chrono::nanoseconds Latency_histogram::percentile(double p) const {
+  const auto n = count();
+  if (n == 0)
+    return std::chrono::nanoseconds::zero();
+  const auto rank = std::clamp<std::uint64_t>(
+      static_cast<std::uint64_t>(std::ceil(p * static_cast<double>(n))), 1, n);
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < bucket_count; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank)
+      return std::chrono::nanoseconds(bucket_value(i));
+  }
+  return std::chrono::nanoseconds(bucket_value(bucket_count - 1));
+}
+
+namespace {
+
+Traffic_counts
+sum(const std::array<Traffic_counts, packet_type_count>& counts) {
+  Traffic_counts total;
+  for (const auto& c : counts) {
+    total.packets += c.packets;
+    total.bytes += c.bytes;
+  }
+  return total;
+}
+
+void add(std::array<Traffic_counts, packet_type_count>& counts,
+         const std::array<Traffic_counts, packet_type_count>& other) {
+  for (std::size_t i = 0; i < packet_type_count; ++i) {
+    counts[i].packets += other[i].packets;
+    counts[i].bytes += other[i].bytes;
+  }
+}
+
+} // namespace
+
+Traffic_counts Connection_metrics::Snapshot::received() const {
+  return sum(received_by_type);
+}
+
+Traffic_counts Connection_metrics::Snapshot::received(char packet_type) const {
+  return received_by_type[packet_type_index(packet_type)];
+}
+
+Traffic_counts Connection_metrics::Snapshot::sent() const {
+  return sum(sent_by_type);
+}
+
+Traffic_counts Connection_metrics::Snapshot::sent(char packet_type) const {
+  return sent_by_type[packet_type_index(packet_type)];
+}
+
+void Connection_metrics::Snapshot::merge(const Snapshot& other) {
+  add(received_by_type, other.received_by_type);
+  add(sent_by_type, other.sent_by_type);
+  write_queue_depth += other.write_queue_depth;
+  write_queue_high_water_mark =
+      std::max(write_queue_high_water_mark, other.write_queue_high_water_mark);
+  max_receive_gap = std::max(max_receive_gap, other.max_receive_gap);
+  write_latency.merge(other.write_latency);
+}
+
+Connection_metrics::Connection_metrics(
+    Metrics_registry& registry, const asio::ip::tcp::endpoint& remote_endpoint)
+    : registry_(&registry), remote_endpoint_(remote_endpoint) {
+  registry_->add(*this);
+}
+
+Connection_metrics::~Connection_metrics() {
+  registry_->remove(*this);
+}
+
+Connection_metrics::Snapshot Connection_metrics::snapshot() const {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  Snapshot s;
+  s.remote_endpoint = remote_endpoint_;
+  for (std::size_t i = 0; i < packet_type_count; ++i) {
+    s.received_by_type[i].packets = received_packets_[i].load(relaxed);
+    s.received_by_type[i].bytes = received_bytes_[i].load(relaxed);
+    s.sent_by_type[i].packets = sent_packets_[i].load(relaxed);
+    s.sent_by_type[i].bytes = sent_bytes_[i].load(relaxed);
+  }
+  s.write_queue_depth = write_queue_depth_.load(relaxed);
+  s.write_queue_high_water_mark = write_queue_high_water_mark_.load(relaxed);
+  s.max_receive_gap = std::chrono::nanoseconds(max_receive_gap_.load(relaxed));
+  auto& buckets = s.write_latency.buckets();
+  for (std::size_t i = 0; i < Latency_histogram::bucket_count; ++i)
+    buckets[i] = write_latency_[i].load(relaxed);
+  return s;
+}
+
+double Arbitration_metrics::Snapshot::win_rate() const {
+  const auto delivered = wins + duplicates;
+  if (delivered == 0)
+    return 0.0;
+  return static_cast<double>(wins) / static_cast<double>(delivered);
+}
+
+Arbitration_metrics::Arbitration_metrics(Metrics_registry& registry,
+                                         const Endpoint& endpoint)
+    : registry_(&registry), endpoint_(endpoint) {
+  registry_->add(*this);
+}
+
+Arbitration_metrics::~Arbitration_metrics() {
+  registry_->remove(*this);
+}
+
+Arbitration_metrics::Snapshot Arbitration_metrics::snapshot() const {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  Snapshot s;
+  s.endpoint = endpoint_;
+  s.wins = wins_.load(relaxed);
+  s.duplicates = duplicates_.load(relaxed);
+  auto& lead = s.lead.buckets();
+  auto& lag = s.lag.buckets();
+  for (std::size_t i = 0; i < Latency_histogram::bucket_count; ++i) {
+    lead[i] = lead_[i].load(relaxed);
+    lag[i] = lag_[i].load(relaxed);
+  }
+  return s;
+}
+
+Metrics_registry::Snapshot Metrics_registry::snapshot() const {
+  Snapshot s;
+  s.time = std::chrono::steady_clock::now();
+  const std::scoped_lock lock(mutex_);
+  s.connections.reserve(connections_.size());
+  s.total = closed_;
+  for (const auto* metrics : connections_)
+    s.total.merge(s.connections.emplace_back(metrics->snapshot()));
+  s.closed_connections = closed_connections_;
+  s.lines.reserve(lines_.size());
+  for (const auto* metrics : lines_)
+    s.lines.push_back(metrics->snapshot());
+  return s;
+}
+
+void Metrics_registry::add(const Connection_metrics& metrics) {
+  const std::scoped_lock lock(mutex_);
+  connections_.push_back(&metrics);
+}
+
+void Metrics_registry::remove(const Connection_metrics& metrics) {
+  auto s = metrics.snapshot();
+  // A closed connection has nothing queued.
+  s.write_queue_depth = 0;
+  const std::scoped_lock lock(mutex_);
+  const auto iter = std::ranges::find(connections_, &metrics);
+  if (iter == connections_.end())
+    return;
+  *iter = connections_.back();
+  connections_.pop_back();
+  closed_.merge(s);
+  ++closed_connections_;
+}
+
+void Metrics_registry::add(const Arbitration_metrics& metrics) {
+  const std::scoped_lock lock(mutex_);
+  lines_.push_back(&metrics);
+}
+
+void Metrics_registry::remove(const Arbitration_metrics& metrics) {
+  const std::scoped_lock lock(mutex_);
+  std::erase(lines_, &metrics);
+}
+
+} // namespace bc::soup
@@ -0,0 +1,43 @@
+#include "bc/soup/reconnect_policy.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bc::soup {
+
+Reconnect_backoff::Reconnect_backoff(const Reconnect_policy& policy)
+    : Reconnect_backoff(policy, std::random_device()()) {}
+
+Reconnect_backoff::Reconnect_backoff(const Reconnect_policy& policy,
+                                     std::minstd_rand::result_type seed)
+    : policy_(policy), random_(seed) {}
+
+void Reconnect_backoff::set_policy(const Reconnect_policy& policy) {
+  policy_ = policy;
+}
+
+std::chrono::milliseconds Reconnect_backoff::next_delay() {
+  if (std::exchange(first_, false) && policy_.immediate_first_retry)
+    return std::chrono::milliseconds::zero();
+
+  ceiling_ = (ceiling_ == std::chrono::milliseconds::zero())
+                 ? policy_.initial_delay
+                 : std::min(ceiling_ * policy_.multiplier, policy_.max_delay);
+  if (!policy_.full_jitter)
+    return ceiling_;
+  std::uniform_int_distribution<std::chrono::milliseconds::rep> distribution(
+      0, ceiling_.count());
+  return std::chrono::milliseconds(distribution(random_));
+}
+
+void Reconnect_backoff::reset() {
+  ceiling_ = std::chrono::milliseconds::zero();
+  first_ = false;
+}
+
+void Reconnect_backoff::on_login() {
+  reset();
+  first_ = true;
+}
+
+} // namespace bc::soup
@@ -1,12 +1,14 @@
 #include "bc/soup/reconnect_timer.h"
 
+#include <utility>
+
 namespace bc::soup {
 
 Reconnect_timer::Reconnect_timer(asio::any_io_executor io_executor,
                                  Handler& handler)
     : handler_(&handler), timer_(io_executor) {}
 
-void Reconnect_timer::start(std::chrono::seconds delay) {
+void Reconnect_timer::start(std::chrono::milliseconds delay) {
   if (started_)
     return;
   started_ = true;
@@ -19,11 +21,13 @@ void Reconnect_timer::start(std::chrono::seconds delay) {
     return;
   }
   ++epoch_;
-  timer_.async_wait([this, epoch = epoch_](asio::error_code ec) {
+  auto on_completion = [this, epoch = epoch_](asio::error_code ec) {
     if (epoch != epoch_)
       return;
     on_expiry(ec);
-  });
+  };
+
+  timer_.async_wait(bind_memory(wait_memory_, std::move(on_completion)));
 }
 
 void Reconnect_timer::stop() {
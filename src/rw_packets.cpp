@@ -65,6 +65,12 @@ Read_packet::Resize_result Read_packet::resize_payload() {
   return Resize_result::resized;
 }
 
+std::uint16_t Packet_view::packet_size() const {
+  std::uint16_t size = 0;
+  unpack(size, data_);
+  return size;
+}
+
 Write_packet::Write_packet(char packet_type) : Write_packet(packet_type, 0) {}
 
 Write_packet::Write_packet(char packet_type, std::uint16_t payload_size)
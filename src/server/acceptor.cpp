@@ -5,7 +5,6 @@
 #include "bc/soup/login_reject.h"
 #include "bc/soup/server/handler.h"
 #include "bc/soup/server/server.h"
-#include "bc/soup/socket.h"
 #include "bc/soup/validate.h"
 
 #include <algorithm>
@@ -14,26 +13,29 @@
 namespace bc::soup::server {
 
 Acceptor::Acceptor(asio::any_io_executor io_executor,
-                   const asio::ip::tcp::endpoint& endpoint, Server& server,
+                   const Endpoint& endpoint, Server& server,
                    Acceptor_handler* handler)
     : server_(&server),
       handler_(handler),
       endpoint_(endpoint),
-      acceptor_(io_executor, *this) {}
+      acceptor_(io_executor, *this),
+      timeouts_(server.timeouts()) {}
 
 void Acceptor::accept_failure(asio::error_code ec) {
   handler_->accept_failure(ec);
   acceptor_.async_accept();
 }
 
-void Acceptor::accept_success(asio::ip::tcp::socket&& s) {
-  Socket socket(std::move(s));
-  socket.set_write_packets_limit(write_packets_limit_);
-  const auto local_endpoint = socket.local_endpoint();
-  const auto remote_endpoint = socket.remote_endpoint();
+void Acceptor::accept_success(
+    asio::generic::stream_protocol::socket&& socket) {
+  asio::error_code ec;
+  const auto local_endpoint = to_tcp(socket.local_endpoint(ec));
+  const auto remote_endpoint = to_tcp(socket.remote_endpoint(ec));
   handler_->accept_success(local_endpoint, remote_endpoint);
   auto& connection = connections_.emplace_back(
-      acceptor_.get_executor(), std::move(socket), *this, *handler_);
+      acceptor_.get_executor(), std::move(socket), *this, *handler_,
+      write_packets_limit_, zero_copy_threshold_, timeouts_,
+      server_->metrics_registry());
   if (!debug_banner_.empty())
     (void)connection.send_debug_packet(debug_banner_);
   acceptor_.async_accept();
@@ -47,10 +49,21 @@ void Acceptor::set_write_packets_limit(std::size_t write_packets_limit) {
   write_packets_limit_ = write_packets_limit;
 }
 
+void Acceptor::set_zero_copy_threshold(std::size_t zero_copy_threshold) {
+  zero_copy_threshold_ = zero_copy_threshold;
+}
+
 void Acceptor::set_debug_banner(std::string_view debug_banner) {
   debug_banner_ = debug_banner;
 }
 
+std::error_code Acceptor::set_timeouts(const Timeouts& timeouts) {
+  if (const auto ec = validate_timeouts(timeouts))
+    return ec;
+  timeouts_ = timeouts;
+  return {};
+}
+
 expected<Port*, std::error_code> Acceptor::add_port(std::string_view username,
                                                     std::string_view password) {
   return add_port(username, password, nullptr);
@@ -88,7 +101,7 @@ bool Acceptor::is_handler_set() const {
 }
 
 void Acceptor::start() {
-  if (const auto ec = acceptor_.open()) {
+  if (const auto ec = acceptor_.open(endpoint_.protocol())) {
     handler_->listen_setup_failure(ec, "open");
     return;
   }
@@ -96,9 +109,11 @@ void Acceptor::start() {
     handler_->listen_setup_failure(ec, "set_reuse_address");
     return;
   }
-  if (const auto ec = acceptor_.set_no_delay()) {
-    handler_->listen_setup_failure(ec, "set_no_delay");
-    return;
+  if (is_tcp(endpoint_)) {
+    if (const auto ec = acceptor_.set_no_delay()) {
+      handler_->listen_setup_failure(ec, "set_no_delay");
+      return;
+    }
   }
   if (const auto ec = acceptor_.bind(endpoint_)) {
     handler_->listen_setup_failure(ec, "bind");
@@ -108,7 +123,7 @@ void Acceptor::start() {
     handler_->listen_setup_failure(ec, "listen");
     return;
   }
-  const auto local_endpoint = acceptor_.local_endpoint();
+  const auto local_endpoint = to_tcp(acceptor_.local_endpoint());
   handler_->listen_setup_success(local_endpoint);
   acceptor_.async_accept();
 }
@@ -143,8 +158,7 @@ Acceptor::on_login_request(Tcp_connection& connection,
 
 void Acceptor::on_closed(Tcp_connection& connection, Port_handler* port_handler,
                          Disconnect_reason reason) {
-  connections_.remove_if(
-      [&connection](const auto& element) { return &connection == &element; });
+  connections_.erase(connection);
   if (port_handler)
     port_handler->disconnect(reason);
   else
@@ -36,15 +36,14 @@ Write_error Port::send_message(const void* data, std::size_t size) {
   return error;
 }
 
-// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved via release_packet
+// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved only on success
 Write_error Port::send_message(Message&& message) {
   if (message.payload_size() == 0)
     return Write_error::empty_buffer;
   if (!message.payload_data())
     return Write_error::null_buffer;
 
-  auto packet = message.release_packet();
-  const auto error = send_packet(std::move(packet));
+  const auto error = send_packet(std::move(message.packet()));
   if (error == Write_error::none)
     ++next_sequence_number_;
   return error;
@@ -0,0 +1,111 @@
+#include "bc/soup/server/port_session.h"
+
+#include "bc/soup/server/message.h"
+#include "bc/soup/server/port.h"
+
+#include <utility>
+
+namespace bc::soup::server {
+
+Port_session::Port_session(asio::any_io_executor io_executor, Port& port)
+    : port_(&port), readable_(io_executor), writable_(io_executor) {
+  port.set_handler(*this);
+}
+
+Port_session::Port_session(asio::any_io_executor io_executor, Port& port,
+                           Port_handler& handler)
+    : port_(&port),
+      handler_(&handler),
+      readable_(io_executor),
+      writable_(io_executor) {
+  port.set_handler(*this);
+}
+
+asio::awaitable<Write_error> Port_session::send(const void* data,
+                                                std::size_t size) {
+  const auto cancellations = cancellations_;
+  auto error = port_->send_message(data, size);
+  while (error == Write_error::buffer_full && cancellations == cancellations_) {
+    co_await writable_.wait();
+    error = port_->send_message(data, size);
+  }
+  co_return error;
+}
+
+// NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved only on success
+asio::awaitable<Write_error> Port_session::send(Message&& message) {
+  const auto cancellations = cancellations_;
+  auto error = port_->send_message(std::move(message));
+  while (error == Write_error::buffer_full && cancellations == cancellations_) {
+    co_await writable_.wait();
+    error = port_->send_message(std::move(message));
+  }
+  co_return error;
+}
+
+asio::awaitable<std::span<const Unsequenced_data>>
+Port_session::next_messages() {
+  while (batch_.empty() && !read_interrupted_)
+    co_await readable_.wait();
+  read_interrupted_ = false;
+  co_return batch_.take();
+}
+
+void Port_session::cancel() {
+  ++cancellations_;
+  writable_.notify();
+  interrupt_reads();
+}
+
+void Port_session::login_success(const Login_accepted_packet& packet) {
+  if (handler_)
+    handler_->login_success(packet);
+}
+
+void Port_session::unsequenced_data(const void* data, std::size_t size) {
+  batch_.add({data, size});
+  readable_.notify();
+}
+
+void Port_session::logout_request() {
+  interrupt_reads();
+  if (handler_)
+    handler_->logout_request();
+}
+
+void Port_session::write_buffer_empty() {
+  writable_.notify();
+  if (handler_)
+    handler_->write_buffer_empty();
+}
+
+void Port_session::debug(std::string_view text) {
+  if (handler_)
+    handler_->debug(text);
+}
+
+void Port_session::transport_error(asio::error_code ec,
+                                   std::string_view what) {
+  if (handler_)
+    handler_->transport_error(ec, what);
+}
+
+void Port_session::protocol_violation(Packet_error error) {
+  if (handler_)
+    handler_->protocol_violation(error);
+}
+
+void Port_session::disconnect(Disconnect_reason reason) {
+  // A waiting send() then finds the port disconnected.
+  writable_.notify();
+  interrupt_reads();
+  if (handler_)
+    handler_->disconnect(reason);
+}
+
+void Port_session::interrupt_reads() {
+  read_interrupted_ = true;
+  readable_.notify();
+}
+
+} // namespace bc::soup::server
@@ -0,0 +1,246 @@
+#include "bc/soup/server/replay_scheduler.h"
+
+#include "bc/soup/file_store.h"
+#include "bc/soup/server/port.h"
+#include "bc/soup/types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace bc::soup::server {
+
+Replay_scheduler::Replay_scheduler(asio::any_io_executor io_executor,
+                                   File_store& store)
+    : store_(&store), timer_(io_executor) {}
+
+void Replay_scheduler::set_quantum(std::size_t bytes) {
+  quantum_ = std::max<std::size_t>(bytes, 1);
+  // The bucket holds up to a quantum, whichever order the two are set in.
+  tokens_ = std::min(tokens_, static_cast<double>(quantum_));
+}
+
+void Replay_scheduler::set_rate_limit(std::size_t bytes_per_second) {
+  rate_limit_ = bytes_per_second;
+  tokens_ = static_cast<double>(quantum_);
+  refilled_ = std::chrono::steady_clock::now();
+}
+
+void Replay_scheduler::add(Port& port) {
+  remove(port);
+  if (port.next_sequence_number() >= store_->next_sequence_number())
+    return;
+
+  Replay& replay = replays_.emplace_back();
+  replay.port = &port;
+  schedule({});
+}
+
+std::error_code
+Replay_scheduler::rewind(Port& port,
+                         std::chrono::system_clock::time_point time) {
+  const auto sequence_number = store_->sequence_number_at(time);
+  if (!sequence_number)
+    return sequence_number.error();
+  port.set_next_sequence_number(*sequence_number);
+  return {};
+}
+
+void Replay_scheduler::remove(const Port& port) {
+  const auto it = find(port);
+  if (it == replays_.end())
+    return;
+  if (static_cast<std::size_t>(it - replays_.begin()) < next_turn_)
+    --next_turn_;
+  replays_.erase(it);
+}
+
+void Replay_scheduler::write_buffer_empty(const Port& port) {
+  if (find(port) != replays_.end())
+    schedule({});
+}
+
+void Replay_scheduler::stop() {
+  replays_.clear();
+  next_turn_ = 0;
+  try {
+    timer_.cancel();
+  } catch (const asio::system_error&) {
+  }
+}
+
+bool Replay_scheduler::is_replaying(const Port& port) const {
+  return find(port) != replays_.end();
+}
+
+std::vector<Replay_scheduler::Progress> Replay_scheduler::progress() const {
+  std::vector<Progress> progress;
+  progress.reserve(replays_.size());
+  for (const auto& replay : replays_) {
+    progress.push_back({.port = replay.port,
+                        .next_sequence_number =
+                            replay.port->next_sequence_number(),
+                        .end_sequence_number = store_->next_sequence_number(),
+                        .messages_sent = replay.messages_sent,
+                        .bytes_sent = replay.bytes_sent,
+                        .error = replay.error});
+  }
+  return progress;
+}
+
+// A sooner round replaces a later one, so a port whose write buffer has
+// drained need not wait out the retry delay.
+void Replay_scheduler::schedule(std::chrono::steady_clock::duration delay) {
+  const auto expiry = std::chrono::steady_clock::now() + delay;
+  if (waits_pending_ != 0 && timer_.expiry() <= expiry)
+    return;
+
+  try {
+    timer_.expires_at(expiry);
+  } catch (const asio::system_error& e) {
+    fail(e.code());
+    return;
+  }
+  ++waits_pending_;
+  auto on_completion = [this](asio::error_code ec) {
+    --waits_pending_;
+    if (ec == asio::error::operation_aborted)
+      return;
+    if (ec) {
+      fail(ec);
+      return;
+    }
+    run_round();
+  };
+
+  timer_.async_wait(bind_memory(wait_memory_, std::move(on_completion)));
+}
+
+void Replay_scheduler::run_round() {
+  refill();
+  bool progressed = false;
+  auto turns = replays_.size();
+  auto i = replays_.empty() ? 0 : next_turn_ % replays_.size();
+  for (; turns > 0 && !replays_.empty(); --turns) {
+    if (rate_limit_ != 0 && tokens_ <= 0.0)
+      break;
+    if (i >= replays_.size())
+      i = 0;
+    switch (take_turn(replays_[i])) {
+    case Turn_result::progress:
+      progressed = true;
+      ++i;
+      break;
+    case Turn_result::blocked:
+    case Turn_result::failed:
+      ++i;
+      break;
+    case Turn_result::finished:
+      replays_.erase(replays_.begin() + static_cast<std::ptrdiff_t>(i));
+      break;
+    }
+  }
+  next_turn_ = i;
+
+  if (std::ranges::none_of(replays_,
+                           [](const Replay& r) { return !r.error; }))
+    return;
+  if (rate_limit_ != 0 && tokens_ <= 0.0) {
+    // Until the bucket holds something again
+    const std::chrono::duration<double> refill_time(
+        -tokens_ / static_cast<double>(rate_limit_));
+    schedule(std::max<std::chrono::steady_clock::duration>(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            refill_time),
+        retry_delay));
+  } else {
+    schedule(progressed ? std::chrono::steady_clock::duration{}
+                        : retry_delay);
+  }
+}
+
+Replay_scheduler::Turn_result Replay_scheduler::take_turn(Replay& replay) {
+  if (replay.error)
+    return Turn_result::failed;
+
+  auto budget = static_cast<double>(quantum_);
+  if (rate_limit_ != 0)
+    budget = std::min(budget, tokens_);
+  Port& port = *replay.port;
+  bool progressed = false;
+  double sent = 0.0;
+  while (sent < budget) {
+    // The frames read are only good while the port is where they start, e.g.
+    // not if it has been sent something else meanwhile.
+    if (replay.next_frame == replay.frames.size() ||
+        port.next_sequence_number() !=
+            replay.first_sequence_number + replay.next_frame) {
+      replay.frames.clear();
+      replay.next_frame = 0;
+      const auto first = port.next_sequence_number();
+      const auto end = store_->next_sequence_number();
+      if (first >= end)
+        return Turn_result::finished;
+      const auto last = std::min<std::uint64_t>(end - 1,
+                                                first + batch_messages - 1);
+      if (const auto ec = store_->get(first, last, replay.frames)) {
+        replay.frames.clear();
+        replay.error = ec;
+        return Turn_result::failed;
+      }
+      replay.first_sequence_number = first;
+      // Only a hint, so failing to give it is no reason to stop
+      if (last + 1 < end) {
+        (void)store_->will_need(
+            last + 1, std::min<std::uint64_t>(end - 1, last + batch_messages));
+      }
+    }
+
+    const Frame& frame = replay.frames[replay.next_frame];
+    const auto error = port.send_message(frame.data(), frame.size());
+    if (error == Write_error::buffer_full)
+      return progressed ? Turn_result::progress : Turn_result::blocked;
+    // Disconnected, or the session has ended
+    if (error != Write_error::none)
+      return Turn_result::finished;
+
+    ++replay.next_frame;
+    ++replay.messages_sent;
+    replay.bytes_sent += frame.size();
+    sent += static_cast<double>(frame.size());
+    if (rate_limit_ != 0)
+      tokens_ -= static_cast<double>(frame.size());
+    progressed = true;
+  }
+  return Turn_result::progress;
+}
+
+void Replay_scheduler::refill() {
+  if (rate_limit_ == 0)
+    return;
+  const auto now = std::chrono::steady_clock::now();
+  const std::chrono::duration<double> elapsed = now - refilled_;
+  tokens_ = std::min(static_cast<double>(quantum_),
+                     tokens_ + elapsed.count() *
+                                   static_cast<double>(rate_limit_));
+  refilled_ = now;
+}
+
+void Replay_scheduler::fail(std::error_code ec) {
+  for (auto& replay : replays_) {
+    if (!replay.error)
+      replay.error = ec;
+  }
+}
+
+std::vector<Replay_scheduler::Replay>::iterator
+Replay_scheduler::find(const Port& port) {
+  return std::ranges::find(replays_, &port, &Replay::port);
+}
+
+std::vector<Replay_scheduler::Replay>::const_iterator
+Replay_scheduler::find(const Port& port) const {
+  return std::ranges::find(replays_, &port, &Replay::port);
+}
+
+} // namespace bc::soup::server
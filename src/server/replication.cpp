@@ -0,0 +1,160 @@
+#include "bc/soup/server/replication.h"
+
+#include "bc/soup/client/journal.h"
+#include "bc/soup/file_store.h"
+#include "bc/soup/server/port.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <endian.h>
+
+namespace bc::soup::server {
+
+std::array<std::byte, Replication_acknowledgement::size>
+Replication_acknowledgement::encode() const {
+  std::array<std::byte, size> data{};
+  data[0] = static_cast<std::byte>(type);
+  const auto n = htobe64(next_sequence_number);
+  std::memcpy(&data[1], &n, sizeof(n));
+  return data;
+}
+
+bool Replication_acknowledgement::decode(const void* data, std::size_t n) {
+  const auto* bytes = static_cast<const std::byte*>(data);
+  if (n != size || bytes[0] != static_cast<std::byte>(type))
+    return false;
+  std::uint64_t next = 0;
+  // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the data
+  std::memcpy(&next, bytes + 1, sizeof(next));
+  next_sequence_number = be64toh(next);
+  return true;
+}
+
+Standby::Standby(asio::any_io_executor io_executor, client::Journal& journal)
+    : journal_(&journal), client_(io_executor, *this), timer_(io_executor) {
+  client_.set_batch_handler(*this);
+  client_.set_journal(journal);
+}
+
+// Not called: sequenced data goes to the batch handler.
+void Standby::sequenced_data(std::uint64_t, const void*, std::size_t) {}
+
+// Each message has been journaled before it is delivered.
+void Standby::sequenced_data(std::span<const client::Sequenced_data>) {
+  acknowledge();
+}
+
+void Standby::end_of_session() {
+  acknowledge();
+}
+
+void Standby::set_acknowledgement_interval(
+    std::chrono::milliseconds interval) {
+  acknowledgement_interval_ = interval;
+}
+
+expected<client::Connection*, std::error_code>
+Standby::add_connection(const Endpoint& endpoint,
+                        client::Connection_handler& handler) {
+  return client_.add_connection(endpoint, handler);
+}
+
+// From the end of the journal, so nothing is replayed to the standby itself
+std::error_code Standby::start() {
+  client_.set_next_sequence_number(journal_->next_sequence_number());
+  if (const auto ec = client_.start())
+    return ec;
+  started_ = true;
+  schedule_acknowledgement();
+  return {};
+}
+
+void Standby::stop() {
+  started_ = false;
+  client_.stop();
+  try {
+    timer_.cancel();
+  } catch (const asio::system_error&) {
+  }
+}
+
+// The client closes its connections from the io_context, and may journal
+// what it has already read until then, so the ports are set after.
+void Standby::promote(std::span<Port* const> ports) {
+  stop();
+  asio::post(timer_.get_executor(),
+             [this, ports = std::vector<Port*>(ports.begin(), ports.end())] {
+               const auto next = journal_->next_sequence_number();
+               for (auto* port : ports)
+                 port->set_next_sequence_number(next);
+               promoted_ = true;
+             });
+}
+
+// Best effort: one that does not fit the write buffer is made good by the
+// next.
+void Standby::acknowledge() {
+  const auto data =
+      Replication_acknowledgement{.next_sequence_number =
+                                      client_.next_sequence_number()}
+          .encode();
+  (void)client_.send_message(data.data(), data.size());
+}
+
+void Standby::schedule_acknowledgement() {
+  try {
+    timer_.expires_after(acknowledgement_interval_);
+  } catch (const asio::system_error&) {
+    return;
+  }
+  auto on_completion = [this](asio::error_code ec) {
+    if (ec || !started_)
+      return;
+    acknowledge();
+    schedule_acknowledgement();
+  };
+  timer_.async_wait(bind_memory(wait_memory_, std::move(on_completion)));
+}
+
+Replica::Replica(const File_store& store)
+    : store_(&store), acknowledged_(1),
+      acknowledged_time_(std::chrono::steady_clock::now()),
+      caught_up_time_(acknowledged_time_) {}
+
+// Each acknowledgement samples how far the store has got, so a later one
+// that reaches the sample shows the standby had all the store held then.
+bool Replica::unsequenced_data(const void* data, std::size_t size) {
+  Replication_acknowledgement acknowledgement;
+  if (!acknowledgement.decode(data, size))
+    return false;
+  const auto now = std::chrono::steady_clock::now();
+  acknowledged_ = std::max(acknowledged_, acknowledgement.next_sequence_number);
+  acknowledged_time_ = now;
+  samples_.push_back({store_->next_sequence_number(), now});
+  while (!samples_.empty() &&
+         samples_.front().next_sequence_number <= acknowledged_) {
+    caught_up_time_ = samples_.front().time;
+    samples_.pop_front();
+  }
+  // Losing the oldest only overstates the lag.
+  if (samples_.size() > max_samples)
+    samples_.pop_front();
+  return true;
+}
+
+Replica::Lag Replica::lag() const {
+  const auto now = std::chrono::steady_clock::now();
+  const auto end = store_->next_sequence_number();
+  Lag lag{.next_sequence_number = acknowledged_,
+          .since_acknowledged = now - acknowledged_time_};
+  if (end > acknowledged_) {
+    lag.messages = end - acknowledged_;
+    lag.time = now - caught_up_time_;
+  }
+  return lag;
+}
+
+} // namespace bc::soup::server
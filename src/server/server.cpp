@@ -14,14 +14,20 @@ std::error_code Server::set_session(std::string_view session) {
   return {};
 }
 
+std::error_code Server::set_timeouts(const Timeouts& timeouts) {
+  if (const auto ec = validate_timeouts(timeouts))
+    return ec;
+  timeouts_ = timeouts;
+  return {};
+}
+
 expected<Acceptor*, std::error_code>
-Server::add_acceptor(const asio::ip::tcp::endpoint& endpoint) {
+Server::add_acceptor(const Endpoint& endpoint) {
   return add_acceptor(endpoint, nullptr);
 }
 
 expected<Acceptor*, std::error_code>
-Server::add_acceptor(const asio::ip::tcp::endpoint& endpoint,
-                     Acceptor_handler& handler) {
+Server::add_acceptor(const Endpoint& endpoint, Acceptor_handler& handler) {
   return add_acceptor(endpoint, &handler);
 }
 
@@ -65,8 +71,7 @@ void Server::stop() {
 }
 
 expected<Acceptor*, std::error_code>
-Server::add_acceptor(const asio::ip::tcp::endpoint& endpoint,
-                     Acceptor_handler* handler) {
+Server::add_acceptor(const Endpoint& endpoint, Acceptor_handler* handler) {
   for (const auto& acceptor : acceptors_) {
     if (endpoint == acceptor.endpoint())
       return unexpected(Error::endpoint_in_use);
@@ -1,6 +1,7 @@
 #include "bc/soup/server/tcp_connection.h"
 
 #include "bc/soup/constants.h"
+#include "bc/soup/endpoint.h"
 #include "bc/soup/logical_packets.h"
 #include "bc/soup/login_reject.h"
 #include "bc/soup/rw_packets.h"
@@ -15,16 +16,37 @@ namespace bc::soup::server {
 
 using State = Connection_state::State;
 
+namespace {
+
+asio::ip::tcp::endpoint
+remote_endpoint(const asio::generic::stream_protocol::socket& socket) {
+  asio::error_code ec;
+  return to_tcp(socket.remote_endpoint(ec));
+}
+
+} // namespace
+
 Tcp_connection::Tcp_connection(asio::any_io_executor io_executor,
-                               Socket&& socket, Acceptor& acceptor,
-                               Acceptor_handler& acceptor_handler)
+                               asio::generic::stream_protocol::socket&& socket,
+                               Acceptor& acceptor,
+                               Acceptor_handler& acceptor_handler,
+                               std::size_t write_packets_limit,
+                               std::size_t zero_copy_threshold,
+                               const Timeouts& timeouts,
+                               Metrics_registry& metrics_registry)
     : acceptor_(&acceptor),
       acceptor_handler_(&acceptor_handler),
-      socket_(std::move(socket)),
-      login_timer_(io_executor, *this, login_request_timeout),
-      heartbeat_timer_(io_executor, *this, client_heartbeat_timeout) {
-
-  socket_.set_handler(*this);
+      metrics_(metrics_registry, remote_endpoint(socket)),
+      socket_(std::move(socket), *this),
+      login_timer_(io_executor, *this, timeouts.login_timeout),
+      heartbeat_timer_(io_executor, *this, timeouts.heartbeat_period,
+                       timeouts.heartbeat_timeout) {
+
+  socket_.set_write_packets_limit(write_packets_limit);
+  // Packets are copied as usual where zero-copy is unsupported.
+  if (zero_copy_threshold != 0)
+    (void)socket_.set_zero_copy(zero_copy_threshold);
+  socket_.set_metrics(metrics_);
   // NOLINTNEXTLINE(*-prefer-member-initializer): co-located with timer start
   login_timer_stopped_ = false;
   login_timer_.start();
@@ -47,17 +69,16 @@ void Tcp_connection::read_failure(Packet_error error) {
   handle_protocol_violation(error);
 }
 
-void Tcp_connection::read_success(const Read_packet& packet) {
+void Tcp_connection::read_success(const Packet_view& packet) {
   if (state_.is_closing())
     return;
   const auto error = process_packet(packet);
   if (error != Packet_error::none)
     handle_protocol_violation(error);
-  if (state_.is_closing())
-    return;
-  socket_.async_read();
 }
 
+void Tcp_connection::read_batch_complete() {}
+
 void Tcp_connection::read_aborted() {
   disconnect();
 }
@@ -119,7 +140,7 @@ void Tcp_connection::heartbeat_timer_stopped() {
   maybe_signal_closed();
 }
 
-Packet_error Tcp_connection::process_packet(const Read_packet& packet) {
+Packet_error Tcp_connection::process_packet(const Packet_view& packet) {
   const auto* data = packet.payload_data();
   const auto size = packet.payload_size();
   switch (packet.packet_type()) {
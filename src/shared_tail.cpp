@@ -0,0 +1,227 @@
+#include "bc/soup/shared_tail.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <endian.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bc::soup {
+namespace {
+
+using Field = std::atomic_ref<std::uint64_t>;
+
+static_assert(Field::is_always_lock_free,
+              "Shared with other processes, so must not need a lock");
+
+std::size_t header_size(std::uint64_t flags) {
+  std::size_t size = sizeof(std::uint16_t);
+  if ((flags & Shared_tail::checksums) != 0)
+    size += sizeof(std::uint32_t);
+  if ((flags & Shared_tail::timestamps) != 0)
+    size += sizeof(std::uint64_t);
+  return size;
+}
+
+} // namespace
+
+expected<Shared_tail*, std::error_code>
+Shared_tail::map(const std::string& filename, bool writer) {
+  constexpr mode_t mode = 0666;
+  const int fd = ::open(filename.c_str(), writer ? O_RDWR | O_CREAT : O_RDONLY,
+                        mode);
+  if (fd == -1)
+    return unexpected(std::error_code(errno, std::system_category()));
+  std::error_code ec;
+  void* data = MAP_FAILED;
+  struct stat st = {};
+  if (fstat(fd, &st) == -1) {
+    ec.assign(errno, std::system_category());
+  } else if (static_cast<std::size_t>(st.st_size) < sizeof(Shared_tail)) {
+    // A reader racing the writer's first open finds the file empty.
+    if (!writer)
+      ec.assign(ENOENT, std::system_category());
+    else if (ftruncate(fd, sizeof(Shared_tail)) == -1)
+      ec.assign(errno, std::system_category());
+  }
+  if (!ec) {
+    data = mmap(nullptr, sizeof(Shared_tail),
+                writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd,
+                0);
+    if (data == MAP_FAILED)
+      ec.assign(errno, std::system_category());
+  }
+  ::close(fd);
+  if (ec)
+    return unexpected(ec);
+  return static_cast<Shared_tail*>(data);
+}
+
+void Shared_tail::unmap(Shared_tail* tail) {
+  if (tail)
+    munmap(tail, sizeof(Shared_tail));
+}
+
+// Starts from the next odd number, so that a writer stopped part way
+// through leaves nothing for the next to trip over.
+void Shared_tail::store(const Position& position) {
+  Field seq(sequence);
+  const auto begin = (seq.load(std::memory_order_relaxed) + 1) | 1;
+  seq.store(begin, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  Field(end).store(position.end, std::memory_order_relaxed);
+  Field(messages).store(position.messages, std::memory_order_relaxed);
+  Field(flags).store(position.flags, std::memory_order_relaxed);
+  seq.store(begin + 1, std::memory_order_release);
+  Field(magic).store(magic_value, std::memory_order_release);
+}
+
+bool Shared_tail::load(Position& position) {
+  if (Field(magic).load(std::memory_order_acquire) != magic_value)
+    return false;
+  Field seq(sequence);
+  const auto begin = seq.load(std::memory_order_acquire);
+  if ((begin & 1) != 0)
+    return false;
+  const Position loaded{
+      .end = Field(end).load(std::memory_order_relaxed),
+      .messages = Field(messages).load(std::memory_order_relaxed),
+      .flags = Field(flags).load(std::memory_order_relaxed)};
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (seq.load(std::memory_order_relaxed) != begin)
+    return false;
+  position = loaded;
+  return true;
+}
+
+Tail_reader::Tail_reader(std::string_view filename,
+                         std::string_view tail_filename)
+    : filename_(filename), tail_filename_(tail_filename) {}
+
+Tail_reader::~Tail_reader() {
+  close();
+}
+
+void Tail_reader::set_filename(std::string_view filename) {
+  filename_ = filename;
+}
+
+void Tail_reader::set_tail_filename(std::string_view tail_filename) {
+  tail_filename_ = tail_filename;
+}
+
+std::error_code Tail_reader::open() {
+  close();
+  const auto tail = Shared_tail::map(tail_filename_, false);
+  if (!tail)
+    return tail.error();
+  tail_ = *tail;
+  fd_ = ::open(filename_.c_str(), O_RDONLY);
+  if (fd_ == -1) {
+    const std::error_code ec(errno, std::system_category());
+    close();
+    return ec;
+  }
+  next_ = 1;
+  offset_ = 0;
+  record_ = 1;
+  return {};
+}
+
+void Tail_reader::close() {
+  messages_.clear();
+  timestamps_.clear();
+  if (journal_) {
+    // NOLINTNEXTLINE(*-const-cast): Mapped by map_journal()
+    munmap(const_cast<std::byte*>(journal_), map_size_);
+    journal_ = nullptr;
+    map_size_ = 0;
+  }
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  Shared_tail::unmap(tail_);
+  tail_ = nullptr;
+}
+
+void Tail_reader::seek(std::size_t sequence_number) {
+  next_ = sequence_number;
+  if (next_ < record_) {
+    offset_ = 0;
+    record_ = 1;
+  }
+}
+
+std::error_code Tail_reader::read(std::size_t max_messages) {
+  messages_.clear();
+  timestamps_.clear();
+  if (!tail_)
+    return {EBADF, std::system_category()};
+
+  Shared_tail::Position position;
+  bool loaded = false;
+  for (int i = 0; i < load_attempts && !loaded; ++i)
+    loaded = tail_->load(position);
+  if (!loaded)
+    return {};
+  if (position.end < offset_ || position.messages + 1 < record_)
+    return {ESTALE, std::system_category()};
+  if (position.end > map_size_) {
+    if (const auto ec = map_journal(position.end))
+      return ec;
+  }
+
+  const auto header = header_size(position.flags);
+  const std::size_t timestamp_offset =
+      (position.flags & Shared_tail::checksums) != 0 ? 6 : 2;
+  const bool timestamps = (position.flags & Shared_tail::timestamps) != 0;
+  while (record_ <= position.messages && messages_.size() < max_messages) {
+    // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the mapping
+    const std::byte* record = journal_ + offset_;
+    std::uint16_t size = 0;
+    std::memcpy(&size, record, sizeof(size));
+    size = be16toh(size);
+    if (record_ >= next_) {
+      // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the mapping
+      messages_.emplace_back(record + header, size);
+      if (timestamps) {
+        std::uint64_t timestamp = 0;
+        // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the header
+        std::memcpy(&timestamp, record + timestamp_offset, sizeof(timestamp));
+        timestamps_.emplace_back(std::chrono::nanoseconds(
+            static_cast<std::int64_t>(be64toh(timestamp))));
+      }
+    }
+    offset_ += header + size;
+    ++record_;
+  }
+  next_ = std::max(next_, record_);
+  return {};
+}
+
+// Mapping past the end of the file is allowed, and the pages there become
+// readable as the journal grows into them, so the mapping is only replaced
+// when the journal outgrows it.
+std::error_code Tail_reader::map_journal(std::uint64_t end) {
+  auto size = std::max(map_size_, min_map_size);
+  while (size < end)
+    size *= 2;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED)
+    return {errno, std::system_category()};
+  if (journal_) {
+    // NOLINTNEXTLINE(*-const-cast): Mapped here before
+    munmap(const_cast<std::byte*>(journal_), map_size_);
+  }
+  journal_ = static_cast<const std::byte*>(data);
+  map_size_ = size;
+  return {};
+}
+
+} // namespace bc::soup
@@ -1,243 +1,50 @@
 #include "bc/soup/socket.h"
 
-#include <cerrno>
-#include <utility>
+#include <array>
+#include <cstdint>
 
-namespace bc::soup {
-
-Socket::Socket(asio::any_io_executor io_executor) : socket_(io_executor) {}
-
-Socket::Socket(asio::any_io_executor io_executor, Handler& handler)
-    : handler_(&handler), socket_(io_executor) {}
-
-Socket::Socket(asio::ip::tcp::socket&& socket) : socket_(std::move(socket)) {}
-
-Socket::Socket(asio::ip::tcp::socket&& socket, Handler& handler)
-    : handler_(&handler), socket_(std::move(socket)) {}
-
-void Socket::set_handler(Handler& handler) {
-  handler_ = &handler;
-}
-
-void Socket::set_write_packets_limit(std::size_t write_packets_limit) {
-  write_packets_limit_ = write_packets_limit;
-}
-
-asio::error_code Socket::open() {
-  asio::error_code ec;
-  socket_.open(asio::ip::tcp::v4(), ec);
-  return ec;
-}
-
-void Socket::shutdown(asio::error_code* error) {
-  if (socket_.is_open()) {
-    asio::error_code ec;
-    socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
-    if (error)
-      *error = ec;
-  }
-}
-
-void Socket::close(asio::error_code* error) {
-  closing_ = true;
-  if (socket_.is_open()) {
-    asio::error_code ec;
-    socket_.close(ec);
-    if (error)
-      *error = ec;
-  }
-  maybe_signal_closed();
-}
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <sys/socket.h>
+#endif
 
-asio::error_code Socket::set_no_delay() {
-  const asio::ip::tcp::no_delay option(true);
-  asio::error_code ec;
-  socket_.set_option(option, ec);
-  return ec;
-}
+namespace bc::soup {
 
-void Socket::async_connect(const asio::ip::tcp::endpoint& endpoint) {
-  if (closing_)
-    return;
-  connect_pending_ = true;
-  socket_.async_connect(endpoint, [this](asio::error_code ec) {
-    connect_pending_ = false;
-    if (ec) {
-      if (ec != asio::error::operation_aborted)
-        handler_->connect_failure(ec);
-    } else {
-      handler_->connect_success();
+namespace detail {
+
+std::uint32_t read_zero_copy_completions(int fd, std::uint32_t completed) {
+#if defined(__linux__) && defined(SO_EE_ORIGIN_ZEROCOPY)
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Room for one notification
+  std::array<char, 128> control{};
+  while (true) {
+    msghdr message{};
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+    // Sockets without an error queue may read ordinary data instead.
+    if (recvmsg(fd, &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1 ||
+        (message.msg_flags & MSG_ERRQUEUE) == 0)
+      break;
+    for (auto* c = CMSG_FIRSTHDR(&message); c != nullptr;
+         c = CMSG_NXTHDR(&message, c)) {
+      sock_extended_err error{};
+      std::memcpy(&error, CMSG_DATA(c), sizeof(error));
+      if (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY || error.ee_errno != 0)
+        continue;
+      // Sends ee_info to ee_data inclusive have completed. They complete in
+      // order on TCP, so the count is one past the last.
+      const auto count = error.ee_data + 1;
+      if (static_cast<std::int32_t>(count - completed) > 0)
+        completed = count;
     }
-    maybe_signal_closed();
-  });
-}
-
-void Socket::async_read() {
-  if (closing_)
-    return;
-  read_packet_ = Read_packet();
-  read_header();
-}
-
-Write_error Socket::async_write(Write_packet&& packet) {
-  if (closing_)
-    return Write_error::disconnected;
-  const auto size = write_packets_.size();
-  if (size == write_packets_limit_) {
-    write_buffer_was_full_ = true;
-    return Write_error::buffer_full;
   }
-  write_packets_.push_back(std::move(packet));
-  if (size == 0)
-    write_packet();
-  return Write_error::none;
+#else
+  (void)fd;
+#endif
+  return completed;
 }
 
-asio::ip::tcp::endpoint Socket::local_endpoint(asio::error_code* error) const {
-  asio::error_code ec;
-  const auto endpoint = socket_.local_endpoint(ec);
-  if (error)
-    *error = ec;
-  return endpoint;
-}
-
-asio::ip::tcp::endpoint Socket::remote_endpoint(asio::error_code* error) const {
-  asio::error_code ec;
-  const auto endpoint = socket_.remote_endpoint(ec);
-  if (error)
-    *error = ec;
-  return endpoint;
-}
-
-asio::ip::tcp::socket::executor_type Socket::get_executor() {
-  return socket_.get_executor();
-}
-
-void Socket::read_header() {
-  auto& packet = read_packet_;
-  const auto buffer = asio::buffer(packet.header_data(), packet.header_size());
-
-  read_pending_ = true;
-  auto on_completion = [this](asio::error_code ec, std::size_t n) {
-    read_pending_ = false;
-    header_received(ec, n);
-    maybe_signal_closed();
-  };
+} // namespace detail
 
-  asio::async_read(socket_, buffer, std::move(on_completion));
-}
-
-void Socket::header_received(asio::error_code ec, std::size_t n) {
-  if (ec) {
-    if (ec == asio::error::operation_aborted)
-      handler_->read_aborted();
-    else if (ec == asio::error::eof)
-      handler_->read_end_of_file();
-    else
-      handler_->read_failure(ec);
-    return;
-  }
-  if (n != read_packet_.header_size()) { // Needed? Error code should be set.
-    const asio::error_code ec(ECANCELED, asio::system_category());
-    handler_->read_failure(ec);
-    return;
-  }
-  using Result = Read_packet::Resize_result;
-  const auto result = read_packet_.resize_payload();
-  switch (result) {
-  case Result::resized:
-    read_payload();
-    break;
-  case Result::empty_payload: {
-    const Read_packet packet(std::move(read_packet_));
-    handler_->read_success(packet);
-    break;
-  }
-  case Result::malformed_header:
-    handler_->read_failure(Packet_error::malformed_header);
-    break;
-  }
-}
-
-void Socket::read_payload() {
-  auto& packet = read_packet_;
-  const auto buffer =
-      asio::buffer(packet.payload_data(), packet.payload_size());
-
-  read_pending_ = true;
-  auto on_completion = [this](asio::error_code ec, std::size_t n) {
-    read_pending_ = false;
-    payload_received(ec, n);
-    maybe_signal_closed();
-  };
-
-  asio::async_read(socket_, buffer, std::move(on_completion));
-}
-
-void Socket::payload_received(asio::error_code ec, std::size_t n) {
-  if (ec) {
-    if (ec == asio::error::operation_aborted)
-      handler_->read_aborted();
-    else if (ec == asio::error::eof)
-      handler_->read_end_of_file();
-    else
-      handler_->read_failure(ec);
-    return;
-  }
-  if (n != read_packet_.payload_size()) { // Needed? Error code should be set.
-    const asio::error_code ec(ECANCELED, asio::system_category());
-    handler_->read_failure(ec);
-    return;
-  }
-  const Read_packet packet(std::move(read_packet_));
-  handler_->read_success(packet);
-}
-
-void Socket::write_packet() {
-  const auto& packet = write_packets_.front();
-  const auto buffer = asio::buffer(packet.data(), packet.size());
-
-  write_pending_ = true;
-  auto on_completion = [this](asio::error_code ec, std::size_t n) {
-    write_pending_ = false;
-    packet_sent(ec, n);
-    maybe_signal_closed();
-  };
-
-  asio::async_write(socket_, buffer, std::move(on_completion));
-}
-
-void Socket::packet_sent(asio::error_code ec, std::size_t n) {
-  if (ec) {
-    if (ec != asio::error::operation_aborted)
-      handler_->write_failure(ec);
-    return;
-  }
-  const auto& packet = write_packets_.front();
-  if (n != packet.size()) { // Needed? Error code should be set.
-    const asio::error_code ec(ECANCELED, asio::system_category());
-    handler_->write_failure(ec);
-    return;
-  }
-  handler_->write_success(packet);
-  write_packets_.pop_front();
-  if (!write_packets_.empty())
-    write_packet();
-  else if (write_buffer_was_full_) {
-    write_buffer_was_full_ = false;
-    handler_->write_buffer_empty();
-  }
-}
-
-bool Socket::is_idle() const {
-  return !connect_pending_ && !read_pending_ && !write_pending_;
-}
-
-void Socket::maybe_signal_closed() {
-  if (closing_ && !closed_signaled_ && is_idle()) {
-    closed_signaled_ = true;
-    asio::post(socket_.get_executor(), [this] { handler_->closed(); });
-  }
-}
+template class Basic_socket<Socket_handler>;
 
 } // namespace bc::soup
@@ -22,7 +22,13 @@ asio::error_code Socket_acceptor::open() {
 }
 
 asio::error_code
-Socket_acceptor::bind(const asio::ip::tcp::endpoint& endpoint) {
+Socket_acceptor::open(asio::generic::stream_protocol protocol) {
+  asio::error_code ec;
+  acceptor_.open(protocol, ec);
+  return ec;
+}
+
+asio::error_code Socket_acceptor::bind(const Endpoint& endpoint) {
   asio::error_code ec;
   acceptor_.bind(endpoint, ec);
   return ec;
@@ -44,7 +50,7 @@ void Socket_acceptor::close(asio::error_code* error) {
 }
 
 asio::error_code Socket_acceptor::set_reuse_address() {
-  const asio::ip::tcp::acceptor::reuse_address option(true);
+  const asio::socket_base::reuse_address option(true);
   asio::error_code ec;
   acceptor_.set_option(option, ec);
   return ec;
@@ -69,8 +75,7 @@ void Socket_acceptor::async_accept() {
   });
 }
 
-asio::ip::tcp::endpoint
-Socket_acceptor::local_endpoint(asio::error_code* error) const {
+Endpoint Socket_acceptor::local_endpoint(asio::error_code* error) const {
   asio::error_code ec;
   const auto endpoint = acceptor_.local_endpoint(ec);
   if (error)
@@ -78,7 +83,7 @@ Socket_acceptor::local_endpoint(asio::error_code* error) const {
   return endpoint;
 }
 
-asio::ip::tcp::acceptor::executor_type Socket_acceptor::get_executor() {
+asio::any_io_executor Socket_acceptor::get_executor() {
   return acceptor_.get_executor();
 }
 
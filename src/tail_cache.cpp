@@ -0,0 +1,73 @@
+#include "bc/soup/tail_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace bc::soup {
+
+Tail_cache::Tail_cache(std::size_t max_messages, std::size_t max_bytes)
+    : max_messages_(max_messages), max_bytes_(max_bytes) {}
+
+void Tail_cache::set_limits(std::size_t max_messages, std::size_t max_bytes) {
+  max_messages_ = max_messages;
+  max_bytes_ = max_bytes;
+  evict();
+}
+
+void Tail_cache::add(std::uint64_t sequence_number, const void* data,
+                     std::size_t size) {
+  if (sequence_number != first_ + frames_.size()) {
+    clear();
+    first_ = sequence_number;
+  }
+  // Not kept, so neither is anything before it.
+  if (max_messages_ == 0 || size > max_bytes_) {
+    clear();
+    first_ = sequence_number + 1;
+    return;
+  }
+
+  if (block_capacity_ - block_used_ < size) {
+    block_capacity_ = std::max(block_size, size);
+    block_ = std::make_shared_for_overwrite<std::byte[]>(block_capacity_);
+    block_used_ = 0;
+  }
+  // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Within the block
+  std::byte* frame = block_.get() + block_used_;
+  std::memcpy(frame, data, size);
+  block_used_ += size;
+
+  frames_.emplace_back(std::shared_ptr<const std::byte>(block_, frame), size);
+  bytes_ += size;
+  evict();
+}
+
+void Tail_cache::clear() {
+  frames_.clear();
+  bytes_ = 0;
+}
+
+bool Tail_cache::get(std::uint64_t first, std::uint64_t last,
+                     std::vector<Frame>& frames) const {
+  if (frames_.empty() || first < first_ || last < first ||
+      last - first_ >= frames_.size())
+    return false;
+
+  const auto begin =
+      frames_.begin() + static_cast<std::ptrdiff_t>(first - first_);
+  const auto end = begin + static_cast<std::ptrdiff_t>(last - first + 1);
+  frames.insert(frames.end(), begin, end);
+  return true;
+}
+
+void Tail_cache::evict() {
+  while (!frames_.empty() &&
+         (frames_.size() > max_messages_ || bytes_ > max_bytes_)) {
+    bytes_ -= frames_.front().size();
+    frames_.pop_front();
+    ++first_;
+  }
+}
+
+} // namespace bc::soup
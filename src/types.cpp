@@ -54,6 +54,8 @@ const char* to_string(Write_error error) {
     return "not logged in";
   case Write_error::buffer_full:
     return "buffer full";
+  case Write_error::message_too_long:
+    return "message too long";
   }
   return "?";
 }
@@ -42,4 +42,20 @@ std::error_code validate_session(std::string_view session) {
   return {};
 }
 
+std::error_code validate_timeouts(const Timeouts& timeouts) {
+  using std::chrono::milliseconds;
+  if (timeouts.heartbeat_period <= milliseconds::zero() ||
+      timeouts.heartbeat_timeout < timeouts.heartbeat_period ||
+      timeouts.login_timeout <= milliseconds::zero())
+    return Error::invalid_timeouts;
+  return {};
+}
+
+std::error_code validate_reconnect_policy(const Reconnect_policy& policy) {
+  if (policy.initial_delay <= std::chrono::milliseconds::zero() ||
+      policy.max_delay < policy.initial_delay || policy.multiplier < 1)
+    return Error::invalid_reconnect_policy;
+  return {};
+}
+
 } // namespace bc::soup
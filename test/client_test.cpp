@@ -0,0 +1,256 @@
+#include "bc/soup/client/client.h"
+
+#include "loopback.h"
+
+#include "bc/soup/client/handler.h"
+#include "bc/soup/logical_packets.h"
+#include "bc/soup/metrics.h"
+#include "bc/soup/rw_packets.h"
+#include "bc/soup/server/port.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+// Records each batch, and how many had been delivered at the end of the
+// session
+class Batch_handler final : public client::Client_handler,
+                            public client::Sequenced_batch_handler {
+public:
+  void sequenced_data(std::uint64_t, const void*, std::size_t) override {
+    ADD_FAILURE() << "Delivered outside a batch";
+  }
+  void sequenced_data(std::span<const client::Sequenced_data> batch) override {
+    auto& messages = batches.emplace_back();
+    for (const auto& message : batch) {
+      messages.push_back(
+          {message.sequence_number,
+           std::string(static_cast<const char*>(message.data), message.size)});
+    }
+  }
+  void end_of_session() override { batches_at_end = batches.size(); }
+
+  struct Message {
+    std::uint64_t sequence_number = 0;
+    std::string text;
+
+    bool operator==(const Message&) const = default;
+  };
+
+  std::vector<std::vector<Message>> batches;
+  std::optional<std::size_t> batches_at_end;
+};
+
+// A server with a port for one line of the client to log in to, each
+// sending the same sequenced data when told to
+struct Line_server {
+  explicit Line_server(asio::io_context& io_context) : loopback(io_context) {
+    port = loopback.add_port("user", port_handler);
+    loopback.start();
+  }
+
+  asio::ip::tcp::endpoint endpoint() const { return loopback.endpoint(); }
+
+  // The next count messages of the session, each its sequence number
+  void send(std::uint64_t count) {
+    for (std::uint64_t i = 0; i < count; ++i) {
+      const auto sequence_number = port->next_sequence_number();
+      auto error = Write_error::buffer_full;
+      while ((error = port->send_message(&sequence_number,
+                                         sizeof(sequence_number))) ==
+             Write_error::buffer_full)
+        loopback.io_context->run_one();
+      ASSERT_EQ(error, Write_error::none);
+    }
+  }
+
+  Recording_port_handler port_handler;
+  Test_server loopback;
+  server::Port* port = nullptr;
+};
+
+// A client with a line to each of two servers, both logged in
+struct Test_client {
+  Test_client(asio::io_context& io_context, client::Send_policy policy,
+              const Line_server& first, const Line_server& second)
+      : client(io_context.get_executor(), client_handler) {
+    client.set_send_policy(policy);
+    EXPECT_TRUE(add_line(client, first.endpoint(), "user", first_handler));
+    EXPECT_TRUE(add_line(client, second.endpoint(), "user", second_handler));
+    EXPECT_FALSE(client.start());
+    run_until(io_context, [this] {
+      return first_handler.logins == 1 && second_handler.logins == 1;
+    });
+  }
+
+  Write_error send(std::string_view text) {
+    return client.send_message(text.data(), text.size());
+  }
+
+  std::vector<Arbitration_metrics::Snapshot> lines() const {
+    return client.metrics().lines;
+  }
+
+  std::size_t messages() const { return client_handler.messages.size(); }
+
+  Recording_client_handler client_handler;
+  Recording_connection_handler first_handler;
+  Recording_connection_handler second_handler;
+  client::Client client;
+};
+
+// As Client::arbitration_window
+constexpr std::uint64_t window = 1024;
+
+} // namespace
+
+TEST(Client, primary_line) {
+  asio::io_context io_context;
+  Line_server first(io_context);
+  Line_server second(io_context);
+  Test_client test(io_context, client::Send_policy::primary_line, first,
+                   second);
+
+  ASSERT_EQ(test.send("a"), Write_error::none);
+  run_until(io_context, [&] { return !first.port_handler.received.empty(); });
+  ASSERT_EQ(first.port_handler.received, std::vector<std::string>{"a"});
+
+  // Falls back while the primary is down, in whatever state it is in.
+  first.loopback.server.stop();
+  run_until(io_context,
+            [&] { return !test.first_handler.disconnects.empty(); });
+  ASSERT_EQ(test.send("b"), Write_error::none);
+  run_until(io_context, [&] { return !second.port_handler.received.empty(); });
+  ASSERT_EQ(second.port_handler.received, std::vector<std::string>{"b"});
+  ASSERT_EQ(first.port_handler.received, std::vector<std::string>{"a"});
+
+  second.loopback.server.stop();
+  run_until(io_context,
+            [&] { return !test.second_handler.disconnects.empty(); });
+  const auto error = test.send("c");
+  ASSERT_TRUE(error == Write_error::not_logged_in ||
+              error == Write_error::disconnected);
+
+  test.client.stop();
+  io_context.run();
+}
+
+TEST(Client, fastest_line) {
+  asio::io_context io_context;
+  Line_server first(io_context);
+  Line_server second(io_context);
+  Test_client test(io_context, client::Send_policy::fastest_line, first,
+                   second);
+
+  // The primary until a window has passed
+  ASSERT_EQ(test.send("a"), Write_error::none);
+  run_until(io_context, [&] { return !first.port_handler.received.empty(); });
+
+  // The second line delivers a window's worth first, each timed against the
+  // first's duplicate through the arrivals remembered.
+  second.send(window);
+  run_until(io_context,
+            [&] { return test.messages() == window; });
+  first.send(window);
+  run_until(io_context, [&] { return test.lines()[0].duplicates == window; });
+  auto lines = test.lines();
+  ASSERT_EQ(lines.size(), 2U);
+  ASSERT_EQ(lines[0].endpoint, Endpoint(first.endpoint()));
+  ASSERT_EQ(lines[0].wins, 0U);
+  ASSERT_EQ(lines[0].lag.count(), window);
+  ASSERT_EQ(lines[0].lead.count(), 0U);
+  ASSERT_EQ(lines[1].endpoint, Endpoint(second.endpoint()));
+  ASSERT_EQ(lines[1].wins, window);
+  ASSERT_EQ(lines[1].duplicates, 0U);
+  ASSERT_EQ(lines[1].lead.count(), window);
+  ASSERT_EQ(lines[1].lag.count(), 0U);
+  ASSERT_EQ(lines[0].win_rate(), 0.0);
+  ASSERT_EQ(lines[1].win_rate(), 1.0);
+
+  ASSERT_EQ(test.send("b"), Write_error::none);
+  run_until(io_context, [&] { return !second.port_handler.received.empty(); });
+  ASSERT_EQ(second.port_handler.received, std::vector<std::string>{"b"});
+  ASSERT_EQ(first.port_handler.received, std::vector<std::string>{"a"});
+
+  // A window split evenly goes to the line added first.
+  first.send(window / 2);
+  run_until(io_context,
+            [&] { return test.messages() == window * 3 / 2; });
+  second.send(window / 2);
+  run_until(io_context,
+            [&] { return test.lines()[1].duplicates == window / 2; });
+  second.send(window / 2);
+  run_until(io_context,
+            [&] { return test.messages() == window * 2; });
+  first.send(window / 2);
+  run_until(io_context,
+            [&] { return test.lines()[0].duplicates == window * 3 / 2; });
+  lines = test.lines();
+  ASSERT_EQ(lines[0].wins, window / 2);
+  ASSERT_EQ(lines[1].wins, window * 3 / 2);
+
+  ASSERT_EQ(test.send("c"), Write_error::none);
+  run_until(io_context, [&] {
+    return first.port_handler.received.size() +
+               second.port_handler.received.size() ==
+           3;
+  });
+  ASSERT_EQ(first.port_handler.received,
+            (std::vector<std::string>{"a", "c"}));
+  ASSERT_EQ(second.port_handler.received, std::vector<std::string>{"b"});
+
+  test.client.stop();
+  first.loopback.server.stop();
+  second.loopback.server.stop();
+  io_context.run();
+}
+
+// Whatever one read of the socket parses is delivered in one call, the last
+// before the end of the session.
+TEST(Client, batch_handler) {
+  asio::io_context io_context;
+  Raw_server peer(io_context);
+  Batch_handler handler;
+  client::Client client(io_context.get_executor(), handler);
+  client.set_batch_handler(handler);
+  Recording_connection_handler connection_handler;
+  ASSERT_TRUE(add_line(client, peer.endpoint(), "user", connection_handler));
+  ASSERT_FALSE(client.start());
+  peer.accept_login();
+
+  peer.append_login_accepted("S", 1);
+  peer.append_message("one");
+  peer.append_message("two");
+  peer.append_message("three");
+  peer.write();
+  run_until(io_context, [&] { return !handler.batches.empty(); });
+  using Message = Batch_handler::Message;
+  ASSERT_EQ(handler.batches, (std::vector<std::vector<Message>>{
+                                 {{1, "one"}, {2, "two"}, {3, "three"}}}));
+
+  peer.append_message("four");
+  peer.append_message("five");
+  peer.append(Write_packet(End_of_session_packet::packet_type));
+  peer.write();
+  run_until(io_context, [&] { return handler.batches_at_end.has_value(); });
+  ASSERT_EQ(handler.batches_at_end, 2U);
+  ASSERT_EQ(handler.batches[1], (std::vector<Message>{{4, "four"},
+                                                      {5, "five"}}));
+  ASSERT_EQ(client.next_sequence_number(), 6U);
+
+  client.stop();
+  io_context.run();
+}
@@ -0,0 +1,152 @@
+#include "bc/soup/client/connection.h"
+
+#include "loopback.h"
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+using namespace std::chrono_literals;
+
+namespace {
+
+// A loopback port nothing listens on
+unsigned short closed_port(asio::io_context& io_context) {
+  asio::ip::tcp::acceptor acceptor(
+      io_context,
+      asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  return acceptor.local_endpoint().port();
+}
+
+} // namespace
+
+TEST(Connection, alternate_endpoint) {
+  asio::io_context io_context;
+  Recording_port_handler port_handler;
+  Test_server alternate(io_context);
+  alternate.add_port("user", port_handler);
+  alternate.start();
+  Recording_client_handler client_handler;
+  client::Client client(io_context.get_executor(), client_handler);
+  Recording_connection_handler handler;
+  auto* const connection =
+      add_line(client,
+               asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(),
+                                       closed_port(io_context)),
+               "user", handler);
+  ASSERT_TRUE(connection);
+  ASSERT_FALSE(connection->add_alternate_endpoint(alternate.endpoint()));
+  ASSERT_TRUE(connection->add_alternate_endpoint(alternate.endpoint()));
+  ASSERT_TRUE(connection->add_alternate_endpoint(connection->endpoint()));
+  ASSERT_FALSE(client.start());
+  run_until(io_context, [&] { return handler.logins != 0; });
+  ASSERT_EQ(handler.remote_ports,
+            std::vector<unsigned short>{alternate.acceptor_handler.port});
+  ASSERT_EQ(handler.disconnects,
+            std::vector<Disconnect_reason>{Disconnect_reason::connect_failure});
+  ASSERT_TRUE(handler.reconnects.empty());
+  ASSERT_EQ(connection->send_debug("hi"), Write_error::none);
+
+  client.stop();
+  alternate.server.stop();
+  io_context.run();
+}
+
+TEST(Connection, race) {
+  asio::io_context io_context;
+  Recording_port_handler first_port_handler;
+  Recording_port_handler second_port_handler;
+  Test_server first(io_context);
+  first.add_port("user", first_port_handler);
+  first.start();
+  Test_server second(io_context);
+  second.add_port("user", second_port_handler);
+  second.start();
+  Recording_client_handler client_handler;
+  client::Client client(io_context.get_executor(), client_handler);
+  Recording_connection_handler handler;
+  auto* const connection =
+      add_line(client, first.endpoint(), "user", handler);
+  ASSERT_TRUE(connection);
+  ASSERT_FALSE(connection->add_alternate_endpoint(second.endpoint()));
+  ASSERT_FALSE(client.start());
+  run_until(io_context, [&] { return !handler.disconnects.empty(); });
+  // One logged in, and the other was closed as it lost.
+  ASSERT_EQ(handler.logins, 1);
+  ASSERT_EQ(handler.disconnects,
+            std::vector<Disconnect_reason>{Disconnect_reason::superseded});
+  ASSERT_TRUE(handler.reconnects.empty());
+  const char message = 'x';
+  ASSERT_EQ(connection->send_message(&message, 1), Write_error::none);
+
+  // Losing the line races both again, at once.
+  first.server.stop();
+  second.server.stop();
+  run_until(io_context, [&] { return !handler.reconnects.empty(); });
+  ASSERT_EQ(handler.reconnects.front(), 0ms);
+
+  client.stop();
+  io_context.run();
+}
+
+// A racer rejected before the line logs in has no say in whether the line
+// is reconnected once it drops.
+TEST(Connection, race_rejected) {
+  asio::io_context io_context;
+  Raw_server peer(io_context);
+  // No ports, so any login is rejected
+  Test_server rejecting(io_context);
+  rejecting.start();
+  Recording_client_handler client_handler;
+  client::Client client(io_context.get_executor(), client_handler);
+  Recording_connection_handler handler;
+  auto* const connection = add_line(client, peer.endpoint(), "user", handler);
+  ASSERT_TRUE(connection);
+  ASSERT_FALSE(connection->add_alternate_endpoint(rejecting.endpoint()));
+  ASSERT_FALSE(client.start());
+  peer.accept_login();
+  run_until(io_context, [&] { return !handler.disconnects.empty(); });
+  ASSERT_EQ(handler.disconnects,
+            std::vector<Disconnect_reason>{Disconnect_reason::access_denied});
+
+  peer.append_login_accepted("S", 1);
+  peer.write();
+  run_until(io_context, [&] { return handler.logins == 1; });
+  peer.peer.close();
+  run_until(io_context, [&] { return handler.disconnects.size() == 2; });
+  ASSERT_EQ(handler.disconnects[1], Disconnect_reason::peer_closed);
+  ASSERT_EQ(handler.reconnects.size(), 1U);
+
+  client.stop();
+  rejecting.server.stop();
+  io_context.run();
+}
+
+// Only a line that has logged in is retried without delay.
+TEST(Connection, refused) {
+  asio::io_context io_context;
+  Recording_client_handler client_handler;
+  client::Client client(io_context.get_executor(), client_handler);
+  ASSERT_FALSE(client.set_reconnect_policy(
+      {.initial_delay = 100ms, .max_delay = 1s, .full_jitter = false}));
+  Recording_connection_handler handler;
+  ASSERT_TRUE(add_line(client,
+                       asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(),
+                                               closed_port(io_context)),
+                       "user", handler));
+  ASSERT_FALSE(client.start());
+  run_until(io_context, [&] { return !handler.reconnects.empty(); });
+  ASSERT_EQ(handler.disconnects,
+            std::vector<Disconnect_reason>{Disconnect_reason::connect_failure});
+  ASSERT_EQ(handler.reconnects.front(), 100ms);
+
+  client.stop();
+  io_context.run();
+}
@@ -0,0 +1,27 @@
+#include "bc/soup/crc32c.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+TEST(Crc32c, check_value) {
+  const std::string_view digits = "123456789";
+  ASSERT_EQ(crc32c(0, digits.data(), digits.size()), 0xe3069283u);
+  ASSERT_EQ(crc32c(0, nullptr, 0), 0u);
+}
+
+TEST(Crc32c, continued) {
+  // Long enough for whole words and a remainder
+  std::string text;
+  for (char c = 'a'; c <= 'z'; ++c)
+    text += c;
+  const auto whole = crc32c(0, text.data(), text.size());
+  for (std::size_t i = 0; i <= text.size(); ++i) {
+    const auto head = crc32c(0, text.data(), i);
+    ASSERT_EQ(crc32c(head, text.data() + i, text.size() - i), whole);
+  }
+}
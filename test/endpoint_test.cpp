@@ -0,0 +1,23 @@
+#include "bc/soup/endpoint.h"
+
+#include <asio.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+TEST(Endpoint, to_tcp) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  const asio::ip::tcp::endpoint v4(asio::ip::make_address("10.1.2.3"), 5051);
+  ASSERT_TRUE(is_tcp(v4));
+  ASSERT_EQ(to_tcp(v4), v4);
+
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  const asio::ip::tcp::endpoint v6(asio::ip::address_v6::loopback(), 5052);
+  ASSERT_TRUE(is_tcp(v6));
+  ASSERT_EQ(to_tcp(v6), v6);
+
+  const asio::local::stream_protocol::endpoint local("/tmp/bc_soup.sock");
+  ASSERT_FALSE(is_tcp(local));
+  ASSERT_EQ(to_tcp(local), asio::ip::tcp::endpoint());
+}
@@ -19,6 +19,9 @@ TEST(error, error_value) {
   ASSERT_EQ(static_cast<int>(Error::endpoint_in_use), 7);
   ASSERT_EQ(static_cast<int>(Error::username_in_use), 8);
   ASSERT_EQ(static_cast<int>(Error::handler_not_set), 9);
+  ASSERT_EQ(static_cast<int>(Error::journal_mismatch), 10);
+  ASSERT_EQ(static_cast<int>(Error::invalid_timeouts), 11);
+  ASSERT_EQ(static_cast<int>(Error::invalid_reconnect_policy), 12);
 }
 
 TEST(error, soup_category) {
@@ -33,9 +36,12 @@ TEST(error, soup_category) {
   ASSERT_EQ(soup_category().message(7), "endpoint in use"s);
   ASSERT_EQ(soup_category().message(8), "username in use"s);
   ASSERT_EQ(soup_category().message(9), "handler not set"s);
+  ASSERT_EQ(soup_category().message(10), "journal mismatch"s);
+  ASSERT_EQ(soup_category().message(11), "invalid timeouts"s);
+  ASSERT_EQ(soup_category().message(12), "invalid reconnect policy"s);
 
   ASSERT_EQ(soup_category().message(0), "unknown error"s);
-  ASSERT_EQ(soup_category().message(10), "unknown error"s);
+  ASSERT_EQ(soup_category().message(13), "unknown error"s);
 
   {
     constexpr int ev = 1;
@@ -91,6 +97,24 @@ TEST(error, soup_category) {
     ASSERT_EQ(ec.value(), ev);
     ASSERT_EQ(ec.category(), soup_category());
   }
+  {
+    constexpr int ev = 10;
+    std::error_condition ec = soup_category().default_error_condition(ev);
+    ASSERT_EQ(ec.value(), ev);
+    ASSERT_EQ(ec.category(), soup_category());
+  }
+  {
+    constexpr int ev = 11;
+    std::error_condition ec = soup_category().default_error_condition(ev);
+    ASSERT_EQ(ec.value(), static_cast<int>(std::errc::invalid_argument));
+    ASSERT_EQ(ec.category(), std::generic_category());
+  }
+  {
+    constexpr int ev = 12;
+    std::error_condition ec = soup_category().default_error_condition(ev);
+    ASSERT_EQ(ec.value(), static_cast<int>(std::errc::invalid_argument));
+    ASSERT_EQ(ec.category(), std::generic_category());
+  }
 }
 
 TEST(error, make_error_code) {
@@ -139,6 +163,21 @@ TEST(error, make_error_code) {
     ASSERT_EQ(ec.value(), 9);
     ASSERT_EQ(ec.category(), soup_category());
   }
+  {
+    std::error_code ec = make_error_code(Error::journal_mismatch);
+    ASSERT_EQ(ec.value(), 10);
+    ASSERT_EQ(ec.category(), soup_category());
+  }
+  {
+    std::error_code ec = make_error_code(Error::invalid_timeouts);
+    ASSERT_EQ(ec.value(), 11);
+    ASSERT_EQ(ec.category(), soup_category());
+  }
+  {
+    std::error_code ec = make_error_code(Error::invalid_reconnect_policy);
+    ASSERT_EQ(ec.value(), 12);
+    ASSERT_EQ(ec.category(), soup_category());
+  }
 }
 
 TEST(error, is_error_code_enum) {
@@ -188,6 +227,21 @@ TEST(error, is_error_code_enum) {
     ASSERT_EQ(ec.value(), 9);
     ASSERT_EQ(ec.category(), soup_category());
   }
+  {
+    std::error_code ec = Error::journal_mismatch;
+    ASSERT_EQ(ec.value(), 10);
+    ASSERT_EQ(ec.category(), soup_category());
+  }
+  {
+    std::error_code ec = Error::invalid_timeouts;
+    ASSERT_EQ(ec.value(), 11);
+    ASSERT_EQ(ec.category(), soup_category());
+  }
+  {
+    std::error_code ec = Error::invalid_reconnect_policy;
+    ASSERT_EQ(ec.value(), 12);
+    ASSERT_EQ(ec.category(), soup_category());
+  }
 }
 
 TEST(error, is_error_condition_enum) {
@@ -247,4 +301,16 @@ TEST(error, comparison) {
     std::error_code ec(ev, soup_category());
     ASSERT_TRUE(ec == Error::handler_not_set);
   }
+  {
+    constexpr int ev = 11;
+    std::error_code ec(ev, soup_category());
+    ASSERT_TRUE(ec == Error::invalid_timeouts);
+    ASSERT_TRUE(ec == std::errc::invalid_argument);
+  }
+  {
+    constexpr int ev = 12;
+    std::error_code ec(ev, soup_category());
+    ASSERT_TRUE(ec == Error::invalid_reconnect_policy);
+    ASSERT_TRUE(ec == std::errc::invalid_argument);
+  }
 }
@@ -1,9 +1,14 @@
 #include "bc/soup/file_store.h"
 
 #include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <initializer_list>
+#include <ios>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -572,3 +577,419 @@ TEST(File_store, move_operations) {
   ec = s4.close();
   ASSERT_FALSE(ec);
 }
+
+TEST(File_store, get_frames) {
+  unlink(filename.c_str());
+  const std::vector<std::string_view> words{"The",  "quick", "brown",
+                                            "fox",  "jumps", "over",
+                                            "the",  "lazy",  "dog"};
+  // Of frames or of messages
+  auto assert_frames = [&words](const auto& frames, std::size_t first) {
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+      const std::string_view word(static_cast<const char*>(frames[i].data()),
+                                  frames[i].size());
+      ASSERT_EQ(word, words[first - 1 + i]);
+    }
+  };
+
+  File_store s(filename);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test limits
+  s.set_cache_limits(3, 1024);
+  auto ec = s.open();
+  ASSERT_FALSE(ec);
+  for (const auto word : words) {
+    ec = add(s, word);
+    ASSERT_FALSE(ec);
+  }
+
+  std::vector<Frame> frames;
+  ec = s.get(0, 1, frames);
+  ASSERT_EQ(ec, std::errc::invalid_argument);
+  ec = s.get(1, 10, frames);
+  ASSERT_EQ(ec, std::errc::invalid_argument);
+  ASSERT_TRUE(frames.empty());
+
+  // From the file, the cache, and both
+  for (const auto& [first, last] : {std::pair{1, 6}, std::pair{7, 9},
+                                    std::pair{8, 8}, std::pair{2, 9}}) {
+    frames.clear();
+    ec = s.get(first, last, frames);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(frames.size(), static_cast<std::size_t>(last - first + 1));
+    assert_frames(frames, first);
+
+    std::vector<Message> messages;
+    ec = s.get(first, last, messages);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(messages.size(), frames.size());
+    assert_frames(messages, first);
+  }
+
+  // Reopening starts with an empty cache.
+  ec = s.close();
+  ASSERT_FALSE(ec);
+  ec = s.open();
+  ASSERT_FALSE(ec);
+  frames.clear();
+  ec = s.get(1, 9, frames);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(frames.size(), words.size());
+  assert_frames(frames, 1);
+  ec = s.close();
+  ASSERT_FALSE(ec);
+}
+
+TEST(File_store, cursor) {
+  unlink(filename.c_str());
+  File_store s(filename);
+  auto ec = s.open();
+  ASSERT_FALSE(ec);
+  for (const auto word : {"The", "quick", "brown", "fox", "jumps", "over",
+                          "the", "lazy", "dog"}) {
+    ec = add(s, word);
+    ASSERT_FALSE(ec);
+  }
+  auto words = [](const File_store::Cursor& cursor) {
+    std::vector<std::string_view> words;
+    for (const auto message : cursor.messages()) {
+      const void* data = message.data();
+      words.emplace_back(static_cast<const char*>(data), message.size());
+    }
+    return words;
+  };
+  using Words = std::vector<std::string_view>;
+
+  auto invalid = s.cursor(0);
+  ec = invalid.read(1, 1);
+  ASSERT_EQ(ec, std::errc::invalid_argument);
+
+  // NOLINTBEGIN(*-avoid-magic-numbers): Test limits
+  auto cursor = s.cursor(1);
+  ec = cursor.read(2, 1024);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(words(cursor), (Words{"The", "quick"}));
+
+  // Each record has a two-byte size.
+  ec = cursor.read(100, 14);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(words(cursor), (Words{"brown", "fox"}));
+
+  // The first message is read whatever its size.
+  ec = cursor.read(100, 1);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(words(cursor), (Words{"jumps"}));
+
+  ec = cursor.read(0, 1024);
+  ASSERT_FALSE(ec);
+  ASSERT_TRUE(cursor.messages().empty());
+  ASSERT_EQ(cursor.next_sequence_number(), 6u);
+
+  ec = cursor.read(100, 1024);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(words(cursor), (Words{"over", "the", "lazy", "dog"}));
+  ec = cursor.read(100, 1024);
+  ASSERT_FALSE(ec);
+  ASSERT_TRUE(cursor.messages().empty());
+
+  // Messages added later are read in their turn.
+  ec = add(s, "again");
+  ASSERT_FALSE(ec);
+  ec = cursor.read(100, 1024);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(words(cursor), (Words{"again"}));
+  ASSERT_EQ(cursor.next_sequence_number(), 11u);
+
+  cursor.seek(2);
+  ec = cursor.read(1, 1024);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(words(cursor), (Words{"quick"}));
+  // NOLINTEND(*-avoid-magic-numbers)
+
+  ec = s.close();
+  ASSERT_FALSE(ec);
+}
+
+namespace {
+
+// Overwrites the byte at the offset given, e.g. in a record's payload.
+void corrupt(std::uintmax_t offset) {
+  std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(static_cast<std::streamoff>(offset));
+  file.put('#');
+}
+
+} // namespace
+
+TEST(File_store, torn_record) {
+  unlink(filename.c_str());
+  {
+    File_store s(filename);
+    ASSERT_FALSE(s.open());
+    for (const auto word : {"The", "quick", "brown"})
+      ASSERT_FALSE(add(s, word));
+  }
+  const auto size = std::filesystem::file_size(filename);
+  // A size promising more than follows, then half a size
+  for (const std::string_view torn : {std::string_view("\0\x09fox", 5),
+                                      std::string_view("\0", 1)}) {
+    std::ofstream(filename, std::ios::app | std::ios::binary) << torn;
+
+    File_store s(filename);
+    ASSERT_FALSE(s.open());
+    ASSERT_EQ(s.next_sequence_number(), 4u);
+    ASSERT_EQ(std::filesystem::file_size(filename), size);
+  }
+
+  File_store s(filename);
+  ASSERT_FALSE(s.open());
+  ASSERT_FALSE(add(s, "fox"));
+  std::vector<Message> v;
+  ASSERT_FALSE(s.get(4, 4, v));
+  ASSERT_EQ(std::string_view(static_cast<const char*>(v[0].data()),
+                             v[0].size()),
+            "fox");
+  ASSERT_FALSE(s.close());
+}
+
+TEST(File_store, checksums) {
+  unlink(filename.c_str());
+  {
+    File_store s(filename);
+    s.set_checksums(true);
+    ASSERT_FALSE(s.open());
+    for (const auto word : {"The", "quick", "brown", "fox", "jumps"})
+      ASSERT_FALSE(add(s, word));
+    std::vector<Message> v;
+    ASSERT_FALSE(s.get(1, 5, v));
+    ASSERT_EQ(v.size(), 5u);
+  }
+  // Each record is a two-byte size, a four-byte CRC and the payload.
+  constexpr std::uintmax_t fox = 9 + 11 + 11;
+  ASSERT_EQ(std::filesystem::file_size(filename), fox + 9 + 11);
+
+  // Outside the part checked, so kept
+  corrupt(fox + 6);
+  {
+    File_store s(filename);
+    s.set_checksums(true);
+    // NOLINTNEXTLINE(*-avoid-magic-numbers): The last record
+    s.set_verify_limit(11);
+    ASSERT_FALSE(s.open());
+    ASSERT_EQ(s.next_sequence_number(), 6u);
+  }
+
+  File_store s(filename);
+  s.set_checksums(true);
+  ASSERT_FALSE(s.open());
+  ASSERT_EQ(s.next_sequence_number(), 4u);
+  ASSERT_EQ(std::filesystem::file_size(filename), fox);
+  ASSERT_FALSE(add(s, "fox"));
+  ASSERT_FALSE(s.close());
+  ASSERT_FALSE(s.open());
+  ASSERT_EQ(s.next_sequence_number(), 5u);
+  ASSERT_FALSE(s.close());
+}
+
+TEST(File_store, checksums_in_parallel) {
+  // Enough for several threads to check a part each
+  constexpr std::size_t count = 200'000;
+  constexpr std::size_t message_size = 100;
+  constexpr std::size_t record_size = message_size + 6;
+  unlink(filename.c_str());
+  {
+    File_store s(filename);
+    s.set_checksums(true);
+    ASSERT_FALSE(s.open());
+    const std::string message(message_size, 'x');
+    for (std::size_t i = 0; i < count; ++i)
+      ASSERT_FALSE(add(s, message));
+  }
+
+  // The first bad record counts, whichever part it is in.
+  for (const std::size_t bad : {count - 1000, count / 3}) {
+    corrupt(bad * record_size + record_size - 1);
+    File_store s(filename);
+    s.set_checksums(true);
+    ASSERT_FALSE(s.open());
+    ASSERT_EQ(s.next_sequence_number(), bad + 1);
+    ASSERT_EQ(std::filesystem::file_size(filename), bad * record_size);
+  }
+  unlink(filename.c_str());
+}
+
+TEST(File_store, direct_io) {
+  // Enough for the buffer to be written several times over
+  constexpr std::size_t count = 3000;
+  auto message = [](std::size_t i) {
+    // NOLINTNEXTLINE(*-avoid-magic-numbers): Test sizes
+    return std::string(i % 200 + 1, static_cast<char>('a' + i % 26));
+  };
+  auto check = [&message](File_store& s, std::size_t first,
+                          std::size_t last) {
+    std::vector<Message> v;
+    ASSERT_FALSE(s.get(first, last, v));
+    ASSERT_EQ(v.size(), last - first + 1);
+    for (std::size_t i = first; i <= last; ++i) {
+      const auto& m = v[i - first];
+      ASSERT_EQ(std::string_view(static_cast<const char*>(m.data()),
+                                 m.size()),
+                message(i));
+    }
+  };
+
+  unlink(filename.c_str());
+  {
+    File_store s(filename);
+    s.set_checksums(true);
+    s.set_direct_io(true);
+    const auto ec = s.open();
+    // No O_DIRECT, e.g. on tmpfs
+    if (ec == std::errc::invalid_argument)
+      GTEST_SKIP() << "Direct I/O not supported";
+    ASSERT_FALSE(ec) << ec.message();
+    for (std::size_t i = 1; i <= count; ++i) {
+      ASSERT_FALSE(add(s, message(i)));
+      // Read back from the buffer, and across it and the file
+      if (i % 100 == 0)
+        check(s, i - 99, i);
+    }
+    check(s, 1, count);
+    // The partial block is written, but not its padding.
+    ASSERT_FALSE(s.sync());
+    const auto size = std::filesystem::file_size(filename);
+    ASSERT_NE(size % 4096, 0u);
+    ASSERT_FALSE(add(s, message(count + 1)));
+    check(s, count - 10, count + 1);
+  }
+
+  // Reopened with and without direct I/O, from a partial block
+  for (const bool direct_io : {true, false}) {
+    File_store s(filename);
+    s.set_checksums(true);
+    s.set_direct_io(direct_io);
+    ASSERT_FALSE(s.open());
+    ASSERT_EQ(s.next_sequence_number(), count + 2);
+    check(s, 1, count + 1);
+  }
+  {
+    File_store s(filename);
+    s.set_checksums(true);
+    s.set_direct_io(true);
+    ASSERT_FALSE(s.open());
+    ASSERT_FALSE(add(s, message(count + 2)));
+    check(s, count, count + 2);
+    ASSERT_FALSE(s.close());
+    ASSERT_FALSE(s.open());
+    check(s, 1, count + 2);
+  }
+  unlink(filename.c_str());
+}
+
+// As if a crash came between writing the padded last block and cutting the
+// padding from the file
+TEST(File_store, direct_io_padding) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test sizes
+  const std::vector<std::string> messages{"one", "", "three", "", "five"};
+  unlink(filename.c_str());
+  {
+    File_store s(filename);
+    s.set_direct_io(true);
+    const auto ec = s.open();
+    // No O_DIRECT, e.g. on tmpfs
+    if (ec == std::errc::invalid_argument)
+      GTEST_SKIP() << "Direct I/O not supported";
+    ASSERT_FALSE(ec) << ec.message();
+    for (const auto& m : messages)
+      ASSERT_FALSE(add(s, m));
+    ASSERT_FALSE(s.close());
+  }
+  const auto size = std::filesystem::file_size(filename);
+  ASSERT_NE(size % 4096, 0u);
+  {
+    // The padding as written by the store, which is all ones
+    std::ofstream file(filename, std::ios::binary | std::ios::app);
+    const std::string padding(4096 - size % 4096, '\xff');
+    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+  }
+
+  for (const bool direct_io : {true, false}) {
+    File_store s(filename);
+    s.set_direct_io(direct_io);
+    ASSERT_FALSE(s.open());
+    ASSERT_EQ(s.next_sequence_number(), messages.size() + 1);
+    ASSERT_EQ(std::filesystem::file_size(filename), size);
+    std::vector<Message> v;
+    ASSERT_FALSE(s.get(1, messages.size(), v));
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+      ASSERT_EQ(std::string_view(static_cast<const char*>(v[i].data()),
+                                 v[i].size()),
+                messages[i]);
+    }
+  }
+  unlink(filename.c_str());
+}
+
+TEST(File_store, timestamps) {
+  // Enough for the index to have many blocks
+  constexpr std::size_t count = 2000;
+  constexpr std::size_t message_size = 100;
+  const std::chrono::system_clock::time_point start(std::chrono::hours(1));
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test spacing
+  constexpr std::chrono::microseconds step(10);
+  const auto time = [&start, step](std::size_t i) {
+    return start + static_cast<long>(i) * step;
+  };
+  const auto check = [&time, step](File_store& s) {
+    ASSERT_EQ(s.sequence_number_at(time(0)), 1u);
+    for (std::size_t i = 1; i <= count; ++i) {
+      ASSERT_EQ(s.sequence_number_at(time(i)), i);
+      ASSERT_EQ(s.sequence_number_at(time(i) - step / 2), i);
+    }
+    ASSERT_EQ(s.sequence_number_at(time(count) + step / 2), count + 1);
+  };
+
+  for (const bool checksums : {false, true}) {
+    unlink(filename.c_str());
+    {
+      File_store s(filename);
+      s.set_checksums(checksums);
+      s.set_timestamps(true);
+      ASSERT_FALSE(s.open());
+      ASSERT_EQ(s.sequence_number_at(time(0)), 1u);
+      const std::string message(message_size, 'x');
+      for (std::size_t i = 1; i <= count; ++i)
+        ASSERT_FALSE(s.add(message.data(), message.size(), time(i)));
+      check(s);
+    }
+    const auto record_size = message_size + (checksums ? 14 : 10);
+    ASSERT_EQ(std::filesystem::file_size(filename), count * record_size);
+
+    // The index is rebuilt from the file.
+    File_store s(filename);
+    s.set_checksums(checksums);
+    s.set_timestamps(true);
+    ASSERT_FALSE(s.open());
+    check(s);
+    std::vector<Message> v;
+    ASSERT_FALSE(s.get(count, count, v));
+    ASSERT_EQ(v[0].size(), message_size);
+
+    // An earlier time is clamped, and no time means now.
+    ASSERT_FALSE(s.add("a", 1, time(1)));
+    ASSERT_EQ(s.sequence_number_at(time(count)), count);
+    ASSERT_EQ(s.sequence_number_at(time(count) + step / 2), count + 2);
+    ASSERT_FALSE(add(s, "b"));
+    ASSERT_EQ(s.sequence_number_at(time(count) + step / 2), count + 2);
+    ASSERT_EQ(s.sequence_number_at(std::chrono::system_clock::now() -
+                                   std::chrono::hours(1)),
+              count + 2);
+    ASSERT_FALSE(s.close());
+  }
+
+  File_store s(filename);
+  ASSERT_FALSE(s.open());
+  ASSERT_EQ(s.sequence_number_at(time(0)).error(),
+            std::error_code(EINVAL, std::system_category()));
+  ASSERT_FALSE(s.close());
+  unlink(filename.c_str());
+}
@@ -0,0 +1,60 @@
+#include "bc/soup/handler_memory.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+TEST(Handler_memory, allocate) {
+  Handler_memory memory;
+  void* block = memory.allocate(1);
+  // In use, so the next request goes to the heap
+  void* other = memory.allocate(1);
+  ASSERT_NE(other, block);
+  memory.deallocate(other);
+  memory.deallocate(block);
+
+  ASSERT_EQ(memory.allocate(1), block);
+  memory.deallocate(block);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Larger than the block
+  void* large = memory.allocate(4096);
+  ASSERT_NE(large, block);
+  memory.deallocate(large);
+}
+
+TEST(Handler_memory, Handler_allocator) {
+  Handler_memory memory;
+  const Handler_allocator<std::uint64_t> a(memory);
+  const Handler_allocator<char> b(a);
+  ASSERT_TRUE(a == b);
+  auto* p = a.allocate(2);
+  p[0] = 1;
+  p[1] = 2;
+  a.deallocate(p, 2);
+  ASSERT_EQ(static_cast<void*>(b.allocate(1)), static_cast<void*>(p));
+}
+
+TEST(Handler_memory, bind_memory) {
+  asio::io_context io_context;
+  Handler_memory memory;
+  void* block = memory.allocate(1);
+  memory.deallocate(block);
+
+  asio::steady_timer timer(io_context);
+  timer.expires_after(std::chrono::milliseconds(1));
+  bool called = false;
+  timer.async_wait(
+      bind_memory(memory, [&called](asio::error_code) { called = true; }));
+  // The wait holds the block
+  void* other = memory.allocate(1);
+  ASSERT_NE(other, block);
+  memory.deallocate(other);
+
+  io_context.run();
+  ASSERT_TRUE(called);
+  ASSERT_EQ(memory.allocate(1), block);
+}
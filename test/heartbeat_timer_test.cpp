@@ -0,0 +1,69 @@
+#include "bc/soup/heartbeat_timer.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+using namespace std::chrono_literals;
+
+namespace {
+
+class Handler final : public Heartbeat_timer::Handler {
+public:
+  void heartbeat_timer_error(asio::error_code, std::string_view) override {
+    ++errors;
+  }
+  void heartbeat_send_due() override { ++sends_due; }
+  void heartbeat_receive_timeout() override {
+    timed_out = std::chrono::steady_clock::now();
+  }
+  void heartbeat_timer_stopped() override { stopped = true; }
+
+  int errors = 0;
+  int sends_due = 0;
+  std::chrono::steady_clock::time_point timed_out;
+  bool stopped = false;
+};
+
+} // namespace
+
+TEST(Heartbeat_timer, receive_timeout) {
+  asio::io_context io_context;
+  Handler handler;
+  Heartbeat_timer timer(io_context.get_executor(), handler, 10ms, 30ms);
+  const auto start = std::chrono::steady_clock::now();
+  timer.start();
+  io_context.run();
+  ASSERT_EQ(handler.errors, 0);
+  ASSERT_GE(handler.sends_due, 2);
+  ASSERT_GE(handler.timed_out - start, 30ms);
+  // Within a fraction of a second, allowing for a loaded machine
+  ASSERT_LT(handler.timed_out - start, 100ms);
+  timer.stop();
+  io_context.restart();
+  io_context.run();
+  ASSERT_TRUE(handler.stopped);
+}
+
+TEST(Heartbeat_timer, receive_resets_timeout) {
+  asio::io_context io_context;
+  Handler handler;
+  Heartbeat_timer timer(io_context.get_executor(), handler, 10ms, 30ms);
+  timer.start();
+  // Receiving every period keeps the line up.
+  const auto until = std::chrono::steady_clock::now() + 100ms;
+  while (std::chrono::steady_clock::now() < until) {
+    timer.increment_receive_count();
+    timer.increment_send_count();
+    io_context.run_for(5ms);
+  }
+  ASSERT_EQ(handler.timed_out, std::chrono::steady_clock::time_point());
+  ASSERT_EQ(handler.sends_due, 0);
+  timer.stop();
+  io_context.run();
+  ASSERT_TRUE(handler.stopped);
+}
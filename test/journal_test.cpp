@@ -0,0 +1,163 @@
+#include "bc/soup/client/journal.h"
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/client/handler.h"
+#include "bc/soup/error.h"
+#include "bc/soup/file_store.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+const std::string filename = "test_journal";
+const std::string session_filename = filename + ".session";
+
+// Written as a Client would have left them
+void write_journal(std::string_view session,
+                   const std::vector<std::string>& messages) {
+  File_store store(filename);
+  ASSERT_FALSE(store.open());
+  for (const auto& message : messages)
+    ASSERT_FALSE(store.add(message.data(), message.size()));
+  ASSERT_FALSE(store.close());
+  std::ofstream(session_filename) << session;
+}
+
+void remove_journal() {
+  ::unlink(filename.c_str());
+  ::unlink(session_filename.c_str());
+}
+
+class Recording_handler final : public client::Client_handler {
+public:
+  void sequenced_data(std::uint64_t sequence_number, const void* data,
+                      std::size_t size) override {
+    sequence_numbers.push_back(sequence_number);
+    messages.emplace_back(static_cast<const char*>(data), size);
+  }
+  void end_of_session() override {}
+
+  std::vector<std::uint64_t> sequence_numbers;
+  std::vector<std::string> messages;
+};
+
+class Null_connection_handler final : public client::Connection_handler {
+public:
+  void connecting(const asio::ip::tcp::endpoint&) override {}
+  void connect_failure(asio::error_code, std::string_view) override {}
+  void connect_success(const asio::ip::tcp::endpoint&,
+                       const asio::ip::tcp::endpoint&) override {}
+
+  void logging_in(const Login_request_packet&) override {}
+  void login_failure(Login_reject_reason) override {}
+  void login_success(const Login_accepted_packet&) override {}
+
+  void write_buffer_empty() override {}
+
+  void debug(std::string_view) override {}
+
+  void transport_error(asio::error_code, std::string_view) override {}
+  void protocol_violation(Packet_error) override {}
+
+  void disconnect(Disconnect_reason) override {}
+  void reconnect_scheduled(std::chrono::milliseconds) override {}
+};
+
+// NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+const asio::ip::tcp::endpoint endpoint(asio::ip::address_v4::loopback(), 1);
+
+} // namespace
+
+TEST(Journal, open) {
+  remove_journal();
+  {
+    client::Journal journal(filename);
+    ASSERT_FALSE(journal.open());
+    ASSERT_EQ(journal.session(), "");
+    ASSERT_EQ(journal.next_sequence_number(), 1u);
+    ASSERT_FALSE(journal.close());
+  }
+
+  write_journal("ABC", {"The", "quick", "brown"});
+  client::Journal journal;
+  journal.set_filename(filename);
+  ASSERT_FALSE(journal.open());
+  ASSERT_EQ(journal.session(), "ABC");
+  ASSERT_EQ(journal.next_sequence_number(), 4u);
+  ASSERT_FALSE(journal.sync());
+  ASSERT_FALSE(journal.close());
+  remove_journal();
+}
+
+TEST(Journal, replay) {
+  remove_journal();
+  write_journal("ABC", {"The", "quick", "brown"});
+  client::Journal journal(filename);
+  ASSERT_FALSE(journal.open());
+
+  asio::io_context io_context;
+  Recording_handler handler;
+  Null_connection_handler connection_handler;
+  client::Client client(io_context.get_executor(), handler);
+  const auto connection = client.add_connection(endpoint, connection_handler);
+  ASSERT_TRUE(connection);
+  client.set_next_sequence_number(2);
+  client.set_journal(journal);
+
+  // Replayed before start() returns, from the client's next sequence number
+  ASSERT_FALSE(client.start());
+  ASSERT_EQ(handler.sequence_numbers, (std::vector<std::uint64_t>{2, 3}));
+  ASSERT_EQ(handler.messages, (std::vector<std::string>{"quick", "brown"}));
+  ASSERT_EQ(client.next_sequence_number(), 4u);
+  ASSERT_EQ((*connection)->session(), "ABC");
+
+  client.stop();
+  io_context.run();
+  ASSERT_FALSE(journal.close());
+  remove_journal();
+}
+
+TEST(Journal, replay_mismatch) {
+  remove_journal();
+  write_journal("ABC", {"The"});
+  client::Journal journal(filename);
+  ASSERT_FALSE(journal.open());
+
+  asio::io_context io_context;
+  Recording_handler handler;
+  Null_connection_handler connection_handler;
+  {
+    client::Client client(io_context.get_executor(), handler);
+    const auto connection =
+        client.add_connection(endpoint, connection_handler);
+    ASSERT_TRUE(connection);
+    ASSERT_FALSE((*connection)->set_session("XYZ"));
+    client.set_journal(journal);
+    ASSERT_EQ(client.start(), Error::journal_mismatch);
+  }
+  {
+    // Would leave a gap in the journal
+    client::Client client(io_context.get_executor(), handler);
+    client.set_next_sequence_number(3);
+    client.set_journal(journal);
+    ASSERT_EQ(client.start(), Error::journal_mismatch);
+  }
+  ASSERT_TRUE(handler.messages.empty());
+  ASSERT_FALSE(journal.close());
+  remove_journal();
+}
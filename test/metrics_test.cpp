@@ -0,0 +1,189 @@
+#include "bc/soup/metrics.h"
+
+#include "bc/soup/endpoint.h"
+#include "bc/soup/logical_packets.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+const asio::ip::tcp::endpoint endpoint(asio::ip::address_v4::loopback(), 5051);
+
+} // namespace
+
+TEST(metrics, Latency_histogram_bucket) {
+  using H = Latency_histogram;
+  for (std::uint64_t ns = 0; ns < H::sub_bucket_count; ++ns) {
+    ASSERT_EQ(H::bucket_index(ns), ns);
+    ASSERT_EQ(H::bucket_value(H::bucket_index(ns)), ns);
+  }
+  // Every value lies within its bucket and within 1 / sub_bucket_count of the
+  // bucket value.
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test values
+  for (std::uint64_t ns : {8u, 9u, 15u, 16u, 17u, 1000u, 123456u, 999999999u}) {
+    const auto i = H::bucket_index(ns);
+    ASSERT_LT(i, H::bucket_count);
+    const auto value = H::bucket_value(i);
+    ASSERT_GE(value, ns);
+    ASSERT_LE(value - ns, ns / H::sub_bucket_count);
+    if (i > 0) {
+      ASSERT_LT(H::bucket_value(i - 1), ns);
+    }
+  }
+  ASSERT_EQ(H::bucket_index(~std::uint64_t{0}), H::bucket_count - 1);
+}
+
+TEST(metrics, Latency_histogram_percentile) {
+  Latency_histogram h;
+  ASSERT_EQ(h.count(), 0u);
+  ASSERT_EQ(h.percentile(0.5), 0ns);
+
+  // NOLINTBEGIN(*-avoid-magic-numbers): Test values
+  for (int i = 1; i <= 100; ++i)
+    h.record(std::chrono::nanoseconds(i));
+  ASSERT_EQ(h.count(), 100u);
+  ASSERT_EQ(h.percentile(0.0), 1ns);
+  ASSERT_EQ(h.percentile(0.05), 5ns);
+  ASSERT_GE(h.percentile(0.5), 50ns);
+  ASSERT_LE(h.percentile(0.5), 53ns);
+  ASSERT_GE(h.percentile(1.0), 100ns);
+  ASSERT_LE(h.percentile(1.0), 103ns);
+
+  Latency_histogram other;
+  other.record(1ms);
+  h.merge(other);
+  ASSERT_EQ(h.count(), 101u);
+  ASSERT_GE(h.percentile(1.0), 1ms);
+  // NOLINTEND(*-avoid-magic-numbers)
+}
+
+TEST(metrics, packet_type_index) {
+  ASSERT_EQ(packet_type_index(Debug_packet::packet_type), 0u);
+  ASSERT_EQ(packet_type_index(Logout_request_packet::packet_type),
+            packet_type_count - 2);
+  ASSERT_EQ(packet_type_index('?'), packet_type_count - 1);
+}
+
+TEST(metrics, Connection_metrics) {
+  Metrics_registry registry;
+  Connection_metrics m(registry, endpoint);
+
+  // NOLINTBEGIN(*-avoid-magic-numbers): Test values
+  const auto t = std::chrono::steady_clock::now();
+  m.on_read(Sequenced_data_packet::packet_type, 10, t);
+  m.on_read(Sequenced_data_packet::packet_type, 20, t + 5ms);
+  m.on_read(Server_heartbeat_packet::packet_type, 3, t + 7ms);
+  m.on_write_queued(1);
+  m.on_write_queued(2);
+  m.on_write_complete(Unsequenced_data_packet::packet_type, 13, 2us, 1);
+
+  const auto s = m.snapshot();
+  ASSERT_EQ(s.remote_endpoint, endpoint);
+  ASSERT_EQ(s.received().packets, 3u);
+  ASSERT_EQ(s.received().bytes, 33u);
+  ASSERT_EQ(s.received(Sequenced_data_packet::packet_type).packets, 2u);
+  ASSERT_EQ(s.received(Sequenced_data_packet::packet_type).bytes, 30u);
+  ASSERT_EQ(s.received(Server_heartbeat_packet::packet_type).packets, 1u);
+  ASSERT_EQ(s.sent().packets, 1u);
+  ASSERT_EQ(s.sent(Unsequenced_data_packet::packet_type).bytes, 13u);
+  ASSERT_EQ(s.write_queue_depth, 1u);
+  ASSERT_EQ(s.write_queue_high_water_mark, 2u);
+  ASSERT_EQ(s.max_receive_gap, 5ms);
+  ASSERT_EQ(s.write_latency.count(), 1u);
+  ASSERT_GE(s.write_latency.percentile(0.5), 2us);
+  // NOLINTEND(*-avoid-magic-numbers)
+}
+
+TEST(metrics, Metrics_registry) {
+  Metrics_registry registry;
+  {
+    const auto s = registry.snapshot();
+    ASSERT_TRUE(s.connections.empty());
+    ASSERT_EQ(s.closed_connections, 0u);
+  }
+
+  std::optional<Connection_metrics> m1(std::in_place, registry, endpoint);
+  Connection_metrics m2(registry, endpoint);
+  // NOLINTBEGIN(*-avoid-magic-numbers): Test values
+  m1->on_write_queued(4);
+  m1->on_write_complete(Sequenced_data_packet::packet_type, 10, 1us, 3);
+  m2.on_write_queued(1);
+  {
+    const auto s = registry.snapshot();
+    ASSERT_EQ(s.connections.size(), 2u);
+    ASSERT_EQ(s.closed_connections, 0u);
+    ASSERT_EQ(s.total.sent().packets, 1u);
+    ASSERT_EQ(s.total.write_queue_depth, 4u);
+    ASSERT_EQ(s.total.write_queue_high_water_mark, 4u);
+  }
+
+  // Totals of a closed connection are kept; its queue depth is not.
+  m1.reset();
+  {
+    const auto s = registry.snapshot();
+    ASSERT_EQ(s.connections.size(), 1u);
+    ASSERT_EQ(s.closed_connections, 1u);
+    ASSERT_EQ(s.total.sent().packets, 1u);
+    ASSERT_EQ(s.total.sent().bytes, 10u);
+    ASSERT_EQ(s.total.write_queue_depth, 1u);
+    ASSERT_EQ(s.total.write_queue_high_water_mark, 4u);
+    ASSERT_EQ(s.total.write_latency.count(), 1u);
+  }
+  // NOLINTEND(*-avoid-magic-numbers)
+}
+
+TEST(metrics, Arbitration_metrics) {
+  Metrics_registry registry;
+  std::optional<Arbitration_metrics> m1(std::in_place, registry, endpoint);
+  Arbitration_metrics m2(registry, Endpoint(endpoint));
+
+  // NOLINTBEGIN(*-avoid-magic-numbers): Test values
+  m1->on_win();
+  m1->on_win();
+  m1->on_win();
+  m2.on_win();
+  m2.on_duplicate(40us);
+  m1->on_lead(40us);
+  m2.on_duplicate(std::nullopt);
+  m1->on_duplicate(10us);
+  m2.on_lead(10us);
+  {
+    const auto s = registry.snapshot();
+    ASSERT_EQ(s.lines.size(), 2u);
+    const auto& l1 = s.lines[0];
+    ASSERT_EQ(l1.endpoint, Endpoint(endpoint));
+    ASSERT_EQ(l1.wins, 3u);
+    ASSERT_EQ(l1.duplicates, 1u);
+    ASSERT_DOUBLE_EQ(l1.win_rate(), 0.75);
+    ASSERT_EQ(l1.lead.count(), 1u);
+    ASSERT_GE(l1.lead.percentile(0.5), 40us);
+    ASSERT_EQ(l1.lag.count(), 1u);
+
+    // An untimed duplicate is counted but not recorded as lag.
+    const auto& l2 = s.lines[1];
+    ASSERT_EQ(l2.wins, 1u);
+    ASSERT_EQ(l2.duplicates, 2u);
+    ASSERT_EQ(l2.lag.count(), 1u);
+    ASSERT_GE(l2.lag.percentile(0.5), 40us);
+  }
+  // NOLINTEND(*-avoid-magic-numbers)
+
+  // Lines are not connections, and leave nothing behind.
+  m1.reset();
+  const auto s = registry.snapshot();
+  ASSERT_TRUE(s.connections.empty());
+  ASSERT_EQ(s.lines.size(), 1u);
+  ASSERT_EQ(s.lines[0].duplicates, 2u);
+  ASSERT_EQ(Arbitration_metrics::Snapshot().win_rate(), 0.0);
+}
@@ -0,0 +1,86 @@
+#include "bc/soup/mpsc_ring.h"
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+TEST(Mpsc_ring, capacity) {
+  ASSERT_EQ(Mpsc_ring<int>(0).capacity(), 2u);
+  ASSERT_EQ(Mpsc_ring<int>(1).capacity(), 2u);
+  ASSERT_EQ(Mpsc_ring<int>(2).capacity(), 2u);
+  ASSERT_EQ(Mpsc_ring<int>(3).capacity(), 4u);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  ASSERT_EQ(Mpsc_ring<int>(100).capacity(), 128u);
+}
+
+TEST(Mpsc_ring, push_pop) {
+  Mpsc_ring<int> r(4);
+  int i = 0;
+  ASSERT_FALSE(r.try_pop(i));
+  for (int j = 1; j <= 4; ++j)
+    ASSERT_TRUE(r.try_push(int(j)));
+  ASSERT_FALSE(r.try_push(5));
+  ASSERT_TRUE(r.try_pop(i));
+  ASSERT_EQ(i, 1);
+  ASSERT_TRUE(r.try_push(5));
+  for (int j = 2; j <= 5; ++j) {
+    ASSERT_TRUE(r.try_pop(i));
+    ASSERT_EQ(i, j);
+  }
+  ASSERT_FALSE(r.try_pop(i));
+}
+
+TEST(Mpsc_ring, move_only) {
+  Mpsc_ring<std::unique_ptr<int>> r(2);
+  auto p = std::make_unique<int>(1);
+  ASSERT_TRUE(r.try_push(std::move(p)));
+  ASSERT_EQ(p, nullptr);
+  ASSERT_TRUE(r.try_push(std::make_unique<int>(2)));
+  // Not moved from on failure
+  auto q = std::make_unique<int>(3);
+  ASSERT_FALSE(r.try_push(std::move(q)));
+  ASSERT_NE(q, nullptr);
+  std::unique_ptr<int> v;
+  ASSERT_TRUE(r.try_pop(v));
+  ASSERT_EQ(*v, 1);
+}
+
+TEST(Mpsc_ring, producers) {
+  constexpr std::size_t producers = 4;
+  constexpr std::size_t count = 20'000;
+  Mpsc_ring<std::size_t> r(64);
+
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&r, p] {
+      for (std::size_t i = 0; i < count; ++i) {
+        while (!r.try_push(p * count + i))
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  // Each producer's values arrive in order.
+  std::vector<std::size_t> next(producers, 0);
+  std::size_t received = 0;
+  while (received < producers * count) {
+    std::size_t v = 0;
+    if (!r.try_pop(v)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const auto p = v / count;
+    ASSERT_EQ(v % count, next[p]);
+    ++next[p];
+    ++received;
+  }
+  for (auto& thread : threads)
+    thread.join();
+  for (const auto n : next)
+    ASSERT_EQ(n, count);
+}
@@ -0,0 +1,56 @@
+#include "bc/soup/reconnect_policy.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+using namespace std::chrono_literals;
+
+TEST(Reconnect_backoff, exponential) {
+  Reconnect_backoff backoff(
+      {.initial_delay = 100ms, .max_delay = 500ms, .full_jitter = false});
+  // Never logged in, so no immediate retry
+  ASSERT_EQ(backoff.next_delay(), 100ms);
+  ASSERT_EQ(backoff.next_delay(), 200ms);
+  ASSERT_EQ(backoff.next_delay(), 400ms);
+  ASSERT_EQ(backoff.next_delay(), 500ms);
+  ASSERT_EQ(backoff.next_delay(), 500ms);
+
+  backoff.on_login();
+  ASSERT_EQ(backoff.next_delay(), 0ms);
+  ASSERT_EQ(backoff.next_delay(), 100ms);
+  ASSERT_EQ(backoff.next_delay(), 200ms);
+
+  backoff.on_login();
+  backoff.reset();
+  ASSERT_EQ(backoff.next_delay(), 100ms);
+
+  backoff.set_policy({.initial_delay = 50ms,
+                      .max_delay = 1s,
+                      .multiplier = 3,
+                      .full_jitter = false,
+                      .immediate_first_retry = false});
+  backoff.on_login();
+  ASSERT_EQ(backoff.next_delay(), 50ms);
+  ASSERT_EQ(backoff.next_delay(), 150ms);
+}
+
+TEST(Reconnect_backoff, full_jitter) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test seed
+  Reconnect_backoff backoff({.initial_delay = 100ms, .max_delay = 400ms}, 1);
+  bool varied = false;
+  auto previous = 0ms;
+  auto ceiling = 100ms;
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Enough draws to vary
+  for (int i = 0; i < 100; ++i) {
+    const auto delay = backoff.next_delay();
+    ASSERT_GE(delay, 0ms);
+    ASSERT_LE(delay, ceiling);
+    varied = varied || (i > 0 && delay != previous);
+    previous = delay;
+    ceiling = std::min(ceiling * 2, 400ms);
+  }
+  ASSERT_TRUE(varied);
+}
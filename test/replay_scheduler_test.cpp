@@ -0,0 +1,245 @@
+#include "bc/soup/server/replay_scheduler.h"
+
+#include "loopback.h"
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/file_store.h"
+#include "bc/soup/server/handler.h"
+#include "bc/soup/server/port.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+const std::string filename = "test_replay_store";
+// NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+constexpr std::size_t message_size = 100;
+
+std::string make_message(std::size_t i) {
+  std::string message = std::to_string(i);
+  message.resize(message_size, '.');
+  return message;
+}
+
+// Passes its port's drained write buffer on to the scheduler.
+class Replaying_port_handler final : public server::Port_handler {
+public:
+  explicit Replaying_port_handler(server::Replay_scheduler& scheduler)
+      : scheduler_(&scheduler) {}
+
+  void login_success(const Login_accepted_packet&) override {
+    logged_in = true;
+  }
+
+  void unsequenced_data(const void*, std::size_t) override {}
+  void logout_request() override {}
+
+  void write_buffer_empty() override {
+    if (port)
+      scheduler_->write_buffer_empty(*port);
+  }
+
+  void debug(std::string_view) override {}
+
+  void transport_error(asio::error_code, std::string_view) override {}
+  void protocol_violation(Packet_error) override {}
+
+  void disconnect(Disconnect_reason) override {}
+
+  server::Port* port = nullptr;
+  bool logged_in = false;
+
+private:
+  server::Replay_scheduler* scheduler_ = nullptr;
+};
+
+// A server with one port per user, and a client logged in to each from
+// sequence number 1, before any replay is added.
+struct Fixture {
+  Fixture(std::size_t messages, const std::vector<std::string>& users,
+          bool timestamps = false)
+      : store(filename), scheduler(io_context.get_executor(), store),
+        loopback(io_context) {
+    ::unlink(filename.c_str());
+    store.set_timestamps(timestamps);
+    EXPECT_FALSE(store.open());
+    for (std::size_t i = 1; i <= messages; ++i) {
+      const auto message = make_message(i);
+      EXPECT_FALSE(store.add(message.data(), message.size()));
+    }
+
+    for (const auto& user : users) {
+      auto& handler = port_handlers.emplace_back(
+          std::make_unique<Replaying_port_handler>(scheduler));
+      handler->port = loopback.add_port(user, *handler);
+      ports.push_back(handler->port);
+    }
+    loopback.start();
+
+    for (const auto& user : users) {
+      auto& handler = client_handlers.emplace_back(
+          std::make_unique<Recording_client_handler>());
+      auto& connection_handler = connection_handlers.emplace_back(
+          std::make_unique<Recording_connection_handler>());
+      auto& client = clients.emplace_back(std::make_unique<client::Client>(
+          io_context.get_executor(), *handler));
+      EXPECT_TRUE(
+          add_line(*client, loopback.endpoint(), user, *connection_handler));
+      EXPECT_FALSE(client->start());
+    }
+    for (const auto& handler : port_handlers)
+      run_until(io_context, [&] { return handler->logged_in; });
+  }
+
+  ~Fixture() {
+    scheduler.stop();
+    for (auto& client : clients)
+      client->stop();
+    loopback.server.stop();
+    io_context.run();
+    EXPECT_FALSE(store.close());
+    ::unlink(filename.c_str());
+  }
+
+  Fixture(const Fixture&) = delete;
+  Fixture& operator=(const Fixture&) = delete;
+
+  Fixture(Fixture&&) = delete;
+  Fixture& operator=(Fixture&&) = delete;
+
+  void run_until_received(std::size_t messages) {
+    for (const auto& handler : client_handlers) {
+      while (handler->messages.size() < messages)
+        io_context.run_one();
+    }
+  }
+
+  asio::io_context io_context;
+  File_store store;
+  server::Replay_scheduler scheduler;
+  std::vector<std::unique_ptr<Replaying_port_handler>> port_handlers;
+  Test_server loopback;
+  std::vector<server::Port*> ports;
+  std::vector<std::unique_ptr<Recording_client_handler>> client_handlers;
+  std::vector<std::unique_ptr<Recording_connection_handler>>
+      connection_handlers;
+  std::vector<std::unique_ptr<client::Client>> clients;
+};
+
+void check_received(const Recording_client_handler& handler,
+                    std::size_t messages) {
+  ASSERT_EQ(handler.messages.size(), messages);
+  for (std::size_t i = 0; i < messages; ++i) {
+    ASSERT_EQ(handler.sequence_numbers[i], i + 1);
+    ASSERT_EQ(handler.messages[i], make_message(i + 1));
+  }
+}
+
+} // namespace
+
+TEST(Replay_scheduler, interleaves) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test values
+  constexpr std::size_t messages = 1000;
+  constexpr std::size_t quantum = 1024;
+  Fixture fixture(messages, {"a", "b"});
+  auto& scheduler = fixture.scheduler;
+  scheduler.set_quantum(quantum);
+  for (auto* port : fixture.ports)
+    scheduler.add(*port);
+  ASSERT_TRUE(scheduler.is_replaying(*fixture.ports[0]));
+  ASSERT_TRUE(scheduler.is_replaying(*fixture.ports[1]));
+
+  // Neither replay gets more than a turn ahead of the other.
+  auto progress = scheduler.progress();
+  while (scheduler.progress().size() == 2) {
+    progress = scheduler.progress();
+    ASSERT_LE(progress[0].bytes_sent, progress[1].bytes_sent + quantum);
+    ASSERT_LE(progress[1].bytes_sent, progress[0].bytes_sent + quantum);
+    fixture.io_context.run_one();
+  }
+  ASSERT_EQ(progress[0].end_sequence_number, messages + 1);
+  ASSERT_GT(progress[1].messages_sent, messages / 2);
+  ASSERT_FALSE(progress[0].error);
+
+  fixture.run_until_received(messages);
+  ASSERT_TRUE(scheduler.progress().empty());
+  ASSERT_FALSE(scheduler.is_replaying(*fixture.ports[0]));
+  ASSERT_EQ(fixture.ports[0]->next_sequence_number(), messages + 1);
+  for (const auto& handler : fixture.client_handlers)
+    check_received(*handler, messages);
+}
+
+TEST(Replay_scheduler, rate_limit) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test values
+  constexpr std::size_t messages = 200;
+  constexpr std::size_t rate_limit = 100'000;
+  constexpr std::size_t quantum = 1000;
+  Fixture fixture(messages, {"a"});
+  auto& scheduler = fixture.scheduler;
+  scheduler.set_quantum(quantum);
+  scheduler.set_rate_limit(rate_limit);
+
+  const auto start = std::chrono::steady_clock::now();
+  scheduler.add(*fixture.ports[0]);
+  fixture.run_until_received(messages);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // All but the first quantum waits for the bucket to refill, and the last
+  // message may overdraw it.
+  const std::chrono::duration<double> expected(
+      static_cast<double>(messages * message_size - quantum - message_size) /
+      rate_limit);
+  ASSERT_GE(elapsed, expected);
+  check_received(*fixture.client_handlers[0], messages);
+}
+
+TEST(Replay_scheduler, caught_up) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  constexpr std::size_t messages = 3;
+  Fixture fixture(messages, {"a"});
+  auto& port = *fixture.ports[0];
+  port.set_next_sequence_number(messages + 1);
+  fixture.scheduler.add(port);
+  ASSERT_FALSE(fixture.scheduler.is_replaying(port));
+
+  port.set_next_sequence_number(2);
+  fixture.scheduler.add(port);
+  ASSERT_TRUE(fixture.scheduler.is_replaying(port));
+  fixture.scheduler.remove(port);
+  ASSERT_FALSE(fixture.scheduler.is_replaying(port));
+  ASSERT_TRUE(fixture.scheduler.progress().empty());
+}
+
+TEST(Replay_scheduler, rewind) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  constexpr std::size_t messages = 50;
+  Fixture fixture(messages, {"a"}, true);
+  auto& port = *fixture.ports[0];
+  auto& scheduler = fixture.scheduler;
+  ASSERT_FALSE(scheduler.rewind(port, std::chrono::system_clock::now() +
+                                          std::chrono::hours(1)));
+  ASSERT_EQ(port.next_sequence_number(), messages + 1);
+  scheduler.add(port);
+  ASSERT_FALSE(scheduler.is_replaying(port));
+
+  ASSERT_FALSE(scheduler.rewind(port, {}));
+  ASSERT_EQ(port.next_sequence_number(), 1u);
+  scheduler.add(port);
+  fixture.run_until_received(messages);
+  check_received(*fixture.client_handlers[0], messages);
+}
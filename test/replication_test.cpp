@@ -0,0 +1,185 @@
+#include "bc/soup/server/replication.h"
+
+#include "loopback.h"
+
+#include "bc/soup/client/connection.h"
+#include "bc/soup/client/journal.h"
+#include "bc/soup/file_store.h"
+#include "bc/soup/server/acceptor.h"
+#include "bc/soup/server/handler.h"
+#include "bc/soup/server/port.h"
+#include "bc/soup/server/replay_scheduler.h"
+#include "bc/soup/server/server.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+const std::string primary_filename = "test_primary_store";
+const std::string standby_filename = "test_standby_journal";
+
+std::string make_message(std::size_t i) {
+  std::string message = std::to_string(i);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test size
+  message.resize(50, '.');
+  return message;
+}
+
+void remove_files() {
+  ::unlink(primary_filename.c_str());
+  ::unlink(standby_filename.c_str());
+  ::unlink((standby_filename + ".session").c_str());
+}
+
+// The primary's port for the standby: replayed to from the store, with the
+// standby's acknowledgements passed on to the replica.
+class Standby_port_handler final : public server::Port_handler {
+public:
+  Standby_port_handler(server::Replay_scheduler& scheduler,
+                       server::Replica& replica)
+      : scheduler_(&scheduler), replica_(&replica) {}
+
+  void login_success(const Login_accepted_packet&) override {
+    scheduler_->add(*port);
+  }
+
+  void unsequenced_data(const void* data, std::size_t size) override {
+    ASSERT_TRUE(replica_->unsequenced_data(data, size));
+  }
+
+  void logout_request() override {}
+
+  void write_buffer_empty() override { scheduler_->write_buffer_empty(*port); }
+
+  void debug(std::string_view) override {}
+
+  void transport_error(asio::error_code, std::string_view) override {}
+  void protocol_violation(Packet_error) override {}
+
+  void disconnect(Disconnect_reason) override {}
+
+  server::Port* port = nullptr;
+
+private:
+  server::Replay_scheduler* scheduler_ = nullptr;
+  server::Replica* replica_ = nullptr;
+};
+
+void add_messages(File_store& store, std::size_t first, std::size_t last) {
+  for (std::size_t i = first; i <= last; ++i) {
+    const auto message = make_message(i);
+    ASSERT_FALSE(store.add(message.data(), message.size()));
+  }
+}
+
+} // namespace
+
+TEST(Replication, acknowledgement) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  const server::Replication_acknowledgement sent{.next_sequence_number =
+                                                     0x0102030405060708};
+  const auto data = sent.encode();
+  ASSERT_EQ(data[0], std::byte{'R'});
+  ASSERT_EQ(data[1], std::byte{1});
+  server::Replication_acknowledgement received;
+  ASSERT_TRUE(received.decode(data.data(), data.size()));
+  ASSERT_EQ(received.next_sequence_number, sent.next_sequence_number);
+  ASSERT_FALSE(received.decode(data.data(), data.size() - 1));
+  ASSERT_FALSE(received.decode("x2345678", data.size()));
+}
+
+TEST(Replication, standby) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test values
+  constexpr std::size_t messages = 2000;
+  constexpr std::size_t live_messages = 100;
+  remove_files();
+  asio::io_context io_context;
+
+  // The primary, with a session already under way
+  File_store primary_store(primary_filename);
+  ASSERT_FALSE(primary_store.open());
+  add_messages(primary_store, 1, messages);
+  server::Replay_scheduler scheduler(io_context.get_executor(),
+                                     primary_store);
+  server::Replica replica(primary_store);
+  Standby_port_handler port_handler(scheduler, replica);
+  Test_server primary(io_context);
+  auto* const port = primary.add_port("stby", port_handler);
+  ASSERT_TRUE(port);
+  port_handler.port = port;
+  primary.start();
+  ASSERT_EQ(replica.lag().messages, messages);
+
+  // The standby catches up, and acknowledges it has.
+  client::Journal journal(standby_filename);
+  ASSERT_FALSE(journal.open());
+  server::Standby standby(io_context.get_executor(), journal);
+  Recording_connection_handler connection_handler;
+  const auto connection =
+      standby.add_connection(primary.endpoint(), connection_handler);
+  ASSERT_TRUE(connection);
+  ASSERT_FALSE((*connection)->set_username("stby"));
+  ASSERT_FALSE((*connection)->set_password(test_password));
+  ASSERT_FALSE(standby.start());
+  while (replica.lag().messages != 0)
+    io_context.run_one();
+  ASSERT_EQ(standby.next_sequence_number(), messages + 1);
+  ASSERT_EQ(journal.session(), "S");
+  ASSERT_EQ(replica.lag().time, std::chrono::nanoseconds::zero());
+
+  // Live messages lag until acknowledged.
+  add_messages(primary_store, messages + 1, messages + live_messages);
+  ASSERT_EQ(replica.lag().messages, live_messages);
+  ASSERT_GT(replica.lag().time, std::chrono::nanoseconds::zero());
+  scheduler.add(*port);
+  while (replica.lag().messages != 0)
+    io_context.run_one();
+  const auto end = messages + live_messages + 1;
+  ASSERT_EQ(replica.lag().next_sequence_number, end);
+
+  // The primary fails; the standby's ports start from the end of its
+  // journal.
+  scheduler.stop();
+  primary.server.stop();
+  server::Server standby_server(io_context.get_executor());
+  const auto standby_acceptor = standby_server.add_acceptor(
+      asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  ASSERT_TRUE(standby_acceptor);
+  const auto standby_port = (*standby_acceptor)->add_port("a", "p");
+  ASSERT_TRUE(standby_port);
+  const std::array ports{*standby_port};
+  standby.promote(ports);
+  while (!standby.is_promoted())
+    io_context.run_one();
+  ASSERT_EQ((*standby_port)->next_sequence_number(), end);
+
+  std::vector<Message> stored;
+  ASSERT_FALSE(journal.store().get(1, end - 1, stored));
+  ASSERT_EQ(stored.size(), end - 1);
+  for (std::size_t i = 0; i < stored.size(); ++i) {
+    ASSERT_EQ(std::string_view(static_cast<const char*>(stored[i].data()),
+                               stored[i].size()),
+              make_message(i + 1));
+  }
+
+  standby_server.stop();
+  io_context.run();
+  ASSERT_FALSE(journal.close());
+  ASSERT_FALSE(primary_store.close());
+  remove_files();
+}
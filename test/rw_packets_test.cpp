@@ -404,6 +404,24 @@ void assert_non_empty(const Write_packet& p, char packet_type,
 
 } // namespace
 
+TEST(Packet_view, packet) {
+  const std::string_view sv = "hello";
+  const Write_packet w('a', sv.data(), sv.size());
+  const Packet_view p(w.data(), w.size());
+  ASSERT_EQ(p.packet_size(), 1u + sv.size());
+  ASSERT_EQ(p.packet_type(), 'a');
+  ASSERT_EQ(p.payload_size(), sv.size());
+  ASSERT_EQ(std::memcmp(p.payload_data(), sv.data(), sv.size()), 0);
+  ASSERT_EQ(p.data(), w.data());
+  ASSERT_EQ(p.size(), w.size());
+
+  const Write_packet e('b');
+  const Packet_view q(e.data(), e.size());
+  ASSERT_EQ(q.packet_size(), 1u);
+  ASSERT_EQ(q.packet_type(), 'b');
+  ASSERT_EQ(q.payload_size(), 0u);
+}
+
 TEST(Write_packet, default_constructor) {
   Write_packet p;
   assert_empty(p);
@@ -0,0 +1,185 @@
+#include "bc/soup/send_queue.h"
+
+#include "bc/soup/constants.h"
+#include "bc/soup/server/message.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+using Message = server::Message;
+
+// Stands in for server::Port; accepts up to limit messages, then reports
+// error until the limit is raised.
+struct Sink {
+  std::vector<std::uint32_t> values;
+  std::size_t limit = static_cast<std::size_t>(-1);
+  Write_error error = Write_error::buffer_full;
+
+  // NOLINTNEXTLINE(*-rvalue-reference-param-not-moved): Moved on success
+  Write_error send_message(Message&& message) {
+    if (values.size() == limit)
+      return error;
+    std::uint32_t v = 0;
+    std::memcpy(&v, message.payload_data(), sizeof(v));
+    values.push_back(v);
+    const Message sent(std::move(message));
+    return Write_error::none;
+  }
+};
+
+using Queue = Send_queue<Sink, Message>;
+
+struct Handler final : Queue::Handler {
+  std::vector<std::pair<Write_error, std::size_t>> failures;
+
+  void send_failure(Write_error error, Message&& message) override {
+    failures.emplace_back(error, message.payload_size());
+  }
+};
+
+Write_error push(Queue& q, std::uint32_t v) {
+  return q.push(&v, sizeof(v));
+}
+
+} // namespace
+
+TEST(Send_queue, push) {
+  asio::io_context io_context;
+  Sink sink;
+  Queue q(io_context.get_executor(), sink, 4);
+  ASSERT_EQ(q.capacity(), 4u);
+
+  ASSERT_EQ(q.push(nullptr, 0), Write_error::empty_buffer);
+  ASSERT_EQ(q.push(nullptr, 1), Write_error::null_buffer);
+  for (std::uint32_t i = 0; i < 4; ++i)
+    ASSERT_EQ(push(q, i), Write_error::none);
+  ASSERT_EQ(push(q, 4), Write_error::buffer_full);
+  ASSERT_TRUE(sink.values.empty());
+
+  // One drain for all four pushes
+  ASSERT_EQ(io_context.poll(), 1u);
+  ASSERT_EQ(sink.values, (std::vector<std::uint32_t>{0, 1, 2, 3}));
+  ASSERT_EQ(io_context.poll(), 0u);
+}
+
+TEST(Send_queue, message_too_long) {
+  asio::io_context io_context;
+  Sink sink;
+  Queue q(io_context.get_executor(), sink, 4);
+
+  std::vector<std::byte> data(max_payload_length + 1);
+  ASSERT_EQ(q.push(data.data(), data.size()), Write_error::message_too_long);
+  ASSERT_EQ(q.push(data.data(), max_payload_length), Write_error::none);
+  ASSERT_EQ(io_context.poll(), 1u);
+  ASSERT_EQ(sink.values.size(), 1u);
+}
+
+TEST(Send_queue, batch_size) {
+  asio::io_context io_context;
+  Sink sink;
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  Queue q(io_context.get_executor(), sink, 8);
+  q.set_batch_size(3);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  for (std::uint32_t i = 0; i < 7; ++i)
+    ASSERT_EQ(push(q, i), Write_error::none);
+  ASSERT_EQ(io_context.run_one(), 1u);
+  ASSERT_EQ(sink.values.size(), 3u);
+  ASSERT_EQ(io_context.run_one(), 1u);
+  ASSERT_EQ(sink.values.size(), 6u);
+  ASSERT_EQ(io_context.poll(), 1u);
+  ASSERT_EQ(sink.values.size(), 7u);
+}
+
+TEST(Send_queue, buffer_full) {
+  asio::io_context io_context;
+  Sink sink;
+  sink.limit = 2;
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  Queue q(io_context.get_executor(), sink, 8);
+  for (std::uint32_t i = 0; i < 4; ++i)
+    ASSERT_EQ(push(q, i), Write_error::none);
+  io_context.poll();
+  ASSERT_EQ(sink.values.size(), 2u);
+
+  // Held while the sink is full; further pushes do not post drains.
+  ASSERT_EQ(push(q, 4), Write_error::none);
+  io_context.restart();
+  ASSERT_EQ(io_context.poll(), 1u);
+  ASSERT_EQ(push(q, 5), Write_error::none);
+  io_context.restart();
+  ASSERT_EQ(io_context.poll(), 0u);
+  ASSERT_EQ(sink.values.size(), 2u);
+
+  sink.limit = static_cast<std::size_t>(-1);
+  q.resume();
+  ASSERT_EQ(sink.values, (std::vector<std::uint32_t>{0, 1, 2, 3, 4, 5}));
+
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  ASSERT_EQ(push(q, 6), Write_error::none);
+  io_context.restart();
+  ASSERT_EQ(io_context.poll(), 1u);
+  ASSERT_EQ(sink.values.size(), 7u);
+}
+
+TEST(Send_queue, send_failure) {
+  asio::io_context io_context;
+  Sink sink;
+  sink.limit = 1;
+  sink.error = Write_error::disconnected;
+  Handler handler;
+  Queue q(io_context.get_executor(), sink, 4, handler);
+  for (std::uint32_t i = 0; i < 3; ++i)
+    ASSERT_EQ(push(q, i), Write_error::none);
+  io_context.poll();
+  ASSERT_EQ(sink.values.size(), 1u);
+  ASSERT_EQ(handler.failures.size(), 2u);
+  ASSERT_EQ(handler.failures[0].first, Write_error::disconnected);
+  ASSERT_EQ(handler.failures[0].second, sizeof(std::uint32_t));
+}
+
+TEST(Send_queue, producers) {
+  constexpr std::uint32_t producers = 4;
+  constexpr std::uint32_t count = 20'000;
+  asio::io_context io_context;
+  Sink sink;
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  Queue q(io_context.get_executor(), sink, 256);
+
+  auto guard = asio::make_work_guard(io_context);
+  std::thread io_thread([&io_context] { io_context.run(); });
+  std::vector<std::thread> threads;
+  for (std::uint32_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&q, p] {
+      for (std::uint32_t i = 0; i < count; ++i) {
+        while (push(q, p * count + i) == Write_error::buffer_full)
+          std::this_thread::yield();
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  asio::post(io_context, [&guard] { guard.reset(); });
+  io_thread.join();
+
+  ASSERT_EQ(sink.values.size(), std::size_t{producers} * count);
+  std::vector<std::uint32_t> next(producers, 0);
+  for (const auto v : sink.values) {
+    const auto p = v / count;
+    ASSERT_EQ(v % count, next[p]);
+    ++next[p];
+  }
+}
@@ -0,0 +1,154 @@
+#include "bc/soup/client/session.h"
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/client/handler.h"
+#include "bc/soup/server/port.h"
+#include "bc/soup/server/port_session.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+std::uint32_t value_of(const void* data) {
+  std::uint32_t v = 0;
+  std::memcpy(&v, data, sizeof(v));
+  return v;
+}
+
+// Collects batches until an empty one.
+asio::awaitable<void> receive(client::Session& session,
+                              std::vector<std::vector<std::uint64_t>>& batches,
+                              bool& done) {
+  while (true) {
+    const auto messages = co_await session.next_messages();
+    if (messages.empty())
+      break;
+    auto& batch = batches.emplace_back();
+    for (const auto& m : messages) {
+      EXPECT_EQ(m.size, sizeof(std::uint32_t));
+      EXPECT_EQ(value_of(m.data), m.sequence_number);
+      batch.push_back(m.sequence_number);
+    }
+  }
+  done = true;
+}
+
+asio::awaitable<void>
+receive(server::Port_session& session,
+        std::vector<std::vector<std::uint32_t>>& batches) {
+  const auto messages = co_await session.next_messages();
+  auto& batch = batches.emplace_back();
+  for (const auto& m : messages)
+    batch.push_back(value_of(m.data));
+}
+
+asio::awaitable<void> send(server::Port_session& session,
+                           const std::uint32_t& v,
+                           std::optional<Write_error>& error) {
+  error = co_await session.send(&v, sizeof(v));
+}
+
+} // namespace
+
+TEST(Session, next_messages) {
+  asio::io_context io_context;
+  client::Client client(io_context.get_executor());
+  client::Session session(io_context.get_executor(), client);
+  std::vector<std::vector<std::uint64_t>> batches;
+  bool done = false;
+  asio::co_spawn(io_context, receive(session, batches, done), asio::detached);
+  io_context.poll();
+  ASSERT_TRUE(batches.empty());
+
+  // Copied, so the received data need only last for the call
+  std::vector<std::uint32_t> values{1, 2};
+  const std::vector<client::Sequenced_data> messages{
+      {1, &values[0], sizeof(std::uint32_t)},
+      {2, &values[1], sizeof(std::uint32_t)}};
+  session.sequenced_data(messages);
+  values.assign(values.size(), 0);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  const std::uint32_t three = 3;
+  session.sequenced_data(three, &three, sizeof(three));
+  io_context.restart();
+  io_context.poll();
+  ASSERT_EQ(batches, (std::vector<std::vector<std::uint64_t>>{{1, 2, 3}}));
+  ASSERT_FALSE(done);
+
+  // Messages received before the end of session are delivered first.
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  const std::uint32_t four = 4;
+  session.sequenced_data(four, &four, sizeof(four));
+  session.end_of_session();
+  io_context.restart();
+  io_context.poll();
+  ASSERT_EQ(batches, (std::vector<std::vector<std::uint64_t>>{{1, 2, 3}, {4}}));
+  ASSERT_TRUE(done);
+  ASSERT_TRUE(session.has_session_ended());
+}
+
+TEST(Session, cancel) {
+  asio::io_context io_context;
+  client::Client client(io_context.get_executor());
+  client::Session session(io_context.get_executor(), client);
+  std::vector<std::vector<std::uint64_t>> batches;
+  bool done = false;
+  asio::co_spawn(io_context, receive(session, batches, done), asio::detached);
+  io_context.poll();
+  session.cancel();
+  io_context.restart();
+  io_context.poll();
+  ASSERT_TRUE(batches.empty());
+  ASSERT_TRUE(done);
+  ASSERT_FALSE(session.has_session_ended());
+}
+
+TEST(Port_session, next_messages) {
+  asio::io_context io_context;
+  server::Port port("user", "password", nullptr);
+  server::Port_session session(io_context.get_executor(), port);
+  std::vector<std::vector<std::uint32_t>> batches;
+  asio::co_spawn(io_context, receive(session, batches), asio::detached);
+  io_context.poll();
+  ASSERT_TRUE(batches.empty());
+
+  std::uint32_t v = 1;
+  session.unsequenced_data(&v, sizeof(v));
+  v = 2;
+  session.unsequenced_data(&v, sizeof(v));
+  io_context.restart();
+  io_context.poll();
+  ASSERT_EQ(batches, (std::vector<std::vector<std::uint32_t>>{{1, 2}}));
+
+  // A disconnect wakes the reader with nothing.
+  asio::co_spawn(io_context, receive(session, batches), asio::detached);
+  io_context.restart();
+  io_context.poll();
+  session.disconnect(Disconnect_reason::peer_closed);
+  io_context.restart();
+  io_context.poll();
+  ASSERT_EQ(batches, (std::vector<std::vector<std::uint32_t>>{{1, 2}, {}}));
+}
+
+TEST(Port_session, send) {
+  asio::io_context io_context;
+  server::Port port("user", "password", nullptr);
+  server::Port_session session(io_context.get_executor(), port);
+  std::optional<Write_error> error;
+  const std::uint32_t v = 1;
+  asio::co_spawn(io_context, send(session, v, error), asio::detached);
+  io_context.poll();
+  // Not buffer_full, so returned without waiting
+  ASSERT_EQ(error, Write_error::disconnected);
+}
@@ -0,0 +1,196 @@
+#include "bc/soup/shared_tail.h"
+
+#include "bc/soup/file_store.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+const std::string filename = "test_tail_store";
+const std::string tail_filename = "test_tail_store.tail";
+
+std::string make_message(std::size_t i) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test sizes
+  return std::string(i % 100 + 1, static_cast<char>('a' + i % 26));
+}
+
+std::string_view to_string_view(std::span<const std::byte> message) {
+  return {reinterpret_cast<const char*>(message.data()), message.size()};
+}
+
+void remove_files() {
+  ::unlink(filename.c_str());
+  ::unlink(tail_filename.c_str());
+}
+
+} // namespace
+
+TEST(Shared_tail, seqlock) {
+  Shared_tail tail{};
+  Shared_tail::Position position;
+  ASSERT_FALSE(tail.load(position));
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test values
+  tail.store({.end = 10, .messages = 2, .flags = Shared_tail::checksums});
+  ASSERT_TRUE(tail.load(position));
+  ASSERT_EQ(position.end, 10u);
+  ASSERT_EQ(position.messages, 2u);
+  ASSERT_EQ(position.flags, Shared_tail::checksums);
+
+  // A writer stopped part way through
+  ++tail.sequence;
+  ASSERT_FALSE(tail.load(position));
+  tail.store({.end = 20, .messages = 3});
+  ASSERT_TRUE(tail.load(position));
+  ASSERT_EQ(position.messages, 3u);
+  ASSERT_EQ(tail.sequence % 2, 0u);
+}
+
+TEST(Shared_tail, read) {
+  remove_files();
+  Tail_reader reader(filename, tail_filename);
+  ASSERT_EQ(reader.open(), std::errc::no_such_file_or_directory);
+
+  File_store store(filename);
+  store.set_shared_tail(tail_filename);
+  ASSERT_FALSE(store.open());
+  ASSERT_FALSE(reader.open());
+  ASSERT_FALSE(reader.read(10));
+  ASSERT_TRUE(reader.messages().empty());
+
+  // In batches, with more added in between
+  std::size_t added = 0;
+  std::size_t read = 0;
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test sizes
+  for (const std::size_t count : {1, 5, 100, 3}) {
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto message = make_message(++added);
+      ASSERT_FALSE(store.add(message.data(), message.size()));
+    }
+    while (read < added) {
+      ASSERT_FALSE(reader.read(7));
+      ASSERT_FALSE(reader.messages().empty());
+      for (const auto message : reader.messages())
+        ASSERT_EQ(to_string_view(message), make_message(++read));
+    }
+    ASSERT_EQ(reader.next_sequence_number(), added + 1);
+    ASSERT_FALSE(reader.read(7));
+    ASSERT_TRUE(reader.messages().empty());
+  }
+
+  // Back, and ahead of the store
+  reader.seek(3);
+  ASSERT_FALSE(reader.read(2));
+  ASSERT_EQ(reader.messages().size(), 2u);
+  ASSERT_EQ(to_string_view(reader.messages()[0]), make_message(3));
+  reader.seek(added + 3);
+  ASSERT_FALSE(reader.read(10));
+  ASSERT_TRUE(reader.messages().empty());
+  for (std::size_t i = 0; i < 3; ++i) {
+    const auto message = make_message(++added);
+    ASSERT_FALSE(store.add(message.data(), message.size()));
+  }
+  ASSERT_FALSE(reader.read(10));
+  ASSERT_EQ(reader.messages().size(), 1u);
+  ASSERT_EQ(to_string_view(reader.messages()[0]), make_message(added));
+
+  // Reopening the store leaves the reader where it was.
+  ASSERT_FALSE(store.close());
+  ASSERT_FALSE(store.open());
+  ASSERT_FALSE(reader.read(10));
+  ASSERT_TRUE(reader.messages().empty());
+  ASSERT_FALSE(store.close());
+  remove_files();
+}
+
+TEST(Shared_tail, timestamps_and_growth) {
+  // Enough to outgrow the reader's first mapping several times over
+  constexpr std::size_t count = 50'000;
+  remove_files();
+  File_store store(filename);
+  store.set_checksums(true);
+  store.set_timestamps(true);
+  store.set_shared_tail(tail_filename);
+  ASSERT_FALSE(store.open());
+  Tail_reader reader(filename, tail_filename);
+  ASSERT_FALSE(reader.open());
+
+  const std::chrono::system_clock::time_point start(std::chrono::hours(1));
+  std::size_t read = 0;
+  for (std::size_t i = 1; i <= count; ++i) {
+    const auto message = make_message(i);
+    ASSERT_FALSE(store.add(message.data(), message.size(),
+                           start + std::chrono::microseconds(i)));
+    // NOLINTNEXTLINE(*-avoid-magic-numbers): Now and then
+    if (i % 1000 != 0 && i != count)
+      continue;
+    ASSERT_FALSE(reader.read(count));
+    ASSERT_EQ(reader.timestamps().size(), reader.messages().size());
+    for (std::size_t j = 0; j < reader.messages().size(); ++j) {
+      ++read;
+      ASSERT_EQ(to_string_view(reader.messages()[j]), make_message(read));
+      ASSERT_EQ(reader.timestamps()[j],
+                start + std::chrono::microseconds(read));
+    }
+  }
+  ASSERT_EQ(read, count);
+  ASSERT_FALSE(store.close());
+  remove_files();
+}
+
+TEST(Shared_tail, across_processes) {
+  constexpr std::size_t count = 10'000;
+  remove_files();
+  const pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    File_store store(filename);
+    store.set_shared_tail(tail_filename);
+    if (store.open())
+      _exit(EXIT_FAILURE);
+    for (std::size_t i = 1; i <= count; ++i) {
+      const auto message = make_message(i);
+      if (store.add(message.data(), message.size()))
+        _exit(EXIT_FAILURE);
+    }
+    _exit(store.close() ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+  Tail_reader reader(filename, tail_filename);
+  std::error_code ec;
+  while ((ec = reader.open()) == std::errc::no_such_file_or_directory)
+    ;
+  ASSERT_FALSE(ec);
+  std::size_t read = 0;
+  while (read < count) {
+    ASSERT_FALSE(reader.read(count));
+    for (const auto message : reader.messages())
+      ASSERT_EQ(to_string_view(message), make_message(++read));
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), EXIT_SUCCESS);
+  remove_files();
+}
+
+TEST(Shared_tail, not_with_direct_io) {
+  remove_files();
+  File_store store(filename);
+  store.set_direct_io(true);
+  store.set_shared_tail(tail_filename);
+  ASSERT_EQ(store.open(), std::error_code(EINVAL, std::system_category()));
+  remove_files();
+}
@@ -0,0 +1,202 @@
+#include "bc/soup/slab_list.h"
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+struct Element {
+  explicit Element(int value_, int* destroyed_ = nullptr)
+      : value(value_), destroyed(destroyed_) {}
+
+  ~Element() {
+    if (destroyed)
+      ++*destroyed;
+  }
+
+  Element(const Element&) = delete;
+  Element& operator=(const Element&) = delete;
+
+  Element(Element&&) = delete;
+  Element& operator=(Element&&) = delete;
+
+  int value = 0;
+  int* destroyed = nullptr;
+};
+
+struct Throwing {
+  explicit Throwing(bool do_throw) {
+    if (do_throw)
+      throw std::runtime_error("constructor");
+  }
+};
+
+template <typename List>
+std::vector<int> values(const List& list) {
+  std::vector<int> v;
+  for (const auto& element : list)
+    v.push_back(element.value);
+  return v;
+}
+
+} // namespace
+
+TEST(Slab_list, default_constructor) {
+  const Slab_list<Element> l;
+  ASSERT_TRUE(l.empty());
+  ASSERT_EQ(l.size(), 0u);
+  ASSERT_EQ(l.begin(), l.end());
+}
+
+TEST(Slab_list, emplace_back) {
+  Slab_list<Element, 2> l;
+  auto& e1 = l.emplace_back(1);
+  auto& e2 = l.emplace_back(2);
+  auto& e3 = l.emplace_back(3);
+  ASSERT_EQ(l.size(), 3u);
+  ASSERT_EQ(&l.front(), &e1);
+  ASSERT_EQ(&l.back(), &e3);
+  ASSERT_EQ(values(l), (std::vector<int>{1, 2, 3}));
+  ASSERT_EQ(e2.value, 2);
+}
+
+TEST(Slab_list, erase) {
+  int destroyed = 0;
+  Slab_list<Element, 2> l;
+  auto& e1 = l.emplace_back(1, &destroyed);
+  auto& e2 = l.emplace_back(2, &destroyed);
+  auto& e3 = l.emplace_back(3, &destroyed);
+
+  l.erase(e2);
+  ASSERT_EQ(destroyed, 1);
+  ASSERT_EQ(l.size(), 2u);
+  ASSERT_EQ(values(l), (std::vector<int>{1, 3}));
+
+  l.erase(e1);
+  ASSERT_EQ(values(l), (std::vector<int>{3}));
+  ASSERT_EQ(&l.front(), &e3);
+  ASSERT_EQ(&l.back(), &e3);
+
+  l.erase(e3);
+  ASSERT_TRUE(l.empty());
+  ASSERT_EQ(l.begin(), l.end());
+  ASSERT_EQ(destroyed, 3);
+}
+
+TEST(Slab_list, stable_addresses) {
+  Slab_list<Element, 4> l;
+  std::vector<Element*> addresses;
+  for (int i = 0; i < 100; ++i)
+    addresses.push_back(&l.emplace_back(i));
+  int i = 0;
+  for (auto& element : l) {
+    ASSERT_EQ(&element, addresses[i]);
+    ASSERT_EQ(element.value, i);
+    ++i;
+  }
+}
+
+TEST(Slab_list, reuse_erased_node) {
+  Slab_list<Element, 4> l;
+  l.emplace_back(1);
+  auto& e2 = l.emplace_back(2);
+  auto* address = &e2;
+  l.erase(e2);
+  auto& e3 = l.emplace_back(3);
+  ASSERT_EQ(&e3, address);
+  ASSERT_EQ(values(l), (std::vector<int>{1, 3}));
+}
+
+TEST(Slab_list, clear) {
+  int destroyed = 0;
+  Slab_list<Element, 2> l;
+  for (int i = 0; i < 5; ++i)
+    l.emplace_back(i, &destroyed);
+  l.clear();
+  ASSERT_TRUE(l.empty());
+  ASSERT_EQ(destroyed, 5);
+  l.emplace_back(7);
+  ASSERT_EQ(values(l), (std::vector<int>{7}));
+}
+
+TEST(Slab_list, destructor) {
+  int destroyed = 0;
+  {
+    Slab_list<Element, 2> l;
+    for (int i = 0; i < 5; ++i)
+      l.emplace_back(i, &destroyed);
+  }
+  ASSERT_EQ(destroyed, 5);
+}
+
+TEST(Slab_list, move_constructor) {
+  {
+    Slab_list<Element> l1;
+    auto& e = l1.emplace_back(1);
+    l1.emplace_back(2);
+    Slab_list<Element> l2(std::move(l1));
+    // NOLINTNEXTLINE(clang-analyzer-cplusplus.Move)
+    ASSERT_TRUE(l1.empty());
+    ASSERT_EQ(l1.begin(), l1.end());
+    ASSERT_EQ(values(l2), (std::vector<int>{1, 2}));
+    ASSERT_EQ(&l2.front(), &e);
+    l2.erase(e);
+    ASSERT_EQ(values(l2), (std::vector<int>{2}));
+  }
+  {
+    Slab_list<Element> l1;
+    Slab_list<Element> l2(std::move(l1));
+    ASSERT_TRUE(l2.empty());
+    ASSERT_EQ(l2.begin(), l2.end());
+    l2.emplace_back(3);
+    ASSERT_EQ(values(l2), (std::vector<int>{3}));
+  }
+}
+
+TEST(Slab_list, move_assignment) {
+  int destroyed = 0;
+  Slab_list<Element> l1;
+  l1.emplace_back(1);
+  Slab_list<Element> l2;
+  l2.emplace_back(2, &destroyed);
+  l2 = std::move(l1);
+  ASSERT_EQ(destroyed, 1);
+  // NOLINTNEXTLINE(clang-analyzer-cplusplus.Move)
+  ASSERT_TRUE(l1.empty());
+  ASSERT_EQ(values(l2), (std::vector<int>{1}));
+  l1.emplace_back(3);
+  ASSERT_EQ(values(l1), (std::vector<int>{3}));
+}
+
+TEST(Slab_list, bidirectional_iteration) {
+  Slab_list<Element, 2> l;
+  for (int i = 0; i < 3; ++i)
+    l.emplace_back(i);
+  auto iter = l.end();
+  ASSERT_EQ((--iter)->value, 2);
+  ASSERT_EQ((--iter)->value, 1);
+  ASSERT_EQ((--iter)->value, 0);
+  ASSERT_EQ(iter, l.begin());
+  ASSERT_EQ(std::prev(l.end())->value, 2);
+  ASSERT_EQ(std::distance(l.begin(), l.end()), 3);
+
+  const auto& cl = l;
+  Slab_list<Element, 2>::const_iterator citer = l.begin();
+  ASSERT_EQ(citer, cl.begin());
+}
+
+TEST(Slab_list, emplace_back_throws) {
+  Slab_list<Throwing, 1> l;
+  l.emplace_back(false);
+  ASSERT_THROW(l.emplace_back(true), std::runtime_error);
+  ASSERT_EQ(l.size(), 1u);
+  l.emplace_back(false);
+  ASSERT_EQ(l.size(), 2u);
+}
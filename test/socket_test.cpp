@@ -0,0 +1,181 @@
+#include "bc/soup/socket.h"
+
+#include "bc/soup/endpoint.h"
+#include "bc/soup/rw_packets.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+class Counting_handler final : public Socket_handler {
+public:
+  void connect_failure(asio::error_code) override {}
+  void connect_success() override {}
+
+  void read_failure(asio::error_code) override {}
+  void read_failure(Packet_error) override {}
+  void read_success(const Packet_view& packet) override {
+    received.emplace_back(static_cast<const std::byte*>(packet.data()),
+                          static_cast<const std::byte*>(packet.data()) +
+                              packet.size());
+  }
+  void read_batch_complete() override {}
+  void read_aborted() override {}
+  void read_end_of_file() override {}
+
+  void write_failure(asio::error_code ec) override { error = ec; }
+  void write_success(const Write_packet&) override { ++packets; }
+  void write_buffer_empty() override {}
+
+  void closed() override { is_closed = true; }
+
+  asio::error_code error;
+  std::vector<std::vector<std::byte>> received;
+  std::size_t packets = 0;
+  bool is_closed = false;
+};
+
+} // namespace
+
+TEST(Socket, zero_copy) {
+  asio::io_context io_context;
+  asio::ip::tcp::acceptor acceptor(
+      io_context, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  asio::ip::tcp::socket peer(io_context);
+  peer.connect(acceptor.local_endpoint());
+
+  Counting_handler handler;
+  Socket socket(acceptor.accept(), handler);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  const std::uint16_t threshold = 1024;
+  const auto ec = socket.set_zero_copy(threshold);
+  if (ec == asio::error::operation_not_supported)
+    GTEST_SKIP() << "Zero-copy not supported";
+  ASSERT_FALSE(ec) << ec.message();
+
+  // Either side of the threshold, each filled with its own value
+  std::vector<std::uint16_t> sizes{threshold, 1, threshold * 4};
+  for (std::size_t i = 0; i < sizes.size(); ++i) {
+    Write_packet packet('S', sizes[i]);
+    std::memset(packet.payload_data(), static_cast<int>(i), sizes[i]);
+    ASSERT_EQ(socket.async_write(std::move(packet)), Write_error::none);
+  }
+  while (handler.packets < sizes.size() && !handler.error)
+    io_context.run_one();
+  ASSERT_FALSE(handler.error) << handler.error.message();
+
+  for (std::size_t i = 0; i < sizes.size(); ++i) {
+    std::vector<std::byte> packet(packet_header_length + sizes[i]);
+    asio::read(peer, asio::buffer(packet));
+    ASSERT_EQ(packet[packet_size_length], std::byte{'S'});
+    for (std::size_t j = packet_header_length; j < packet.size(); ++j)
+      ASSERT_EQ(packet[j], static_cast<std::byte>(i));
+  }
+
+  // The wait for completions ends with the socket.
+  socket.close();
+  io_context.run();
+  ASSERT_TRUE(handler.is_closed);
+}
+
+// Closing does not wait for the kernel to finish with the held packets, but
+// they are kept until it has, so the peer still receives them intact.
+TEST(Socket, zero_copy_close) {
+  asio::io_context io_context;
+  asio::ip::tcp::acceptor acceptor(
+      io_context, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  asio::ip::tcp::socket peer(io_context);
+  // Small, so that what is sent waits in the kernel, not yet done with
+  peer.open(asio::ip::tcp::v4());
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  peer.set_option(asio::socket_base::receive_buffer_size(4096));
+  peer.connect(acceptor.local_endpoint());
+
+  Counting_handler handler;
+  Socket socket(acceptor.accept(), handler);
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test values
+  const std::uint16_t size = 20'000;
+  const std::size_t count = 16;
+  const auto ec = socket.set_zero_copy(1);
+  if (ec == asio::error::operation_not_supported)
+    GTEST_SKIP() << "Zero-copy not supported";
+  ASSERT_FALSE(ec) << ec.message();
+  socket.set_write_packets_limit(count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    Write_packet packet('S', size);
+    std::memset(packet.payload_data(), static_cast<int>(i), size);
+    ASSERT_EQ(socket.async_write(std::move(packet)), Write_error::none);
+  }
+  // Until some have been sent, with the peer not reading
+  while (handler.packets == 0 && !handler.error)
+    io_context.run_one();
+  ASSERT_FALSE(handler.error) << handler.error.message();
+  socket.close();
+  while (!handler.is_closed)
+    io_context.run_one();
+  const auto sent = handler.packets;
+
+  // Memory freed and reused would show here, or under a sanitizer.
+  std::vector<std::vector<char>> reuse(count, std::vector<char>(size, 'x'));
+  // Every packet sent in full, perhaps part of the next, then FIN
+  std::vector<std::byte> received;
+  asio::error_code read_ec;
+  asio::read(peer, asio::dynamic_buffer(received), read_ec);
+  ASSERT_EQ(read_ec, asio::error::eof);
+  const std::size_t packet_size = packet_header_length + size;
+  ASSERT_GE(received.size(), sent * packet_size);
+  for (std::size_t j = 0; j < received.size(); ++j) {
+    const auto offset = j % packet_size;
+    if (offset == packet_size_length) {
+      ASSERT_EQ(received[j], std::byte{'S'});
+    } else if (offset >= packet_header_length) {
+      ASSERT_EQ(received[j], static_cast<std::byte>(j / packet_size));
+    }
+  }
+  io_context.run();
+}
+
+TEST(Socket, unix_domain) {
+  asio::io_context io_context;
+  asio::local::stream_protocol::socket local(io_context);
+  asio::local::stream_protocol::socket peer(io_context);
+  asio::local::connect_pair(local, peer);
+
+  Counting_handler handler;
+  Socket socket(std::move(local), handler);
+  ASSERT_FALSE(is_tcp(socket.local_endpoint()));
+  socket.async_read();
+
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test value
+  const std::vector<std::byte> sent{std::byte{0}, std::byte{2}, std::byte{'+'},
+                                    std::byte{'x'}};
+  asio::write(peer, asio::buffer(sent));
+  while (handler.received.empty() && !handler.error)
+    io_context.run_one();
+  ASSERT_EQ(handler.received, std::vector<std::vector<std::byte>>{sent});
+
+  const char text = 'y';
+  ASSERT_EQ(socket.async_write(Write_packet('+', &text, 1)),
+            Write_error::none);
+  while (handler.packets == 0 && !handler.error)
+    io_context.run_one();
+  std::vector<std::byte> packet(sent.size());
+  asio::read(peer, asio::buffer(packet));
+  ASSERT_EQ(packet, (std::vector<std::byte>{std::byte{0}, std::byte{2},
+                                            std::byte{'+'}, std::byte{'y'}}));
+
+  socket.close();
+  io_context.run();
+  ASSERT_TRUE(handler.is_closed);
+}
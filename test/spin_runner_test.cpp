@@ -0,0 +1,142 @@
+#include "bc/soup/client/spin_runner.h"
+
+#include "loopback.h"
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/logical_packets.h"
+#include "bc/soup/metrics.h"
+#include "bc/soup/server/port.h"
+#include "bc/soup/timeouts.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Short enough that heartbeats flow, and would time out, within a test
+constexpr Timeouts timeouts{.heartbeat_period = 5ms,
+                            .heartbeat_timeout = 20ms,
+                            .login_timeout = 1s};
+
+// A server and a client with polled reads, logged in to it through a runner
+// that the io_context is driven by alone
+struct Test_session {
+  explicit Test_session(asio::io_context& io_context)
+      : loopback(io_context, timeouts),
+        client(io_context.get_executor(), client_handler),
+        runner(io_context, client) {
+    port = loopback.add_port("user", port_handler);
+    loopback.start();
+
+    client.set_polled_reads(true);
+    EXPECT_FALSE(client.set_timeouts(timeouts));
+    EXPECT_TRUE(
+        add_line(client, loopback.endpoint(), "user", connection_handler));
+    EXPECT_FALSE(client.start());
+    EXPECT_TRUE(spin_until([this] {
+      return connection_handler.logins == 1 && port_handler.logins == 1;
+    }));
+  }
+
+  // Spins the runner until the predicate holds, or gives up after a while.
+  template <typename Predicate> bool spin_until(Predicate predicate) {
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!predicate()) {
+      if (std::chrono::steady_clock::now() > deadline)
+        return false;
+      runner.poll_once();
+    }
+    return true;
+  }
+
+  void spin_for(std::chrono::milliseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+      runner.poll_once();
+  }
+
+  Recording_port_handler port_handler;
+  Test_server loopback;
+  server::Port* port = nullptr;
+  Recording_client_handler client_handler;
+  Recording_connection_handler connection_handler;
+  client::Client client;
+  client::Spin_runner runner;
+};
+
+} // namespace
+
+TEST(Spin_runner, polled_reads) {
+  asio::io_context io_context;
+  Test_session session(io_context);
+  ASSERT_EQ(session.connection_handler.logins, 1);
+
+  const std::vector<std::string> sent{"one", "two", "three"};
+  for (const auto& message : sent) {
+    ASSERT_EQ(session.port->send_message(message.data(), message.size()),
+              Write_error::none);
+  }
+  ASSERT_TRUE(session.spin_until(
+      [&] { return session.client_handler.messages.size() == sent.size(); }));
+  ASSERT_EQ(session.client_handler.messages, sent);
+  ASSERT_EQ(session.client_handler.sequence_numbers,
+            (std::vector<std::uint64_t>{1, 2, 3}));
+  ASSERT_EQ(session.client.next_sequence_number(), 4U);
+
+  // Heartbeats read by polling alone keep the line up for many timeouts.
+  session.spin_for(10 * timeouts.heartbeat_timeout);
+  ASSERT_TRUE(session.connection_handler.disconnects.empty());
+  ASSERT_TRUE(session.port_handler.disconnects.empty());
+  const auto metrics = session.client.metrics();
+  ASSERT_GT(metrics.total
+                .received_by_type[packet_type_index(
+                    Server_heartbeat_packet::packet_type)]
+                .packets,
+            0U);
+
+  // Closing with a polled read pending has no operation to wait for.
+  session.client.stop();
+  ASSERT_TRUE(session.spin_until(
+      [&] { return !session.connection_handler.disconnects.empty(); }));
+  ASSERT_EQ(session.connection_handler.disconnects,
+            std::vector<Disconnect_reason>{Disconnect_reason::user_initiated});
+  // Nothing more is read from the closed socket.
+  ASSERT_EQ(session.client.poll(), 0U);
+  ASSERT_TRUE(session.spin_until(
+      [&] { return !session.port_handler.disconnects.empty(); }));
+
+  session.loopback.server.stop();
+  io_context.run();
+}
+
+TEST(Spin_runner, peer_close) {
+  asio::io_context io_context;
+  Test_session session(io_context);
+  ASSERT_EQ(session.connection_handler.logins, 1);
+
+  session.loopback.server.end_session();
+  ASSERT_TRUE(
+      session.spin_until([&] { return session.client.has_session_ended(); }));
+  ASSERT_TRUE(session.client_handler.has_session_ended);
+
+  // The end of file is found by a polled read.
+  session.loopback.server.stop();
+  ASSERT_TRUE(session.spin_until(
+      [&] { return !session.connection_handler.disconnects.empty(); }));
+  // Then perhaps failures to reconnect
+  ASSERT_EQ(session.connection_handler.disconnects.front(),
+            Disconnect_reason::peer_closed);
+
+  session.client.stop();
+  io_context.run();
+}
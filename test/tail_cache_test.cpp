@@ -0,0 +1,116 @@
+#include "bc/soup/tail_cache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+namespace {
+
+std::string_view view(const Frame& frame) {
+  return {static_cast<const char*>(frame.data()), frame.size()};
+}
+
+void add(Tail_cache& cache, std::uint64_t sequence_number,
+         std::string_view sv) {
+  cache.add(sequence_number, sv.data(), sv.size());
+}
+
+} // namespace
+
+TEST(Tail_cache, disabled) {
+  Tail_cache cache;
+  add(cache, 1, "The");
+  ASSERT_TRUE(cache.empty());
+  std::vector<Frame> frames;
+  ASSERT_FALSE(cache.get(1, 1, frames));
+  ASSERT_TRUE(frames.empty());
+}
+
+TEST(Tail_cache, get) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test limits
+  Tail_cache cache(3, 1024);
+  add(cache, 1, "The");
+  add(cache, 2, "quick");
+  add(cache, 3, "brown");
+  add(cache, 4, "fox");
+  ASSERT_EQ(cache.size(), 3u);
+  ASSERT_EQ(cache.bytes(), 13u);
+  ASSERT_EQ(cache.first_sequence_number(), 2u);
+
+  std::vector<Frame> frames;
+  ASSERT_FALSE(cache.get(1, 2, frames));
+  ASSERT_FALSE(cache.get(3, 5, frames));
+  ASSERT_FALSE(cache.get(3, 2, frames));
+  ASSERT_TRUE(frames.empty());
+
+  ASSERT_TRUE(cache.get(3, 4, frames));
+  ASSERT_EQ(frames.size(), 2u);
+  ASSERT_EQ(view(frames[0]), "brown");
+  ASSERT_EQ(view(frames[1]), "fox");
+
+  // Held frames outlive their eviction.
+  add(cache, 5, "jumps");
+  add(cache, 6, "over");
+  add(cache, 7, "the");
+  ASSERT_EQ(cache.first_sequence_number(), 5u);
+  ASSERT_EQ(view(frames[0]), "brown");
+  ASSERT_EQ(view(frames[1]), "fox");
+}
+
+TEST(Tail_cache, byte_limit) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test limits
+  Tail_cache cache(100, 8);
+  add(cache, 1, "The");
+  add(cache, 2, "quick");
+  ASSERT_EQ(cache.size(), 2u);
+  add(cache, 3, "brown");
+  ASSERT_EQ(cache.size(), 1u);
+  ASSERT_EQ(cache.first_sequence_number(), 3u);
+
+  // Too large to keep, so nothing before it is either.
+  add(cache, 4, "something");
+  ASSERT_TRUE(cache.empty());
+  add(cache, 5, "fox");
+  std::vector<Frame> frames;
+  ASSERT_TRUE(cache.get(5, 5, frames));
+  ASSERT_EQ(view(frames[0]), "fox");
+
+  cache.set_limits(0, 0);
+  ASSERT_TRUE(cache.empty());
+}
+
+TEST(Tail_cache, gap) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test limits
+  Tail_cache cache(100, 1024);
+  add(cache, 1, "The");
+  add(cache, 2, "quick");
+  add(cache, 4, "fox");
+  ASSERT_EQ(cache.size(), 1u);
+  ASSERT_EQ(cache.first_sequence_number(), 4u);
+}
+
+TEST(Tail_cache, blocks) {
+  // NOLINTNEXTLINE(*-avoid-magic-numbers): Test limits
+  Tail_cache cache(100, 1 << 20);
+  const std::string large(Tail_cache::block_size / 2 + 1, 'x');
+  add(cache, 1, large);
+  add(cache, 2, "The");
+  // Starts a block of its own
+  add(cache, 3, large);
+  std::vector<Frame> frames;
+  ASSERT_TRUE(cache.get(1, 3, frames));
+  ASSERT_EQ(view(frames[0]), large);
+  ASSERT_EQ(view(frames[1]), "The");
+  ASSERT_EQ(view(frames[2]), large);
+
+  const std::string larger(Tail_cache::block_size + 1, 'y');
+  add(cache, 4, larger);
+  ASSERT_TRUE(cache.get(4, 4, frames));
+  ASSERT_EQ(view(frames.back()), larger);
+}
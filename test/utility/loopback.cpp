@@ -0,0 +1,96 @@
+#include "loopback.h"
+
+#include "bc/soup/constants.h"
+#include "bc/soup/logical_packets.h"
+
+#include <gtest/gtest.h>
+
+using namespace bc::soup;
+
+Test_server::Test_server(asio::io_context& io_context,
+                         const Timeouts& timeouts)
+    : io_context(&io_context), server(io_context.get_executor()) {
+  EXPECT_FALSE(server.set_session("S"));
+  EXPECT_FALSE(server.set_timeouts(timeouts));
+  const auto added = server.add_acceptor(
+      asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0),
+      acceptor_handler);
+  EXPECT_TRUE(added);
+  if (added)
+    acceptor = *added;
+}
+
+server::Port* Test_server::add_port(std::string_view username,
+                                    server::Port_handler& handler) {
+  const auto port = acceptor->add_port(username, test_password, handler);
+  EXPECT_TRUE(port);
+  return port ? *port : nullptr;
+}
+
+void Test_server::start() {
+  EXPECT_FALSE(server.start());
+  run_until(*io_context, [this] { return acceptor_handler.port != 0; });
+}
+
+Raw_server::Raw_server(asio::io_context& io_context)
+    : io_context(&io_context),
+      acceptor(io_context,
+               asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0)),
+      peer(io_context) {}
+
+void Raw_server::accept_login() {
+  bool accepted = false;
+  acceptor.async_accept(peer, [&](asio::error_code ec) {
+    EXPECT_FALSE(ec) << ec.message();
+    accepted = true;
+  });
+  run_until(*io_context, [&] { return accepted; });
+
+  std::vector<std::byte> request(packet_header_length +
+                                 Login_request_packet::payload_size);
+  bool requested = false;
+  asio::async_read(peer, asio::buffer(request),
+                   [&](asio::error_code ec, std::size_t) {
+                     EXPECT_FALSE(ec) << ec.message();
+                     requested = true;
+                   });
+  run_until(*io_context, [&] { return requested; });
+}
+
+void Raw_server::append(const Write_packet& packet) {
+  const auto* data = static_cast<const std::byte*>(packet.data());
+  // NOLINTNEXTLINE(*-pro-bounds-pointer-arithmetic): Packet bytes
+  bytes.insert(bytes.end(), data, data + packet.size());
+}
+
+void Raw_server::append_login_accepted(std::string_view session,
+                                       std::uint64_t next_sequence_number) {
+  const Login_accepted_packet accepted(session, next_sequence_number);
+  Write_packet packet(Login_accepted_packet::packet_type,
+                      Login_accepted_packet::payload_size);
+  bc::soup::write(accepted, packet.payload_data());
+  append(packet);
+}
+
+void Raw_server::append_message(std::string_view text) {
+  append(Write_packet(Sequenced_data_packet::packet_type, text.data(),
+                      static_cast<std::uint16_t>(text.size())));
+}
+
+void Raw_server::write() {
+  asio::write(peer, asio::buffer(bytes));
+  bytes.clear();
+}
+
+client::Connection* add_line(client::Client& client,
+                             const asio::ip::tcp::endpoint& endpoint,
+                             std::string_view username,
+                             client::Connection_handler& handler) {
+  const auto connection = client.add_connection(endpoint, handler);
+  EXPECT_TRUE(connection);
+  if (!connection)
+    return nullptr;
+  EXPECT_FALSE((*connection)->set_username(username));
+  EXPECT_FALSE((*connection)->set_password(test_password));
+  return *connection;
+}
@@ -0,0 +1,196 @@
+#ifndef TEST_UTILITY_LOOPBACK_H
+#define TEST_UTILITY_LOOPBACK_H
+
+#include "bc/soup/client/client.h"
+#include "bc/soup/client/connection.h"
+#include "bc/soup/client/handler.h"
+#include "bc/soup/rw_packets.h"
+#include "bc/soup/server/acceptor.h"
+#include "bc/soup/server/handler.h"
+#include "bc/soup/server/port.h"
+#include "bc/soup/server/server.h"
+#include "bc/soup/timeouts.h"
+#include "bc/soup/types.h"
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Every port added by a Test_server, and every line added by add_line(),
+// uses this password.
+constexpr std::string_view test_password = "p";
+
+template <typename Predicate>
+void run_until(asio::io_context& io_context, Predicate predicate) {
+  while (!predicate())
+    io_context.run_one();
+}
+
+// Notes the port listened on, once the acceptor is set up.
+class Null_acceptor_handler final
+    : public bc::soup::server::Acceptor_handler {
+public:
+  void listen_setup_failure(asio::error_code, std::string_view) override {}
+  void listen_setup_success(const asio::ip::tcp::endpoint& endpoint) override {
+    port = endpoint.port();
+  }
+
+  void accept_failure(asio::error_code) override {}
+  void accept_success(const asio::ip::tcp::endpoint&,
+                      const asio::ip::tcp::endpoint&) override {}
+
+  void login_request(const bc::soup::Login_request_packet&) override {}
+  void login_failure(bc::soup::Login_reject_reason) override {}
+
+  void debug(std::string_view) override {}
+
+  void transport_error(asio::error_code, std::string_view) override {}
+  void protocol_violation(bc::soup::Packet_error) override {}
+
+  void disconnect(bc::soup::Disconnect_reason) override {}
+
+  unsigned short port = 0;
+};
+
+class Recording_port_handler final : public bc::soup::server::Port_handler {
+public:
+  void login_success(const bc::soup::Login_accepted_packet&) override {
+    ++logins;
+  }
+  void unsequenced_data(const void* data, std::size_t size) override {
+    received.emplace_back(static_cast<const char*>(data), size);
+  }
+  void logout_request() override {}
+  void write_buffer_empty() override {}
+  void debug(std::string_view) override {}
+  void transport_error(asio::error_code, std::string_view) override {}
+  void protocol_violation(bc::soup::Packet_error) override {}
+  void disconnect(bc::soup::Disconnect_reason reason) override {
+    disconnects.push_back(reason);
+  }
+
+  int logins = 0;
+  std::vector<std::string> received;
+  std::vector<bc::soup::Disconnect_reason> disconnects;
+};
+
+class Recording_client_handler final : public bc::soup::client::Client_handler {
+public:
+  void sequenced_data(std::uint64_t sequence_number, const void* data,
+                      std::size_t size) override {
+    sequence_numbers.push_back(sequence_number);
+    messages.emplace_back(static_cast<const char*>(data), size);
+  }
+  void end_of_session() override { has_session_ended = true; }
+
+  std::vector<std::uint64_t> sequence_numbers;
+  std::vector<std::string> messages;
+  bool has_session_ended = false;
+};
+
+class Recording_connection_handler final
+    : public bc::soup::client::Connection_handler {
+public:
+  void connecting(const asio::ip::tcp::endpoint&) override {}
+  void connect_failure(asio::error_code, std::string_view) override {}
+  void connect_success(const asio::ip::tcp::endpoint&,
+                       const asio::ip::tcp::endpoint& remote) override {
+    remote_ports.push_back(remote.port());
+  }
+
+  void logging_in(const bc::soup::Login_request_packet&) override {}
+  void login_failure(bc::soup::Login_reject_reason) override {}
+  void login_success(const bc::soup::Login_accepted_packet&) override {
+    ++logins;
+  }
+
+  void write_buffer_empty() override {}
+
+  void debug(std::string_view) override {}
+
+  void transport_error(asio::error_code, std::string_view) override {}
+  void protocol_violation(bc::soup::Packet_error) override {}
+
+  void disconnect(bc::soup::Disconnect_reason reason) override {
+    disconnects.push_back(reason);
+  }
+  void reconnect_scheduled(std::chrono::milliseconds delay) override {
+    reconnects.push_back(delay);
+  }
+
+  std::vector<unsigned short> remote_ports;
+  int logins = 0;
+  std::vector<bc::soup::Disconnect_reason> disconnects;
+  std::vector<std::chrono::milliseconds> reconnects;
+};
+
+// A server for session "S" with one acceptor on a loopback port chosen by
+// the system, to which ports are added before start().
+struct Test_server {
+  explicit Test_server(
+      asio::io_context&,
+      const bc::soup::Timeouts& = bc::soup::Timeouts::server());
+
+  Test_server(const Test_server&) = delete;
+  Test_server& operator=(const Test_server&) = delete;
+
+  Test_server(Test_server&&) = delete;
+  Test_server& operator=(Test_server&&) = delete;
+
+  bc::soup::server::Port* add_port(std::string_view,
+                                   bc::soup::server::Port_handler&);
+
+  // Runs the io_context until the acceptor is listening.
+  void start();
+
+  asio::ip::tcp::endpoint endpoint() const {
+    return {asio::ip::address_v4::loopback(), acceptor_handler.port};
+  }
+
+  asio::io_context* io_context = nullptr;
+  Null_acceptor_handler acceptor_handler;
+  bc::soup::server::Server server;
+  bc::soup::server::Acceptor* acceptor = nullptr;
+};
+
+// The server's end of a connection written by hand, for what a server would
+// not send or would send in pieces. What is appended is written at once.
+struct Raw_server {
+  explicit Raw_server(asio::io_context&);
+
+  Raw_server(const Raw_server&) = delete;
+  Raw_server& operator=(const Raw_server&) = delete;
+
+  Raw_server(Raw_server&&) = delete;
+  Raw_server& operator=(Raw_server&&) = delete;
+
+  asio::ip::tcp::endpoint endpoint() const {
+    return acceptor.local_endpoint();
+  }
+
+  // Runs the io_context until a client has connected and sent its login
+  // request, which is discarded.
+  void accept_login();
+
+  void append(const bc::soup::Write_packet&);
+  void append_login_accepted(std::string_view, std::uint64_t);
+  void append_message(std::string_view);
+  void write();
+
+  asio::io_context* io_context = nullptr;
+  asio::ip::tcp::acceptor acceptor;
+  asio::ip::tcp::socket peer;
+  std::vector<std::byte> bytes;
+};
+
+// A line to the endpoint, logging in as the user with test_password
+bc::soup::client::Connection*
+add_line(bc::soup::client::Client&, const asio::ip::tcp::endpoint&,
+         std::string_view, bc::soup::client::Connection_handler&);
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "bc/soup/error.h"
 
+#include <chrono>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -85,3 +86,32 @@ TEST(validate, validate_session) {
   ASSERT_EQ(validate_session("a!b"), Error::invalid_session);
   ASSERT_EQ(validate_session("a b"), Error::invalid_session);
 }
+
+TEST(validate, validate_timeouts) {
+  using namespace std::chrono_literals;
+  ASSERT_FALSE(validate_timeouts(Timeouts::server()));
+  ASSERT_FALSE(validate_timeouts(Timeouts::client()));
+  ASSERT_FALSE(validate_timeouts({.heartbeat_period = 10ms,
+                                  .heartbeat_timeout = 10ms,
+                                  .login_timeout = 1ms}));
+  ASSERT_EQ(validate_timeouts({.heartbeat_period = 0ms}),
+            Error::invalid_timeouts);
+  ASSERT_EQ(validate_timeouts({.heartbeat_period = 10ms,
+                               .heartbeat_timeout = 9ms}),
+            Error::invalid_timeouts);
+  ASSERT_EQ(validate_timeouts({.login_timeout = -1ms}),
+            Error::invalid_timeouts);
+}
+
+TEST(validate, validate_reconnect_policy) {
+  using namespace std::chrono_literals;
+  ASSERT_FALSE(validate_reconnect_policy({}));
+  ASSERT_FALSE(validate_reconnect_policy(
+      {.initial_delay = 1ms, .max_delay = 1ms, .multiplier = 1}));
+  ASSERT_EQ(validate_reconnect_policy({.initial_delay = 0ms}),
+            Error::invalid_reconnect_policy);
+  ASSERT_EQ(validate_reconnect_policy({.initial_delay = 2ms, .max_delay = 1ms}),
+            Error::invalid_reconnect_policy);
+  ASSERT_EQ(validate_reconnect_policy({.multiplier = 0}),
+            Error::invalid_reconnect_policy);
+}